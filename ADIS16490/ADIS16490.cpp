@@ -32,6 +32,9 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "ADIS16490.h"
+#ifdef ADIS16490_USE_CMSIS_DSP
+#include <arm_math.h>
+#endif
 
 ////////////////////////////////////////////////////////////////////////////
 // Constructor with configurable CS, DR, and RST
@@ -40,52 +43,212 @@
 // DR - DR output pin for data ready
 // RST - Hardware reset pin
 ////////////////////////////////////////////////////////////////////////////
+#ifdef ARDUINO
 ADIS16490::ADIS16490(int CS, int DR, int RST) {
-  _CS = CS;
-  _DR = DR;
-  _RST = RST;
-// Initialize SPI
-  SPI.begin();
+  _bus = new ADIS16490_TeensyBus(CS, DR, RST);
+  _ownsBus = true;
+// Initialize SPI and set default pin states
+  _bus->begin();
 // Configure SPI controller
   configSPI();
-// Set default pin states
-  pinMode(_CS, OUTPUT); // Set CS pin to be an output
-  pinMode(_DR, INPUT); // Set DR pin to be an input
-  pinMode(_RST, OUTPUT); // Set RST pin to be an output
-  digitalWrite(_CS, HIGH); // Initialize CS pin to be high
-  digitalWrite(_RST, HIGH); // Initialize RST pin to be high
 }
- 
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor with a caller-provided bus
+////////////////////////////////////////////////////////////////////////////
+// bus - SPI/GPIO interface, e.g. ADIS16490_Sim for host builds
+////////////////////////////////////////////////////////////////////////////
+ADIS16490::ADIS16490(ADIS16490_Bus &bus) {
+  _bus = &bus;
+  _ownsBus = false;
+// Initialize SPI and set default pin states
+  _bus->begin();
+// Configure SPI controller
+  configSPI();
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Destructor
 ////////////////////////////////////////////////////////////////////////////
 ADIS16490::~ADIS16490() {
   // Close SPI bus
-  SPI.end();
+  _bus->end();
+  if (_ownsBus)
+    delete _bus;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 // Performs a hardware reset by setting _RST pin low for delay (in ms).
 ////////////////////////////////////////////////////////////////////////////
 int ADIS16490::resetDUT(uint8_t ms) {
-  digitalWrite(_RST, LOW);
-  delayMicroseconds(500);
-  digitalWrite(_RST, HIGH);
-  delay(ms);
+  _bus->writeReset(0);
+  _bus->delayMicros(500);
+  _bus->writeReset(1);
+  _bus->delayMillis(ms);
+  currentPage = 0x00;
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Sets the stall timing policy used between SPI frames.
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// policy - minimum CS high times and whether they are measured
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::setStallPolicy(const ADIS16490_StallPolicy &policy) {
+  _stallPolicy = policy;
   return(1);
 }
 
+////////////////////////////////////////////////////////////////////////////
+// Waits until the minimum stall time since the previous frame has passed,
+// selects the SCLK rate, then asserts CS. With a measured policy only the
+// time remaining since CS was released is waited, so time spent decoding
+// or in the caller counts towards the stall.
+////////////////////////////////////////////////////////////////////////////
+// burst - true to use the burst clock instead of the register clock
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490::beginFrame(bool burst) {
+  useClock(burst ? _clocks.burstClock : _clocks.regClock);
+  uint32_t stallCycles = (_stallPolicy.stall * _bus->cyclesPerMicro() + 999) / 1000;
+  if (_stallPolicy.measured) {
+    uint32_t elapsed = _bus->cycleCount() - _lastDeselect;
+    if (elapsed < stallCycles)
+      _bus->delayCycles(stallCycles - elapsed);
+  }
+  _bus->select();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Releases CS and records when the frame ended. With a fixed policy the
+// full stall time is waited here.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490::endFrame() {
+  _bus->deselect();
+  _lastDeselect = _bus->cycleCount();
+  if (!_stallPolicy.measured)
+    _bus->delayCycles((_stallPolicy.stall * _bus->cyclesPerMicro() + 999) / 1000);
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Sets SPI bit order, clock divider, and data mode. This function is useful
 // when there are multiple SPI devices using different settings.
 // Returns 1 when complete.
 ////////////////////////////////////////////////////////////////////////////
 int ADIS16490::configSPI() {
-  SPISettings IMUSettings(2000000, MSBFIRST, SPI_MODE3);
-  SPI.beginTransaction(IMUSettings);
+  _bus->configure(_clocks.regClock);
+  _activeClock = _clocks.regClock;
   return(1);
 }
 
+////////////////////////////////////////////////////////////////////////////
+// Sets the SCLK rates used for register access and for burst reads, e.g.
+// values previously found by autoTuneClocks().
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// clocks - register and burst SCLK rates in Hz
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::setClocks(const ADIS16490_ClockConfig &clocks) {
+  _clocks = clocks;
+  return configSPI();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Trial reads for autoTuneClocks(): PROD_ID must read back correctly, and
+// a burst frame must pass the checksum and not be all zeros
+////////////////////////////////////////////////////////////////////////////
+static bool tuneRegGood(ADIS16490 &imu) {
+  return (uint16_t)imu.regRead(PROD_ID) == PROD_ID_VALUE;
+}
+
+static bool tuneBurstGood(ADIS16490 &imu) {
+  ADIS16490_Burst burst;
+  bool good = imu.burstRead(burst);
+  uint16_t any = burst.diagStat | burst.temp | burst.dataCount | burst.checksum;
+  for (int i = 0; i < 3; i++)
+    any |= burst.gyro[i] | burst.accel[i];
+  return good && (any != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Steps the register and burst clocks up through a list of rates, keeping
+// the fastest rate at which every trial succeeds: PROD_ID must read back
+// correctly for the register clock, and burst frames must pass the
+// checksum (and not be all zeros) for the burst clock. Stops at the first
+// failing rate. The result is applied and available through clocks() so
+// it can be stored and restored with setClocks() at the next startup.
+// Returns 1 if both clocks work at the lowest rate or above, 0 otherwise
+// (the previous clocks are kept).
+////////////////////////////////////////////////////////////////////////////
+// maxClock - highest SCLK rate to try in Hz
+// trials - reads per rate
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::autoTuneClocks(uint32_t maxClock, uint16_t trials) {
+  return tuneClocks(maxClock, trials, tuneRegGood, tuneBurstGood);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Clock search shared by autoTuneClocks() and the ADIS1649x models, which
+// supply trial reads for their own PROD_ID and burst layout.
+// Returns 1 if both clocks work at the lowest rate or above, 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+// maxClock - highest SCLK rate to try in Hz
+// trials - reads per rate
+// regGood - one register clock trial; true if it read back correctly
+// burstGood - one burst clock trial; true if the frame is valid
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::tuneClocks(uint32_t maxClock, uint16_t trials, bool (*regGood)(ADIS16490 &imu),
+                          bool (*burstGood)(ADIS16490 &imu)) {
+  static const uint32_t rates[] = {
+    1000000, 2000000, 4000000, 6000000, 8000000, 10000000, 12000000, 15000000 };
+  const int rateCount = sizeof(rates) / sizeof(rates[0]);
+  ADIS16490_ClockConfig previous = _clocks;
+  ADIS16490_ClockConfig found = {0, 0};
+
+  // Register clock: PROD_ID read-back
+  for (int r = 0; r < rateCount && rates[r] <= maxClock; r++) {
+    _clocks.regClock = rates[r];
+    configSPI();
+    bool good = true;
+    for (uint16_t t = 0; t < trials && good; t++)
+      good = regGood(*this);
+    if (!good)
+      break;
+    found.regClock = rates[r];
+  }
+
+  // Burst clock: checksum, with register access at the rate just found
+  _clocks.regClock = found.regClock ? found.regClock : previous.regClock;
+  for (int r = 0; r < rateCount && rates[r] <= maxClock && found.regClock; r++) {
+    _clocks.burstClock = rates[r];
+    configSPI();
+    bool good = true;
+    for (uint16_t t = 0; t < trials && good; t++)
+      good = burstGood(*this);
+    if (!good)
+      break;
+    found.burstClock = rates[r];
+  }
+
+  if (found.regClock == 0 || found.burstClock == 0) {
+    setClocks(previous);
+    return(0);
+  }
+  setClocks(found);
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reconfigures the SPI controller only when the rate changes
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490::useClock(uint32_t clock) {
+  if (clock != _activeClock) {
+    _bus->configure(clock);
+    _activeClock = clock;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 // Reads two bytes (one word) in two sequential registers over SPI
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -100,29 +263,24 @@ int16_t ADIS16490::regRead(uint16_t regAddr) {
   // Check whether the sensor is currently on the requested page
   if (currentPage != page) {
     // Write desired page to PAGE_ID register
-    digitalWrite(_CS, LOW); // Set CS low to enable device
-    SPI.transfer(0x80); // Write high byte from low word to SPI bus
-    SPI.transfer(page); // Write low byte from low word to SPI bus
-    digitalWrite(_CS, HIGH); // Set CS high to disable device
+    beginFrame(); // Wait out the stall time and set CS low to enable device
+    _bus->transfer(0x80); // Write high byte from low word to SPI bus
+    _bus->transfer(page); // Write low byte from low word to SPI bus
+    endFrame(); // Set CS high to disable device
     // Write new current page to tracking variable
     currentPage = page; 
-    delayMicroseconds(_stall); // Stall time delay
   }
 
   // Write desired register address
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  SPI.transfer(address); // Write address over SPI bus
-  SPI.transfer(0x00); // Write 0x00 to the SPI bus fill the 16 bit transaction requirement
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
-
-  delayMicroseconds(_stall); // Stall time delay
+  beginFrame(); // Wait out the stall time and set CS low to enable device
+  _bus->transfer(address); // Write address over SPI bus
+  _bus->transfer(0x00); // Write 0x00 to the SPI bus fill the 16 bit transaction requirement
+  endFrame(); // Set CS high to disable device
 
   // Read data from requested register
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  uint16_t _dataOut = (SPI.transfer(0x00) << 8) | (SPI.transfer(0x00) & 0xFF); // Concatenate upper and lower bytes
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
-
-  delayMicroseconds(_stall); // Stall time delay
+  beginFrame(); // Wait out the stall time and set CS low to enable device
+  uint16_t _dataOut = (_bus->transfer(0x00) << 8) | (_bus->transfer(0x00) & 0xFF); // Concatenate upper and lower bytes
+  endFrame(); // Set CS high to disable device
 
   // Shift MSB data left by 8 bits, mask LSB data with 0xFF, and OR both bits.
 
@@ -144,13 +302,12 @@ int ADIS16490::regWrite(uint16_t regAddr, int16_t regData) {
   // Check whether the sensor is currently on the requested page
   if (currentPage != page) {
     // Write desired page to PAGE_ID register
-    digitalWrite(_CS, LOW); // Set CS low to enable device
-    SPI.transfer(0x80); // Write high byte from low word to SPI bus
-    SPI.transfer(page); // Write low byte from low word to SPI bus
-    digitalWrite(_CS, HIGH); // Set CS high to disable device
+    beginFrame(); // Wait out the stall time and set CS low to enable device
+    _bus->transfer(0x80); // Write high byte from low word to SPI bus
+    _bus->transfer(page); // Write low byte from low word to SPI bus
+    endFrame(); // Set CS high to disable device
     // Write new current page to tracking variable
     currentPage = page; 
-    delayMicroseconds(_stall); // Stall time delay
   }
 
   // Sanity-check address and register data
@@ -159,140 +316,550 @@ int ADIS16490::regWrite(uint16_t regAddr, int16_t regData) {
   uint16_t highWord = ((addr | 0x100) | ((regData >> 8) & 0xFF)); // OR Register address with data and increment address
 
   // Write highWord to SPI bus
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  SPI.transfer(lowWord >> 8); // Write high byte from low word to SPI bus
-  SPI.transfer(lowWord & 0xFF); // Write low byte from low word to SPI bus
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
-
-  delayMicroseconds(_stall); // Stall time delay
+  beginFrame(); // Wait out the stall time and set CS low to enable device
+  _bus->transfer(lowWord >> 8); // Write high byte from low word to SPI bus
+  _bus->transfer(lowWord & 0xFF); // Write low byte from low word to SPI bus
+  endFrame(); // Set CS high to disable device
 
   // Write lowWord to SPI bus
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  SPI.transfer(highWord >> 8); // Write high byte from high word to SPI bus
-  SPI.transfer(highWord & 0xFF); // Write low byte from high word to SPI bus
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+  beginFrame(); // Wait out the stall time and set CS low to enable device
+  _bus->transfer(highWord >> 8); // Write high byte from high word to SPI bus
+  _bus->transfer(highWord & 0xFF); // Write low byte from high word to SPI bus
+  endFrame(); // Set CS high to disable device
+
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Sends one 16-bit frame.
+// Returns the word clocked in during the frame, i.e. the response to the
+// previous frame.
+////////////////////////////////////////////////////////////////////////////
+// word - command word (address/data)
+////////////////////////////////////////////////////////////////////////////
+uint16_t ADIS16490::frame(uint16_t word) {
+  beginFrame(); // Wait out the stall time and set CS low to enable device
+  uint8_t msb = _bus->transfer(word >> 8); // Write high byte to SPI bus
+  uint8_t lsb = _bus->transfer(word & 0xFF); // Write low byte to SPI bus
+  endFrame(); // Set CS high to disable device
+  return (msb << 8) | lsb;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads count registers in the given order. Each frame sends the next
+// address while clocking in the data for the previous one, and a PAGE_ID
+// write also collects pending data, so count reads cost count + 1 frames
+// plus one frame per page change.
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// regAddrs - addresses of the registers to be read (any page)
+// regData - signed 16 bit results, one per address
+// count - number of registers
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::regReadMany(const uint16_t *regAddrs, int16_t *regData, size_t count) {
+  int16_t *pending = 0; // Read whose data arrives in the next frame
+  uint32_t start = _bus->microsNow();
+  _lastTransfer.frames = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    uint8_t page = (regAddrs[i] >> 8) & 0xFF;
+    uint8_t address = regAddrs[i] & 0x7F;
+
+    // Check whether the sensor is currently on the requested page
+    if (currentPage != page) {
+      uint16_t word = frame(0x8000 | page); // Write desired page to PAGE_ID register
+      if (pending)
+        *pending = word;
+      pending = 0;
+      currentPage = page;
+      _lastTransfer.frames++;
+    }
+
+    uint16_t word = frame(address << 8);
+    if (pending)
+      *pending = word;
+    pending = &regData[i];
+    _lastTransfer.frames++;
+  }
+
+  // Collect the last register with a dummy read
+  if (pending) {
+    *pending = frame(0x0000);
+    _lastTransfer.frames++;
+  }
+
+  _lastTransfer.bytes = _lastTransfer.frames * 2;
+  _lastTransfer.micros = _bus->microsNow() - start;
+
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Executes a list of register reads and writes with the minimum number of
+// PAGE_ID writes. Within each run of operations delimited by
+// REG_OP_BARRIER, operations are grouped by page (the current page first,
+// then in order of first use) while keeping their relative order within a
+// page. Reads are chained: the data for each read is collected by the
+// following frame, whatever it is, so a read costs one frame plus one
+// trailing frame for the whole batch. A write costs two frames, or one
+// with REG_OP_BYTE.
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// ops - operations; read results are stored in ops[i].data
+// count - number of operations
+// stats - optional frame counts before and after optimization
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::regBatch(ADIS16490_RegOp *ops, size_t count, ADIS16490_BatchStats *stats) {
+  int16_t *pending = 0; // Read whose data arrives in the next frame
+  uint16_t frames = 0;
+  uint16_t pageSwitches = 0;
+  uint16_t naive = 0;
+  int naivePage = currentPage;
+
+  // Frames the same sequence would cost through regRead()/regWrite()
+  for (size_t i = 0; i < count; i++) {
+    int page = (ops[i].addr >> 8) & 0xFF;
+    if (page != naivePage)
+      naive++;
+    naivePage = page;
+    naive += (ops[i].flags & REG_OP_BYTE) ? 1 : 2;
+  }
 
-  delayMicroseconds(_stall); // Stall time delay
+  size_t start = 0;
+  while (start < count) {
+    // Find the end of this reorderable run
+    size_t end = start + 1;
+    while (end < count && !(ops[end].flags & REG_OP_BARRIER))
+      end++;
 
+    // Visit pages: the page the run starts on first, then the others in
+    // order of first use
+    int startPage = currentPage;
+    for (size_t k = 0; k <= end - start; k++) {
+      int page = startPage;
+      if (k > 0) {
+        page = (ops[start + k - 1].addr >> 8) & 0xFF;
+        bool seen = (page == startPage);
+        for (size_t j = start; j < start + k - 1 && !seen; j++)
+          seen = (((ops[j].addr >> 8) & 0xFF) == page);
+        if (seen)
+          continue;
+      }
+
+      for (size_t i = start; i < end; i++) {
+        if (((ops[i].addr >> 8) & 0xFF) != page)
+          continue;
+        uint8_t address = ops[i].addr & 0x7F;
+
+        if (currentPage != page) {
+          // Write desired page to PAGE_ID register, collecting any pending read
+          uint16_t word = frame(0x8000 | page);
+          if (pending)
+            *pending = word;
+          pending = 0;
+          currentPage = page;
+          frames++;
+          pageSwitches++;
+        }
+
+        if (ops[i].flags & REG_OP_BYTE) {
+          uint16_t word = frame(((address | 0x80) << 8) | (ops[i].data & 0xFF));
+          if (pending)
+            *pending = word;
+          pending = 0;
+          frames++;
+        }
+        else if (ops[i].flags & REG_OP_WRITE) {
+          uint16_t addr = (address | 0x80) << 8;
+          uint16_t word = frame(addr | (ops[i].data & 0xFF));
+          if (pending)
+            *pending = word;
+          pending = 0;
+          frame((addr | 0x100) | ((ops[i].data >> 8) & 0xFF));
+          frames += 2;
+        }
+        else {
+          uint16_t word = frame(address << 8);
+          if (pending)
+            *pending = word;
+          pending = &ops[i].data;
+          frames++;
+        }
+      }
+    }
+    start = end;
+  }
+
+  // Collect the last read with a dummy read frame
+  if (pending) {
+    *pending = frame(0x0000);
+    frames++;
+  }
+
+  if (stats) {
+    stats->naiveFrames = naive;
+    stats->frames = frames;
+    stats->pageSwitches = pageSwitches;
+  }
   return(1);
 }
 
 ////////////////////////////////////////////////////////////////////////////
-// Reads a fixed set of registers from the sensor.
-// Returns a pointer to an array of sensor data. 
+// Writes FNCTIO_CTRL and SYNC_SCALE for the requested sample clock source
+// and data ready output, then reads both back. The alarm indicator bits of
+// FNCTIO_CTRL are preserved.
+// Returns 1 when the readback matches, 0 if the configuration is invalid
+// (sync input and data ready on the same line) or was not accepted.
 ////////////////////////////////////////////////////////////////////////////
-// No inputs required.
+// config - sample clock and data ready configuration
 ////////////////////////////////////////////////////////////////////////////
-int16_t *ADIS16490::sensorRead(void) {
-  // Set up temporary variables
-  uint8_t sensorbyte[18];
-  static int16_t sensorwords[9];
+int ADIS16490::setSync(const ADIS16490_SyncConfig &config) {
+  if (config.mode != SYNC_INTERNAL && (config.syncLine & 0x03) == (config.dataReadyLine & 0x03))
+    return(0);
+  uint16_t fnctio = (uint16_t)regRead(FNCTIO_CTRL) & ~FNCTIO_SYNC_FIELDS;
+  fnctio |= (config.dataReadyLine & 0x03) | FNCTIO_DR_ENABLE;
+  if (config.dataReadyHigh)
+    fnctio |= FNCTIO_DR_POLARITY;
+  if (config.mode != SYNC_INTERNAL) {
+    fnctio |= ((config.syncLine & 0x03) << 4) | FNCTIO_SYNC_ENABLE;
+    if (config.syncRising)
+      fnctio |= FNCTIO_SYNC_RISING;
+    if (config.mode == SYNC_SCALED)
+      fnctio |= FNCTIO_SYNC_SCALED;
+  }
+
+  // SYNC_SCALE goes first so scaled mode starts with the new factor
+  ADIS16490_RegOp ops[] = {
+    {SYNC_SCALE, (int16_t)config.scale, REG_OP_WRITE},
+    {FNCTIO_CTRL, (int16_t)fnctio, REG_OP_WRITE},
+    {SYNC_SCALE, 0, REG_OP_READ | REG_OP_BARRIER},
+    {FNCTIO_CTRL, 0, REG_OP_READ} };
+  regBatch(ops, 4);
+  return((uint16_t)ops[2].data == config.scale && (uint16_t)ops[3].data == fnctio);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Decodes FNCTIO_CTRL and SYNC_SCALE.
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// config - receives the current configuration
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::getSync(ADIS16490_SyncConfig &config) {
+  ADIS16490_RegOp ops[] = {
+    {FNCTIO_CTRL, 0, REG_OP_READ},
+    {SYNC_SCALE, 0, REG_OP_READ} };
+  regBatch(ops, 2);
+  uint16_t fnctio = (uint16_t)ops[0].data;
+  if (!(fnctio & FNCTIO_SYNC_ENABLE))
+    config.mode = SYNC_INTERNAL;
+  else
+    config.mode = (fnctio & FNCTIO_SYNC_SCALED) ? SYNC_SCALED : SYNC_DIRECT;
+  config.syncLine = (fnctio & FNCTIO_SYNC_LINE) >> 4;
+  config.syncRising = (fnctio & FNCTIO_SYNC_RISING) != 0;
+  config.scale = (uint16_t)ops[1].data;
+  config.dataReadyLine = fnctio & FNCTIO_DR_LINE;
+  config.dataReadyHigh = (fnctio & FNCTIO_DR_POLARITY) != 0;
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads a fixed set of registers from the sensor (DIAG_STS, gyro, accel,
+// TEMP_OUT, and DATA_CNT) in one chained sequence into caller-provided
+// storage. Each frame carries the next address while returning the
+// previous one, so nine words cost ten frames.
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// sample - destination, e.g. a ring buffer slot
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::sensorRead(ADIS16490_Sample &sample) {
+  // Registers in read order
+  static const uint8_t sensorAddr[9] = {
+    DIAG_STS, X_GYRO_OUT, Y_GYRO_OUT, Z_GYRO_OUT, X_ACCL_OUT,
+    Y_ACCL_OUT, Z_ACCL_OUT, TEMP_OUT, DATA_CNT };
+  uint16_t sensorwords[9];
+  uint32_t start = _bus->microsNow();
+  _lastTransfer.frames = 10;
 
   // Check whether the sensor is currently on the requested page
   if (currentPage != 0x00) {
     // Write desired page to PAGE_ID register
-    digitalWrite(_CS, LOW); // Set CS low to enable device
-    SPI.transfer(0x80); // Write high byte from low word to SPI bus
-    SPI.transfer(0x00); // Write low byte from low word to SPI bus
-    digitalWrite(_CS, HIGH); // Set CS high to disable device
+    beginFrame(); // Wait out the stall time and set CS low to enable device
+    _bus->transfer(0x80); // Write high byte from low word to SPI bus
+    _bus->transfer(0x00); // Write low byte from low word to SPI bus
+    endFrame(); // Set CS high to disable device
     // Write new current page to tracking variable
     currentPage = 0x00; 
-    delayMicroseconds(10); // Stall time delay
+    _lastTransfer.frames++;
   }
 
   // Write initial register address and discard erroneous data
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  SPI.transfer(DIAG_STS); // Write address over SPI bus
-  SPI.transfer(0x00); // Write 0x00 to the SPI bus to complete word
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+  beginFrame(); // Wait out the stall time and set CS low to enable device
+  _bus->transfer(sensorAddr[0]); // Write address over SPI bus
+  _bus->transfer(0x00); // Write 0x00 to the SPI bus to complete word
+  endFrame(); // Set CS high to disable device
+
+  // Read each register while sending the next address in the same frame
+  for (int i = 0; i < 9; i++) {
+    uint8_t next = (i < 8) ? sensorAddr[i + 1] : 0x00; // Dummy address after the last word
+    beginFrame(); // Wait out the stall time and set CS low to enable device
+    uint8_t msb = _bus->transfer(next);
+    uint8_t lsb = _bus->transfer(0x00);
+    endFrame(); // Set CS high to disable device
+    sensorwords[i] = (msb << 8) | lsb;
+  }
 
-  delayMicroseconds(10); // Stall time delay
+  sample.timestamp = start;
+  sample.status = sensorwords[0];
+  for (int i = 0; i < 3; i++) {
+    sample.gyro[i] = sensorwords[1 + i];
+    sample.accel[i] = sensorwords[4 + i];
+  }
+  sample.temp = sensorwords[7];
+  sample.dataCount = sensorwords[8];
+  sample.reserved = 0;
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[0] = SPI.transfer(ALM_STS); // Send next address and place DIAG_STS MSB into variable
-  sensorbyte[1] = SPI.transfer(0x00); // Complete word and place DIAG_STS LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+  _lastTransfer.bytes = _lastTransfer.frames * 2;
+  _lastTransfer.micros = _bus->microsNow() - start;
 
-  delayMicroseconds(10); // Stall time delay
+  return(1);
+}
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[2] = SPI.transfer(X_GYRO_OUT); // Send next address and place ALM_STS MSB into variable
-  sensorbyte[3] = SPI.transfer(0x00); // Complete word and place ALM_STS LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+////////////////////////////////////////////////////////////////////////////
+// Reads the burst frame (DIAG_STS, gyro, accel, TEMP_OUT, DATA_CNT, and
+// CHECKSUM) using one CS assertion and one buffer transfer.
+// Returns 1 if the checksum matches, 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+// data - decoded burst frame
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::burstRead(ADIS16490_Burst &data) {
+  _burstStart = _bus->microsNow();
+  burstPage();
 
-  delayMicroseconds(10); // Stall time delay
+  // Send burst command and clock out the full response in the same frame
+  beginFrame(true); // Wait out the stall time and set CS low to enable device
+  _bus->transfer(_burstTx, _burstRx, sizeof(_burstRx));
+  endFrame(); // Set CS high to disable device
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[4] = SPI.transfer(Y_GYRO_OUT); // Send next address and place X_GYRO_OUT MSB into variable
-  sensorbyte[5] = SPI.transfer(0x00); // Complete word and place X_GYRO_OUT LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+  return burstDecode(_burstRx, data);
+}
 
-  delayMicroseconds(10); // Stall time delay
+////////////////////////////////////////////////////////////////////////////
+// Reads the burst frame straight into a sample record.
+// Returns 1 if the checksum matches, 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+// sample - destination, e.g. a ring buffer slot
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::burstRead(ADIS16490_Sample &sample) {
+  ADIS16490_Burst data;
+  int good = burstRead(data);
+  burstSample(data, _burstStart, sample);
+  return good;
+}
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[6] = SPI.transfer(Z_GYRO_OUT); // Send next address and place Y_GYRO_OUT MSB into variable
-  sensorbyte[7] = SPI.transfer(0x00); // Complete word and place Y_GYRO_OUT LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+////////////////////////////////////////////////////////////////////////////
+// Starts a burst read without waiting for the transfer. The bus calls
+// done(context) when the last byte has been clocked, typically from a DMA
+// interrupt; burstFinish() must then be called to release CS.
+// Returns 1 when the transfer has been started.
+////////////////////////////////////////////////////////////////////////////
+// done - completion callback
+// context - passed through to done
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::burstStart(void (*done)(void *context), void *context) {
+  _burstStart = _bus->microsNow();
+  burstPage();
 
-  delayMicroseconds(10); // Stall time delay
+  beginFrame(true); // Wait out the stall time and set CS low to enable device
+  _bus->transferAsync(_burstTx, _burstRx, sizeof(_burstRx), done, context);
+  return(1);
+}
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[8] = SPI.transfer(X_ACCL_OUT); // Send next address and place Z_GYRO_OUT MSB into variable
-  sensorbyte[9] = SPI.transfer(0x00); // Complete word and place Z_GYRO_OUT LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+////////////////////////////////////////////////////////////////////////////
+// Completes a burst read started by burstStart().
+// Returns 1 if the checksum matches, 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+// data - decoded burst frame
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::burstFinish(ADIS16490_Burst &data) {
+  endFrame(); // Set CS high to disable device
+  return burstDecode(_burstRx, data);
+}
 
-  delayMicroseconds(10); // Stall time delay
+////////////////////////////////////////////////////////////////////////////
+// Completes a burst read started by burstStart() into a sample record
+// stamped with the time burstStart() was called.
+// Returns 1 if the checksum matches, 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+// sample - destination, e.g. a ring buffer slot
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::burstFinish(ADIS16490_Sample &sample) {
+  ADIS16490_Burst data;
+  int good = burstFinish(data);
+  burstSample(data, _burstStart, sample);
+  return good;
+}
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[10] = SPI.transfer(Y_ACCL_OUT); // Send next address and place X_ACCL_OUT MSB into variable
-  sensorbyte[11] = SPI.transfer(0x00); // Complete word and place X_ACCL_OUT LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+////////////////////////////////////////////////////////////////////////////
+// Copies a decoded burst frame into a sample record
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490::burstSample(const ADIS16490_Burst &data, uint32_t timestamp, ADIS16490_Sample &sample) {
+  sample.timestamp = timestamp;
+  sample.status = data.diagStat;
+  for (int i = 0; i < 3; i++) {
+    sample.gyro[i] = data.gyro[i];
+    sample.accel[i] = data.accel[i];
+  }
+  sample.temp = data.temp;
+  sample.dataCount = data.dataCount;
+  sample.reserved = 0;
+}
 
-  delayMicroseconds(10); // Stall time delay
+////////////////////////////////////////////////////////////////////////////
+// Writes PAGE_ID if needed and prepares the burst command buffer
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490::burstPage() {
+  _lastTransfer.frames = 1;
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[12] = SPI.transfer(Z_ACCL_OUT); // Send next address and place Y_ACCL_OUT MSB into variable
-  sensorbyte[13] = SPI.transfer(0x00); // Complete word and place Y_ACCL_OUT LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+  // Check whether the sensor is currently on the requested page
+  if (currentPage != 0x00) {
+    // Write desired page to PAGE_ID register
+    beginFrame(); // Wait out the stall time and set CS low to enable device
+    _bus->transfer(0x80); // Write high byte from low word to SPI bus
+    _bus->transfer(0x00); // Write low byte from low word to SPI bus
+    endFrame(); // Set CS high to disable device
+    // Write new current page to tracking variable
+    currentPage = 0x00;
+    _lastTransfer.frames++;
+  }
 
-  delayMicroseconds(10); // Stall time delay
+  for (unsigned int i = 0; i < sizeof(_burstTx); i++)
+    _burstTx[i] = 0x00;
+  _burstTx[0] = (BURST_READ >> 8) & 0xFF;
+  _burstTx[1] = BURST_READ & 0xFF;
+}
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[14] = SPI.transfer(TEMP_OUT); // Send next address and place Z_ACCL_OUT MSB into variable
-  sensorbyte[15] = SPI.transfer(0x00); // Complete word and place Z_ACCL_OUT LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+////////////////////////////////////////////////////////////////////////////
+// Joins burst bytes into words, records the transfer cost, and verifies
+// the checksum over all but the last word
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::burstDecode(const uint8_t *rxbuf, ADIS16490_Burst &data) {
+  uint16_t burstwords[BURST_WORDS];
+  uint16_t sum = 0;
+  for (int i = 0; i < BURST_WORDS; i++) {
+    burstwords[i] = (rxbuf[2 + 2 * i] << 8) | rxbuf[3 + 2 * i];
+    if (i < BURST_WORDS - 1)
+      sum += rxbuf[2 + 2 * i] + rxbuf[3 + 2 * i];
+  }
 
-  delayMicroseconds(10); // Stall time delay
+  data.diagStat = burstwords[0];
+  data.gyro[0] = burstwords[1];
+  data.gyro[1] = burstwords[2];
+  data.gyro[2] = burstwords[3];
+  data.accel[0] = burstwords[4];
+  data.accel[1] = burstwords[5];
+  data.accel[2] = burstwords[6];
+  data.temp = burstwords[7];
+  data.dataCount = burstwords[8];
+  data.checksum = burstwords[9];
 
-  // Read data from requested register and transfer the next address in the same frame
-  digitalWrite(_CS, LOW); // Set CS low to enable device
-  sensorbyte[16] = SPI.transfer(0x00); // Send dummy address and place TEMP_OUT MSB into variable
-  sensorbyte[17] = SPI.transfer(0x00); // Complete word and place TEMP_OUT LSB into variable
-  digitalWrite(_CS, HIGH); // Set CS high to disable device
+  _lastTransfer.bytes = (_lastTransfer.frames - 1) * 2 + sizeof(_burstRx);
+  _lastTransfer.micros = _bus->microsNow() - _burstStart;
 
-  delayMicroseconds(10); // Stall time delay
+  return (sum == data.checksum) ? 1 : 0;
+}
 
-  // Join bytes into words
-  sensorwords[0] = ((sensorbyte[0] << 8) | (sensorbyte[1] & 0xFF)); //DIAG_STS
-  sensorwords[1] = ((sensorbyte[2] << 8) | (sensorbyte[3] & 0xFF)); //ALM_STS
-  sensorwords[2] = ((sensorbyte[4] << 8) | (sensorbyte[5] & 0xFF)); //XGYRO
-  sensorwords[3] = ((sensorbyte[6] << 8) | (sensorbyte[7] & 0xFF)); //YGYRO
-  sensorwords[4] = ((sensorbyte[8] << 8) | (sensorbyte[9] & 0xFF)); //ZGYRO
-  sensorwords[5] = ((sensorbyte[10] << 8) | (sensorbyte[11] & 0xFF)); //XACCEL
-  sensorwords[6] = ((sensorbyte[12] << 8) | (sensorbyte[13] & 0xFF)); //YACCEL
-  sensorwords[7] = ((sensorbyte[14] << 8) | (sensorbyte[15] & 0xFF)); //ZACCEL
-  sensorwords[8] = ((sensorbyte[16] << 8) | (sensorbyte[17] & 0xFF)); //TEMP
+////////////////////////////////////////////////////////////////////////////
+// Reads X/Y/Z_GYRO_LOW/OUT and X/Y/Z_ACCL_LOW/OUT in one chained sequence,
+// bracketed by DATA_CNT. Each frame carries the next address while
+// returning the previous one, so fourteen words cost fifteen frames.
+// With the 16 us stall this takes longer than the 235 us output period at
+// DEC_RATE = 0, so a LOW/OUT pair or two axes can come from different
+// outputs; DATA_CNT changing across the read shows this.
+// Returns 1 when all words come from one output, 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+// data - 32-bit gyro and accel outputs
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::highResRead(ADIS16490_HighRes &data) {
+  // Registers in read order, LOW word first
+  static const uint8_t highResAddr[14] = {
+    DATA_CNT,
+    X_GYRO_LOW, X_GYRO_OUT, Y_GYRO_LOW, Y_GYRO_OUT, Z_GYRO_LOW, Z_GYRO_OUT,
+    X_ACCL_LOW, X_ACCL_OUT, Y_ACCL_LOW, Y_ACCL_OUT, Z_ACCL_LOW, Z_ACCL_OUT,
+    DATA_CNT };
+  uint16_t highReswords[14];
+  uint32_t start = _bus->microsNow();
+  _lastTransfer.frames = 15;
 
-  return sensorwords;
+  // Check whether the sensor is currently on the requested page
+  if (currentPage != 0x00) {
+    // Write desired page to PAGE_ID register
+    beginFrame(); // Wait out the stall time and set CS low to enable device
+    _bus->transfer(0x80); // Write high byte from low word to SPI bus
+    _bus->transfer(0x00); // Write low byte from low word to SPI bus
+    endFrame(); // Set CS high to disable device
+    // Write new current page to tracking variable
+    currentPage = 0x00;
+    _lastTransfer.frames++;
+  }
+
+  // Write initial register address and discard erroneous data
+  beginFrame(); // Wait out the stall time and set CS low to enable device
+  _bus->transfer(highResAddr[0]); // Write address over SPI bus
+  _bus->transfer(0x00); // Write 0x00 to the SPI bus to complete word
+  endFrame(); // Set CS high to disable device
+
+  // Read each register while sending the next address in the same frame
+  for (int i = 0; i < 14; i++) {
+    uint8_t next = (i < 13) ? highResAddr[i + 1] : 0x00; // Dummy address after the last word
+    beginFrame(); // Wait out the stall time and set CS low to enable device
+    uint8_t msb = _bus->transfer(next);
+    uint8_t lsb = _bus->transfer(0x00);
+    endFrame(); // Set CS high to disable device
+    highReswords[i] = (msb << 8) | lsb;
+  }
 
+  // Join LOW and OUT words
+  for (int i = 0; i < 3; i++) {
+    data.gyro[i] = (int32_t)(((uint32_t)highReswords[2 * i + 2] << 16) | highReswords[2 * i + 1]);
+    data.accel[i] = (int32_t)(((uint32_t)highReswords[2 * i + 8] << 16) | highReswords[2 * i + 7]);
+  }
+  data.dataCount = highReswords[13];
+
+  _lastTransfer.bytes = _lastTransfer.frames * 2;
+  _lastTransfer.micros = _bus->microsNow() - start;
+
+  return(highReswords[0] == highReswords[13]);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads the six delta angle and delta velocity outputs as 32-bit values in
+// one pipelined regReadMany() sequence, bracketed by DATA_CNT (15 frames).
+// With the 16 us stall this takes longer than the 235 us output period at
+// DEC_RATE = 0, so words can come from different outputs; DATA_CNT
+// changing across the read shows this.
+// Returns 1 when all words come from one output, 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+// data - 32-bit delta angle and delta velocity outputs
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490::deltaRead(ADIS16490_Delta &data) {
+  // Registers in read order, LOW word first
+  static const uint16_t deltaAddr[14] = {
+    DATA_CNT,
+    X_DELTANG_LOW, X_DELTANG_OUT, Y_DELTANG_LOW, Y_DELTANG_OUT, Z_DELTANG_LOW, Z_DELTANG_OUT,
+    X_DELTVEL_LOW, X_DELTVEL_OUT, Y_DELTVEL_LOW, Y_DELTVEL_OUT, Z_DELTVEL_LOW, Z_DELTVEL_OUT,
+    DATA_CNT };
+  int16_t deltaWords[14];
+  data.timestamp = _bus->microsNow();
+  regReadMany(deltaAddr, deltaWords, 14);
+
+  // Join LOW and OUT words
+  for (int i = 0; i < 3; i++) {
+    data.angle[i] = (int32_t)(((uint32_t)(uint16_t)deltaWords[2 * i + 2] << 16) | (uint16_t)deltaWords[2 * i + 1]);
+    data.velocity[i] = (int32_t)(((uint32_t)(uint16_t)deltaWords[2 * i + 8] << 16) | (uint16_t)deltaWords[2 * i + 7]);
+  }
+  data.dataCount = deltaWords[13];
+
+  return(deltaWords[0] == deltaWords[13]);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -304,7 +871,7 @@ int16_t *ADIS16490::sensorRead(void) {
 /////////////////////////////////////////////////////////////////////////////////////////
 float ADIS16490::accelScale(int16_t sensorData)
 {
-  float finalData = sensorData * 0.5; // mg/LSB
+  float finalData = sensorData * ACCL_LSB; // mg/LSB
   return finalData;
 }
 
@@ -316,7 +883,33 @@ float ADIS16490::accelScale(int16_t sensorData)
 /////////////////////////////////////////////////////////////////////////////////////////
 float ADIS16490::gyroScale(int16_t sensorData)
 {
-  float finalData = sensorData * 0.005; //degrees/sec/LSB
+  float finalData = sensorData * GYRO_LSB; //degrees/sec/LSB
+  return finalData;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Converts 32-bit accelerometer data output from the highResRead() function and returns
+// acceleration in mg's
+/////////////////////////////////////////////////////////////////////////////////////////
+// sensorData - data output from highResRead()
+// return - (float) signed/scaled accelerometer in mg's
+/////////////////////////////////////////////////////////////////////////////////////////
+float ADIS16490::accelScale32(int32_t sensorData)
+{
+  float finalData = sensorData * (ACCL_LSB / 65536.0f); // mg/LSB
+  return finalData;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Converts 32-bit gyro data output from the highResRead() function and returns gyro rate
+// in deg/sec
+/////////////////////////////////////////////////////////////////////////////////////////////
+// sensorData - data output from highResRead()
+// return - (float) signed/scaled gyro in degrees/sec
+/////////////////////////////////////////////////////////////////////////////////////////
+float ADIS16490::gyroScale32(int32_t sensorData)
+{
+  float finalData = sensorData * (GYRO_LSB / 65536.0f); //degrees/sec/LSB
   return finalData;
 }
 
@@ -329,7 +922,7 @@ float ADIS16490::gyroScale(int16_t sensorData)
 /////////////////////////////////////////////////////////////////////////////////////////
 float ADIS16490::tempScale(int16_t sensorData)
 {
-  float finalData = (sensorData * 0.01429) + 25; // degrees C/LSB
+  float finalData = (sensorData * TEMP_LSB) + TEMP_OFFSET; // degrees C/LSB
   return finalData;
 }
 
@@ -341,7 +934,7 @@ float ADIS16490::tempScale(int16_t sensorData)
 /////////////////////////////////////////////////////////////////////////////////////////
 float ADIS16490::deltaAngleScale(int16_t sensorData)
 {
-  float finalData = sensorData * 0.022; // degrees/LSB
+  float finalData = sensorData * DELTANG_LSB; // degrees/LSB
   return finalData;
 }
 
@@ -353,6 +946,108 @@ float ADIS16490::deltaAngleScale(int16_t sensorData)
 /////////////////////////////////////////////////////////////////////////////////////////
 float ADIS16490::deltaVelocityScale(int16_t sensorData)
 {
-  float finalData = sensorData * 6.104; // mm/sec/LSB
+  float finalData = sensorData * DELTVEL_LSB; // mm/sec/LSB
   return finalData;
 }
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Scales count raw values as scaled = sensorData * gain + offset. With
+// ADIS16490_USE_CMSIS_DSP defined the CMSIS-DSP q15/scale/offset kernels are
+// used; otherwise the plain loop is left for the compiler to vectorize.
+/////////////////////////////////////////////////////////////////////////////////////////
+void ADIS16490::scaleArray(const int16_t *__restrict sensorData, float *__restrict scaled,
+                           size_t count, float gain, float offset)
+{
+#ifdef ADIS16490_USE_CMSIS_DSP
+  // arm_q15_to_float() divides by 32768, fold that back into the gain
+  arm_q15_to_float((q15_t *)sensorData, scaled, count);
+  arm_scale_f32(scaled, gain * 32768.0f, scaled, count);
+  if (offset != 0.0f)
+    arm_offset_f32(scaled, offset, scaled, count);
+#else
+  for (size_t i = 0; i < count; i++)
+    scaled[i] = (float)sensorData[i] * gain + offset;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Array versions of the scaling functions above. Results match the
+// single-value functions.
+/////////////////////////////////////////////////////////////////////////////////////////
+// sensorData - count raw values
+// scaled - count scaled values (may not overlap sensorData)
+// count - number of values
+/////////////////////////////////////////////////////////////////////////////////////////
+void ADIS16490::accelScale(const int16_t *sensorData, float *scaled, size_t count)
+{
+  scaleArray(sensorData, scaled, count, ACCL_LSB, 0.0f);
+}
+
+void ADIS16490::gyroScale(const int16_t *sensorData, float *scaled, size_t count)
+{
+  scaleArray(sensorData, scaled, count, GYRO_LSB, 0.0f);
+}
+
+void ADIS16490::tempScale(const int16_t *sensorData, float *scaled, size_t count)
+{
+  scaleArray(sensorData, scaled, count, TEMP_LSB, TEMP_OFFSET);
+}
+
+void ADIS16490::deltaAngleScale(const int16_t *sensorData, float *scaled, size_t count)
+{
+  scaleArray(sensorData, scaled, count, DELTANG_LSB, 0.0f);
+}
+
+void ADIS16490::deltaVelocityScale(const int16_t *sensorData, float *scaled, size_t count)
+{
+  scaleArray(sensorData, scaled, count, DELTVEL_LSB, 0.0f);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Scales a block of sample records into an array of ADIS16490_Scaled
+/////////////////////////////////////////////////////////////////////////////////////////
+// samples - count records from sensorRead(), burstRead(), or a capture buffer
+// scaled - count scaled records
+// count - number of records
+/////////////////////////////////////////////////////////////////////////////////////////
+void ADIS16490::scaleSamples(const ADIS16490_Sample *__restrict samples,
+                             ADIS16490_Scaled *__restrict scaled, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    const ADIS16490_Sample &in = samples[i];
+    ADIS16490_Scaled &out = scaled[i];
+    out.timestamp = in.timestamp;
+    for (int axis = 0; axis < 3; axis++) {
+      out.gyro[axis] = (float)in.gyro[axis] * GYRO_LSB;
+      out.accel[axis] = (float)in.accel[axis] * ACCL_LSB;
+    }
+    out.temp = (float)in.temp * TEMP_LSB + TEMP_OFFSET;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Scales a block of sample records into per-channel arrays. Each channel is
+// a separate pass so every inner loop is a unit-stride store.
+/////////////////////////////////////////////////////////////////////////////////////////
+// samples - count records from sensorRead(), burstRead(), or a capture buffer
+// scaled - channel arrays, each with room for count values
+// count - number of records
+/////////////////////////////////////////////////////////////////////////////////////////
+void ADIS16490::scaleSamples(const ADIS16490_Sample *__restrict samples,
+                             const ADIS16490_ScaledBlock &scaled, size_t count)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    float *__restrict gyro = scaled.gyro[axis];
+    float *__restrict accel = scaled.accel[axis];
+    if (gyro)
+      for (size_t i = 0; i < count; i++)
+        gyro[i] = (float)samples[i].gyro[axis] * GYRO_LSB;
+    if (accel)
+      for (size_t i = 0; i < count; i++)
+        accel[i] = (float)samples[i].accel[axis] * ACCL_LSB;
+  }
+  float *__restrict temp = scaled.temp;
+  if (temp)
+    for (size_t i = 0; i < count; i++)
+      temp[i] = (float)samples[i].temp * TEMP_LSB + TEMP_OFFSET;
+}
@@ -33,8 +33,7 @@
 
 #ifndef ADIS16490_h
 #define ADIS16490_h
-#include "Arduino.h"
-#include <SPI.h>
+#include "ADIS16490_Bus.h"
 
 // User Register Memory Map Page 0
 #define PAGE_ID       0x0000
@@ -69,6 +68,14 @@
 #define Z_DELTVEL_OUT 0x0056
 #define PROD_ID       0x007E
 
+// PROD_ID contents (16490 decimal)
+#define PROD_ID_VALUE 0x404A
+
+// Burst read command (page 0) and response length in words
+// (DIAG_STS, X/Y/Z_GYRO_OUT, X/Y/Z_ACCL_OUT, TEMP_OUT, DATA_CNT, CHECKSUM)
+#define BURST_READ    0x7C00
+#define BURST_WORDS   10
+
 // User Register Memory Map Page 2
 #define PAGE_ID2      0x0200
 #define X_GYRO_SCALE  0x0204
@@ -124,18 +131,175 @@
 #define CODE_DRVTN_UPR  0x0412
 #define SERIAL_NUM    0x0420
 
-// FIR filter banks are contained on pages 5 ~ 12. Since these banks will
-// likely not be written to individually, I've left it up to the user
-// to iterate through the banks when writing their own coefficients.
+// FIR filter banks A ~ D are contained on pages 5 ~ 12, two pages per
+// bank. Each page holds 60 of the bank's 120 coefficients, starting at
+// 0x08. ADIS16490_FirBank.h uploads whole banks.
+#define FIR_BANKS         4
+#define FIR_TAPS          120
+#define FIR_TAPS_PER_PAGE 60
+#define FIR_PAGE_FIRST    5
+#define FIR_COEF_FIRST    0x08
+
+// FILTR_BNK_0 holds a 3-bit field per axis for X/Y/Z gyro and X/Y accel,
+// FILTR_BNK_1 the Z accel field: bank select in bits [1:0], enable in bit 2
+#define FILTR_BNK_BITS    3
+#define FILTR_BNK_ENABLE  0x04
+
+// Decoded burst read frame
+struct ADIS16490_Burst {
+  uint16_t diagStat;
+  int16_t gyro[3];
+  int16_t accel[3];
+  int16_t temp;
+  uint16_t dataCount;
+  uint16_t checksum;
+};
+
+// Sample record filled by sensorRead() and burstRead(). Fields are ordered
+// so the struct has no internal padding (24 bytes, 4-byte aligned) and can
+// be stored directly in ring buffer slots.
+struct ADIS16490_Sample {
+  uint32_t timestamp; // microsNow() when the read started
+  uint16_t status;    // DIAG_STS
+  uint16_t dataCount; // DATA_CNT
+  int16_t gyro[3];    // X/Y/Z_GYRO_OUT
+  int16_t accel[3];   // X/Y/Z_ACCL_OUT
+  int16_t temp;       // TEMP_OUT
+  uint16_t reserved;  // Pads the record to a multiple of 4 bytes
+};
+
+// Output scale factors. Single precision so the Cortex-M4 FPU never falls
+// back to double arithmetic.
+#define GYRO_LSB     0.005f   // degrees/sec/LSB
+#define ACCL_LSB     0.5f     // mg/LSB
+#define TEMP_LSB     0.01429f // degrees C/LSB
+#define TEMP_OFFSET  25.0f    // degrees C at TEMP_OUT = 0
+#define DELTANG_LSB  0.022f   // degrees/LSB
+#define DELTVEL_LSB  6.104f   // mm/sec/LSB
+
+// Scaled sample, array-of-structures layout. Gyro in degrees/sec, accel in
+// mg, temperature in degrees C.
+struct ADIS16490_Scaled {
+  uint32_t timestamp;
+  float gyro[3];
+  float accel[3];
+  float temp;
+};
+
+// Scaled samples, structure-of-arrays layout. Each pointer is a caller
+// owned channel array with room for the whole block; null channels are
+// skipped.
+struct ADIS16490_ScaledBlock {
+  float *gyro[3];
+  float *accel[3];
+  float *temp;
+};
+
+// Combined *_LOW/*_OUT outputs. Each value is the 32-bit two's complement
+// word (OUT << 16 | LOW), i.e. 16.16 fixed point in units of the 16-bit LSB.
+struct ADIS16490_HighRes {
+  int32_t gyro[3];
+  int32_t accel[3];
+  uint16_t dataCount; // DATA_CNT read after the outputs
+};
+
+// Delta angle and delta velocity accumulated by the sensor over one output
+// period. Each value is the 32-bit word (OUT << 16 | LOW); one LSB of the
+// OUT word is DELTANG_LSB degrees or DELTVEL_LSB mm/sec.
+struct ADIS16490_Delta {
+  uint32_t timestamp;  // microsNow() when the read started
+  uint16_t dataCount;  // DATA_CNT read after the deltas
+  int32_t angle[3];    // X/Y/Z_DELTANG_LOW/OUT
+  int32_t velocity[3]; // X/Y/Z_DELTVEL_LOW/OUT
+};
+
+// FNCTIO_CTRL fields. DIO lines are numbered 0 ~ 3 for DIO1 ~ DIO4.
+#define FNCTIO_DR_LINE      0x0003 // Data ready output line
+#define FNCTIO_DR_POLARITY  0x0004 // 1 = data ready active high
+#define FNCTIO_DR_ENABLE    0x0008
+#define FNCTIO_SYNC_LINE    0x0030 // Sync input line
+#define FNCTIO_SYNC_RISING  0x0040 // 1 = sync on the rising edge
+#define FNCTIO_SYNC_ENABLE  0x0080
+#define FNCTIO_SYNC_SCALED  0x0100 // 1 = scaled sync, 0 = direct sync
+#define FNCTIO_SYNC_FIELDS  0x01FF // Fields owned by setSync(); the alarm bits above are preserved
+
+// Sample clock sources
+#define SYNC_INTERNAL 0 // Internal 4250 Hz sample clock
+#define SYNC_DIRECT   1 // One internal sample per sync input edge
+#define SYNC_SCALED   2 // Sample clock = SYNC_SCALE x sync input rate (e.g. 1 PPS x 4250)
+
+// Sample clock and data ready configuration. The data ready output is
+// also the output clock: wire it to the sync input of other units in
+// SYNC_DIRECT mode to slave them to this one.
+struct ADIS16490_SyncConfig {
+  uint8_t mode;          // SYNC_INTERNAL, SYNC_DIRECT, or SYNC_SCALED
+  uint8_t syncLine;      // Sync input DIO (0 ~ 3)
+  bool syncRising;       // Sync on the rising edge
+  uint16_t scale;        // SYNC_SCALE, internal samples per sync input pulse
+  uint8_t dataReadyLine; // Data ready output DIO (0 ~ 3)
+  bool dataReadyHigh;    // Data ready active high
+};
+
+// Register operation flags for regBatch()
+#define REG_OP_READ    0x00
+#define REG_OP_WRITE   0x01
+#define REG_OP_BARRIER 0x02 // Do not reorder across this operation
+#define REG_OP_BYTE    0x04 // Write only the byte at addr (odd = upper byte), one frame
+
+// One register access in a batch. Reads store their result in data.
+struct ADIS16490_RegOp {
+  uint16_t addr;
+  int16_t data;
+  uint8_t flags;
+};
+
+// Frame counts for a batch
+struct ADIS16490_BatchStats {
+  uint16_t naiveFrames;  // Frames regRead()/regWrite() would use in the given order
+  uint16_t frames;       // Frames actually sent
+  uint16_t pageSwitches; // PAGE_ID writes actually sent
+};
+
+// Datasheet minimum stall time (CS high) between frames, in ns
+#define STALL_NS    16000
+
+// SPI stall timing policy. A measured policy tracks the time since CS was
+// released and waits only for the remainder; a fixed policy always waits
+// the full stall after each frame.
+struct ADIS16490_StallPolicy {
+  uint32_t stall; // Minimum CS high time between frames (ns)
+  bool measured;
+};
+
+// SCLK rates for register access and burst reads (Hz)
+struct ADIS16490_ClockConfig {
+  uint32_t regClock;
+  uint32_t burstClock;
+};
+
+// Default SCLK rate (Hz)
+#define SPI_CLOCK     2000000
+
+// Bus cost of the most recent read
+struct ADIS16490_Transfer {
+  uint16_t frames; // CS assertions
+  uint16_t bytes;  // Bytes on the wire, including command words
+  uint32_t micros; // Elapsed time from first CS assertion to return
+};
 
 // ADIS16490 class definition
 class ADIS16490 {
 
 public:
+#ifdef ARDUINO
   // Constructor with configurable CS, data ready, and HW reset pins
 
   // ADIS16490(int CS, int DR, int RST, int MOSI, int MISO, int CLK);
   ADIS16490(int CS, int DR, int RST);
+#endif
+
+  // Constructor using a caller-provided bus (e.g. ADIS16490_Sim)
+  ADIS16490(ADIS16490_Bus &bus);
 
   // Destructor
   ~ADIS16490();
@@ -146,14 +310,62 @@ public:
   // Sets SPI bit order, clock divider, and data mode
   int configSPI();
 
+  // Sets separate SCLK rates for register access and burst reads
+  int setClocks(const ADIS16490_ClockConfig &clocks);
+  const ADIS16490_ClockConfig &clocks() const { return _clocks; }
+
+  // Finds the fastest error-free register and burst clocks
+  int autoTuneClocks(uint32_t maxClock = 15000000, uint16_t trials = 100);
+
+  // Configures the sample clock source and data ready output
+  int setSync(const ADIS16490_SyncConfig &config);
+
+  // Reads the sample clock and data ready configuration back
+  int getSync(ADIS16490_SyncConfig &config);
+
+  // Sets the stall time between frames
+  int setStallPolicy(const ADIS16490_StallPolicy &policy);
+  const ADIS16490_StallPolicy &stallPolicy() const { return _stallPolicy; }
+
   // Read single register from sensor
   int16_t regRead(uint16_t regAddr);
 
   // Write register
   int regWrite(uint16_t regAddr, int16_t regData);
 
-  // Read a fixed set of sensor data
-  int16_t *sensorRead(void);
+  // Read a fixed set of sensor data into caller-provided storage
+  int sensorRead(ADIS16490_Sample &sample);
+
+  // Read the burst frame in a single CS assertion
+  int burstRead(ADIS16490_Burst &data);
+  int burstRead(ADIS16490_Sample &sample);
+
+  // Split-phase burst read: burstStart() asserts CS and starts a non-blocking
+  // transfer; done(context) runs when it completes, after which burstFinish()
+  // releases CS and decodes the frame
+  int burstStart(void (*done)(void *context), void *context);
+  int burstFinish(ADIS16490_Burst &data);
+  int burstFinish(ADIS16490_Sample &sample);
+
+  // Read all twelve gyro/accel LOW/OUT words as 32-bit values. Returns 0
+  // if a new output was latched during the read; the read spans more than
+  // one output period at DEC_RATE = 0, so use DEC_RATE >= 1 and start it
+  // on data ready.
+  int highResRead(ADIS16490_HighRes &data);
+
+  // Read X/Y/Z delta angle and delta velocity (LOW/OUT) and DATA_CNT.
+  // Returns 0 if a new output was latched during the read; as with
+  // highResRead(), use DEC_RATE >= 1 and start it on data ready.
+  int deltaRead(ADIS16490_Delta &data);
+
+  // Read several registers, pipelining each address with the previous data
+  int regReadMany(const uint16_t *regAddrs, int16_t *regData, size_t count);
+
+  // Run a list of register reads/writes with the fewest page switches
+  int regBatch(ADIS16490_RegOp *ops, size_t count, ADIS16490_BatchStats *stats = 0);
+
+  // Frames, bytes, and time spent by the last sensorRead(), burstRead(), highResRead(), or regReadMany()
+  const ADIS16490_Transfer &lastTransfer() const { return _lastTransfer; }
 
   // Scale accelerator data
   float accelScale(int16_t sensorData);
@@ -161,6 +373,12 @@ public:
   // Scale gyro data
   float gyroScale(int16_t sensorData);
 
+  // Scale 32-bit accelerometer data
+  float accelScale32(int32_t sensorData);
+
+  // Scale 32-bit gyro data
+  float gyroScale32(int32_t sensorData);
+
   // Scale temperature data
   float tempScale(int16_t sensorData);
 
@@ -170,22 +388,81 @@ public:
   // Scale delta velocity
   float deltaVelocityScale(int16_t sensorData);
 
-private:
-  // Chip select pin
-  int _CS;
+  // Scale count raw values in one pass (e.g. a block of one channel)
+  void accelScale(const int16_t *sensorData, float *scaled, size_t count);
+  void gyroScale(const int16_t *sensorData, float *scaled, size_t count);
+  void tempScale(const int16_t *sensorData, float *scaled, size_t count);
+  void deltaAngleScale(const int16_t *sensorData, float *scaled, size_t count);
+  void deltaVelocityScale(const int16_t *sensorData, float *scaled, size_t count);
 
-  // IRQ output pin for data ready
-  int _DR;
+  // Scale a block of sample records into AoS or SoA form
+  void scaleSamples(const ADIS16490_Sample *samples, ADIS16490_Scaled *scaled, size_t count);
+  void scaleSamples(const ADIS16490_Sample *samples, const ADIS16490_ScaledBlock &scaled, size_t count);
 
-  // Hardware reset pin
-  int _RST;
+  // Bus used for all SPI and pin access
+  ADIS16490_Bus *bus() { return _bus; }
 
-  // SPI stall time
-  int _stall = 5;
+protected:
+  // Clock search behind autoTuneClocks(). regGood() and burstGood() make
+  // one trial read at the current clocks and return true if it is correct.
+  int tuneClocks(uint32_t maxClock, uint16_t trials, bool (*regGood)(ADIS16490 &imu),
+                 bool (*burstGood)(ADIS16490 &imu));
+
+  // Scales count raw values as sensorData * gain + offset
+  static void scaleArray(const int16_t *sensorData, float *scaled, size_t count,
+                         float gain, float offset);
+
+  // Waits out the stall time, selects the SCLK rate, and asserts CS
+  void beginFrame(bool burst = false);
+
+  // Reconfigures the SPI controller if the rate differs from the active one
+  void useClock(uint32_t clock);
+
+  // Releases CS and records the frame type and time
+  void endFrame();
+
+  // Sends one 16-bit frame followed by the stall time and returns the
+  // word received during it
+  uint16_t frame(uint16_t word);
+
+  // Switches to page 0 ahead of a burst read
+  void burstPage();
+
+  // Copies a decoded burst frame into a sample record
+  void burstSample(const ADIS16490_Burst &data, uint32_t timestamp, ADIS16490_Sample &sample);
+
+  // Joins burst bytes into words and verifies the checksum
+  int burstDecode(const uint8_t *rxbuf, ADIS16490_Burst &data);
+
+  // SPI and pin interface
+  ADIS16490_Bus *_bus;
+
+  // Set when the bus was allocated by the pin constructor
+  bool _ownsBus;
+
+  // SCLK rates and the rate currently programmed
+  ADIS16490_ClockConfig _clocks = {SPI_CLOCK, SPI_CLOCK};
+  uint32_t _activeClock = 0;
+
+  // SPI stall timing
+  ADIS16490_StallPolicy _stallPolicy = {STALL_NS, true};
+
+  // Cycle count when CS was last released
+  uint32_t _lastDeselect = 0;
 
   // Current page
   int currentPage = 0x00;
 
+  // Bus cost of the most recent read
+  ADIS16490_Transfer _lastTransfer = {0, 0, 0};
+
+  // Burst command and response buffers
+  uint8_t _burstTx[2 + 2 * BURST_WORDS];
+  uint8_t _burstRx[2 + 2 * BURST_WORDS];
+
+  // Time burstStart() was called
+  uint32_t _burstStart = 0;
+
 };
 
 #endif
@@ -0,0 +1,326 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Ahrs.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Mahony and error-state Kalman attitude filters for ADIS16490 samples. See ADIS16490_Ahrs.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Ahrs.h"
+#include <math.h>
+
+// Initial Kalman attitude (rad) and bias (rad/sec) uncertainty
+#define AHRS_P_ATTITUDE 0.1f
+#define AHRS_P_BIAS     0.01f
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// mode - AHRS_MAHONY or AHRS_KALMAN
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_Ahrs::ADIS16490_Ahrs(uint8_t mode) {
+  _mode = mode;
+  _gyroScale = GYRO_LSB * 0.017453293f;
+  float g = 1000.0f / ACCL_LSB;
+  _gravity2 = g * g;
+  setGains(1.0f, 0.3f);
+  setNoise(0.0003f, 0.0001f, 0.05f);
+  setAccelGate(0.1f);
+  reset();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Restarts level with zero bias and the initial covariance
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Ahrs::reset() {
+  _q[0] = 1.0f;
+  _q[1] = _q[2] = _q[3] = 0.0f;
+  for (int i = 0; i < 3; i++)
+    _bias[i] = 0.0f;
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 6; j++)
+      _P[i][j] = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    _P[i][i] = AHRS_P_ATTITUDE * AHRS_P_ATTITUDE;
+    _P[i + 3][i + 3] = AHRS_P_BIAS * AHRS_P_BIAS;
+  }
+  _accelCount = 0;
+  _updates = 0;
+  _rejected = 0;
+}
+
+void ADIS16490_Ahrs::setGains(float kp, float ki) {
+  _kp = kp;
+  _ki = ki;
+}
+
+void ADIS16490_Ahrs::setNoise(float gyroNoise, float biasNoise, float accelNoise, uint8_t accelInterval) {
+  _gyroVar = gyroNoise * gyroNoise;
+  _biasVar = biasNoise * biasNoise;
+  _accelVar = accelNoise * accelNoise;
+  _accelInterval = accelInterval ? accelInterval : 1;
+}
+
+void ADIS16490_Ahrs::setAccelGate(float tolerance) {
+  _gateLow = _gravity2 * (1.0f - tolerance) * (1.0f - tolerance);
+  _gateHigh = _gravity2 * (1.0f + tolerance) * (1.0f + tolerance);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Processes one sample: scales the raw words, corrects the rate with the
+// accelerometer (Mahony) or the bias estimate (Kalman), and advances the
+// quaternion
+////////////////////////////////////////////////////////////////////////////
+// sample - raw sample
+// dt - sample period (sec)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Ahrs::update(const ADIS16490_Sample &sample, float dt) {
+  float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+  float rate[3];
+  for (int i = 0; i < 3; i++)
+    rate[i] = (float)sample.gyro[i] * _gyroScale - _bias[i];
+
+  // Down direction expected from the attitude (third row of the rotation
+  // matrix) and measured by the accelerometer, which reads -g at rest
+  float ax = sample.accel[0], ay = sample.accel[1], az = sample.accel[2];
+  float norm2 = ax * ax + ay * ay + az * az;
+  bool useAccel = norm2 > _gateLow && norm2 < _gateHigh;
+  if (!useAccel)
+    _rejected++;
+  float expected[3] = {2.0f * (x * z - w * y), 2.0f * (y * z + w * x), w * w - x * x - y * y + z * z};
+
+  if (_mode == AHRS_MAHONY) {
+    if (useAccel) {
+      float inv = -1.0f / sqrtf(norm2);
+      float down[3] = {ax * inv, ay * inv, az * inv};
+      // Rotation that moves the expected direction toward the measured one
+      float e[3] = {down[1] * expected[2] - down[2] * expected[1],
+                    down[2] * expected[0] - down[0] * expected[2],
+                    down[0] * expected[1] - down[1] * expected[0]};
+      for (int i = 0; i < 3; i++) {
+        _bias[i] -= _ki * e[i] * dt;
+        rate[i] += _kp * e[i];
+      }
+    }
+  }
+  else {
+    kalmanPropagate(rate, dt);
+    if (useAccel && ++_accelCount >= _accelInterval) {
+      _accelCount = 0;
+      float inv = -1.0f / sqrtf(norm2);
+      float down[3] = {ax * inv, ay * inv, az * inv};
+      kalmanCorrect(down, expected);
+      // The correction changed the attitude and bias
+      w = _q[0];
+      x = _q[1];
+      y = _q[2];
+      z = _q[3];
+    }
+  }
+
+  // q += 0.5 * q * (0, rate) * dt
+  float h = 0.5f * dt;
+  _q[0] = w - h * (x * rate[0] + y * rate[1] + z * rate[2]);
+  _q[1] = x + h * (w * rate[0] + y * rate[2] - z * rate[1]);
+  _q[2] = y + h * (w * rate[1] - x * rate[2] + z * rate[0]);
+  _q[3] = z + h * (w * rate[2] + x * rate[1] - y * rate[0]);
+
+  // One Newton step toward unit length
+  float n = 0.5f * (3.0f - (_q[0] * _q[0] + _q[1] * _q[1] + _q[2] * _q[2] + _q[3] * _q[3]));
+  for (int i = 0; i < 4; i++)
+    _q[i] *= n;
+  _updates++;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// P = F P F' + Q with F = [I - [rate x] dt, -I dt; 0, I]
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Ahrs::kalmanPropagate(const float *rate, float dt) {
+  float F[3][3] = {
+    {1.0f, rate[2] * dt, -rate[1] * dt},
+    {-rate[2] * dt, 1.0f, rate[0] * dt},
+    {rate[1] * dt, -rate[0] * dt, 1.0f} };
+  float A[3][3], B[3][3], C[3][3];
+
+  // Blocks of P: [A B; B' C] with A attitude, C bias
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++) {
+      A[i][j] = _P[i][j];
+      B[i][j] = _P[i][j + 3];
+      C[i][j] = _P[i + 3][j + 3];
+    }
+
+  // FA = F A - B dt, FB = F B - C dt
+  float FA[3][3], FB[3][3];
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++) {
+      float a = 0, b = 0;
+      for (int k = 0; k < 3; k++) {
+        a += F[i][k] * A[k][j];
+        b += F[i][k] * B[k][j];
+      }
+      FA[i][j] = a - B[j][i] * dt;
+      FB[i][j] = b - C[i][j] * dt;
+    }
+
+  // New A = FA F' - FB dt, new B = FB
+  for (int i = 0; i < 3; i++)
+    for (int j = i; j < 3; j++) {
+      float a = 0;
+      for (int k = 0; k < 3; k++)
+        a += FA[i][k] * F[j][k];
+      a -= FB[i][j] * dt;
+      _P[i][j] = _P[j][i] = a;
+    }
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      _P[i][j + 3] = _P[j + 3][i] = FB[i][j];
+
+  for (int i = 0; i < 3; i++) {
+    _P[i][i] += _gyroVar * dt;
+    _P[i + 3][i + 3] += _biasVar * dt;
+  }
+
+  // Heading and the bias about the down axis are unobservable, so their
+  // variance grows without bound and swamps the small observable terms in
+  // single precision. Scaling a row and column together keeps P positive
+  // definite; this only runs once the limit is reached.
+  for (int i = 0; i < 3; i++)
+    if (_P[i][i] > AHRS_P_ATTITUDE * AHRS_P_ATTITUDE) {
+      float scale = AHRS_P_ATTITUDE / sqrtf(_P[i][i]);
+      for (int j = 0; j < 6; j++) {
+        _P[i][j] *= scale;
+        _P[j][i] *= scale;
+      }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Accel measurement update. The measured down direction is
+// expected + [expected x] dtheta, so H = [[expected x], 0].
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Ahrs::kalmanCorrect(const float *down, const float *expected) {
+  float Hx[3][3] = {
+    {0.0f, -expected[2], expected[1]},
+    {expected[2], 0.0f, -expected[0]},
+    {-expected[1], expected[0], 0.0f} };
+
+  // PH' (6x3) and S = H P H' + R (3x3)
+  float PHt[6][3];
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 3; j++) {
+      float s = 0;
+      for (int k = 0; k < 3; k++)
+        s += _P[i][k] * Hx[j][k];
+      PHt[i][j] = s;
+    }
+  float S[3][3];
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++) {
+      float s = 0;
+      for (int k = 0; k < 3; k++)
+        s += Hx[i][k] * PHt[k][j];
+      S[i][j] = s + (i == j ? _accelVar : 0.0f);
+    }
+
+  // S^-1 from the adjugate
+  float Si[3][3];
+  Si[0][0] = S[1][1] * S[2][2] - S[1][2] * S[2][1];
+  Si[0][1] = S[0][2] * S[2][1] - S[0][1] * S[2][2];
+  Si[0][2] = S[0][1] * S[1][2] - S[0][2] * S[1][1];
+  Si[1][0] = S[1][2] * S[2][0] - S[1][0] * S[2][2];
+  Si[1][1] = S[0][0] * S[2][2] - S[0][2] * S[2][0];
+  Si[1][2] = S[0][2] * S[1][0] - S[0][0] * S[1][2];
+  Si[2][0] = S[1][0] * S[2][1] - S[1][1] * S[2][0];
+  Si[2][1] = S[0][1] * S[2][0] - S[0][0] * S[2][1];
+  Si[2][2] = S[0][0] * S[1][1] - S[0][1] * S[1][0];
+  float det = S[0][0] * Si[0][0] + S[0][1] * Si[1][0] + S[0][2] * Si[2][0];
+  if (det <= 0.0f)
+    return;
+  float invDet = 1.0f / det;
+
+  // K = PH' S^-1, dx = K (down - expected)
+  float K[6][3], dx[6];
+  float innovation[3] = {down[0] - expected[0], down[1] - expected[1], down[2] - expected[2]};
+  for (int i = 0; i < 6; i++) {
+    dx[i] = 0;
+    for (int j = 0; j < 3; j++) {
+      float s = 0;
+      for (int k = 0; k < 3; k++)
+        s += PHt[i][k] * Si[k][j];
+      K[i][j] = s * invDet;
+      dx[i] += K[i][j] * innovation[j];
+    }
+  }
+
+  // Joseph form P = (I - KH) P (I - KH)' + K R K', which stays positive
+  // definite in single precision where P -= K H P does not. KH is nonzero
+  // only in the attitude columns.
+  float A[6][6], AP[6][6];
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 6; j++) {
+      float s = (i == j) ? 1.0f : 0.0f;
+      if (j < 3)
+        for (int k = 0; k < 3; k++)
+          s -= K[i][k] * Hx[k][j];
+      A[i][j] = s;
+    }
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 6; j++) {
+      float s = 0;
+      for (int k = 0; k < 6; k++)
+        s += A[i][k] * _P[k][j];
+      AP[i][j] = s;
+    }
+  for (int i = 0; i < 6; i++)
+    for (int j = i; j < 6; j++) {
+      float s = 0;
+      for (int k = 0; k < 6; k++)
+        s += AP[i][k] * A[j][k];
+      for (int k = 0; k < 3; k++)
+        s += K[i][k] * K[j][k] * _accelVar;
+      _P[i][j] = _P[j][i] = s;
+    }
+
+  // Inject the error state: q = q * (1, dtheta / 2), bias += dbias
+  float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+  float hx = 0.5f * dx[0], hy = 0.5f * dx[1], hz = 0.5f * dx[2];
+  _q[0] = w - x * hx - y * hy - z * hz;
+  _q[1] = x + w * hx + y * hz - z * hy;
+  _q[2] = y + w * hy - x * hz + z * hx;
+  _q[3] = z + w * hz + x * hy - y * hx;
+  for (int i = 0; i < 3; i++)
+    _bias[i] += dx[i + 3];
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Converts the attitude quaternion to ZYX Euler angles
+////////////////////////////////////////////////////////////////////////////
+// roll, pitch, yaw - rotation about X, Y, Z (rad)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Ahrs::euler(float &roll, float &pitch, float &yaw) const {
+  float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+  roll = atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y));
+  float s = 2.0f * (w * y - z * x);
+  pitch = asinf(s > 1.0f ? 1.0f : (s < -1.0f ? -1.0f : s));
+  yaw = atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z));
+}
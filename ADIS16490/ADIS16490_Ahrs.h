@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Ahrs.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Incremental attitude (AHRS) filter fed directly from ADIS16490_Sample records. Two estimators
+//  are available:
+//
+//    AHRS_MAHONY  nonlinear complementary filter with proportional and integral gyro correction
+//    AHRS_KALMAN  error-state Kalman filter over attitude error and gyro bias (6 states)
+//
+//  Raw gyro and accel words are scaled with constants computed once at construction. The inner loop
+//  uses no trig: the accelerometer is gated against 1 g on the squared norm, the quaternion is kept
+//  unit length with a Newton step, and the accel normalization is the only square root. The Kalman
+//  filter propagates its covariance every sample, applies the accelerometer update every
+//  accelInterval samples to bound its cost, and uses the Joseph form so the covariance stays
+//  positive definite in single precision.
+//
+//  Attitude is the body to north-east-down quaternion, the same convention as ADIS16490_Strapdown.
+//  Heading is not observable from the accelerometer and drifts with the residual Z gyro bias.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Ahrs_h
+#define ADIS16490_Ahrs_h
+#include "ADIS16490.h"
+
+// Estimators
+#define AHRS_MAHONY 0
+#define AHRS_KALMAN 1
+
+// AHRS filter class definition
+class ADIS16490_Ahrs {
+
+public:
+  ADIS16490_Ahrs(uint8_t mode = AHRS_MAHONY);
+
+  // Restarts level with zero bias
+  void reset();
+
+  // Mahony proportional (1/sec) and integral (1/sec^2) gains
+  void setGains(float kp, float ki);
+
+  // Kalman noise densities: gyro white noise (rad/sec/sqrt(Hz)), gyro bias
+  // random walk (rad/sec^2/sqrt(Hz)), and accel direction noise (unitless,
+  // per update), plus the accel update interval in samples
+  void setNoise(float gyroNoise, float biasNoise, float accelNoise, uint8_t accelInterval = 10);
+
+  // Accel corrections are skipped when |accel| differs from 1 g by more
+  // than this fraction
+  void setAccelGate(float tolerance);
+
+  // Processes one sample
+  // sample - raw sample from sensorRead(), burstRead(), or a capture buffer
+  // dt - sample period (sec)
+  void update(const ADIS16490_Sample &sample, float dt);
+
+  // Attitude quaternion (w, x, y, z; body to NED)
+  const float *quaternion() const { return _q; }
+
+  // Estimated gyro bias (rad/sec)
+  const float *gyroBias() const { return _bias; }
+
+  // Attitude as roll, pitch, yaw (rad). Uses trig; keep it out of the
+  // update loop.
+  void euler(float &roll, float &pitch, float &yaw) const;
+
+  // Updates since reset() and accel corrections skipped by the gate
+  uint32_t updates() const { return _updates; }
+  uint32_t rejected() const { return _rejected; }
+
+private:
+  // Kalman covariance propagation and accel measurement update
+  void kalmanPropagate(const float *rate, float dt);
+  void kalmanCorrect(const float *down, const float *expected);
+
+  uint8_t _mode;
+
+  // Precomputed scale factors
+  float _gyroScale;   // rad/sec/LSB
+  float _gravity2;    // (1 g in accel LSBs)^2
+  float _gateLow;     // Accepted squared accel norm range
+  float _gateHigh;
+
+  // Attitude and gyro bias
+  float _q[4];
+  float _bias[3];
+
+  // Mahony gains
+  float _kp;
+  float _ki;
+
+  // Kalman covariance (attitude error, bias) and noise
+  float _P[6][6];
+  float _gyroVar;
+  float _biasVar;
+  float _accelVar;
+  uint8_t _accelInterval;
+  uint8_t _accelCount;
+
+  uint32_t _updates;
+  uint32_t _rejected;
+
+};
+
+#endif
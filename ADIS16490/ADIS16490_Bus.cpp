@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Bus.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Teensy implementation of the ADIS16490_Bus interface. Compiled only when building with the
+//  Arduino toolchain; host builds use ADIS16490_Sim instead.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Bus.h"
+
+#ifdef ARDUINO
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor with configurable CS, DR, and RST
+////////////////////////////////////////////////////////////////////////////
+// CS - Chip select pin
+// DR - DR output pin for data ready
+// RST - Hardware reset pin
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_TeensyBus::ADIS16490_TeensyBus(int CS, int DR, int RST) {
+  _CS = CS;
+  _DR = DR;
+  _RST = RST;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Initializes SPI and sets default pin states
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TeensyBus::begin() {
+  SPI.begin();
+  pinMode(_CS, OUTPUT); // Set CS pin to be an output
+  pinMode(_DR, INPUT); // Set DR pin to be an input
+  pinMode(_RST, OUTPUT); // Set RST pin to be an output
+  digitalWrite(_CS, HIGH); // Initialize CS pin to be high
+  digitalWrite(_RST, HIGH); // Initialize RST pin to be high
+  // Enable the DWT cycle counter used for stall timing
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Closes SPI bus
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TeensyBus::end() {
+  SPI.end();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Sets SPI bit order, clock rate, and data mode
+////////////////////////////////////////////////////////////////////////////
+// clock - SCLK frequency in Hz
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TeensyBus::configure(uint32_t clock) {
+  SPISettings IMUSettings(clock, MSBFIRST, SPI_MODE3);
+  SPI.beginTransaction(IMUSettings);
+}
+
+void ADIS16490_TeensyBus::select() {
+  digitalWrite(_CS, LOW); // Set CS low to enable device
+}
+
+void ADIS16490_TeensyBus::deselect() {
+  digitalWrite(_CS, HIGH); // Set CS high to disable device
+}
+
+uint8_t ADIS16490_TeensyBus::transfer(uint8_t data) {
+  return SPI.transfer(data);
+}
+
+void ADIS16490_TeensyBus::transfer(const uint8_t *tx, uint8_t *rx, size_t len) {
+  SPI.transfer(tx, rx, len); // FIFO-backed buffer transfer
+}
+
+#ifdef SPI_HAS_TRANSFER_ASYNC
+////////////////////////////////////////////////////////////////////////////
+// Starts a DMA transfer. dmaEvent() runs from the DMA interrupt when the
+// last byte has been clocked and forwards to the caller's callback.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TeensyBus::transferAsync(const uint8_t *tx, uint8_t *rx, size_t len,
+                                        void (*done)(void *context), void *context) {
+  _done = done;
+  _doneContext = context;
+  _event.setContext(this);
+  _event.attachImmediate(dmaEvent);
+  SPI.transfer(tx, rx, len, _event);
+}
+
+void ADIS16490_TeensyBus::dmaEvent(EventResponderRef event) {
+  ADIS16490_TeensyBus *bus = (ADIS16490_TeensyBus *)event.getContext();
+  bus->_done(bus->_doneContext);
+}
+#endif
+
+void ADIS16490_TeensyBus::writeReset(uint8_t level) {
+  digitalWrite(_RST, level);
+}
+
+bool ADIS16490_TeensyBus::dataReady() {
+  return digitalRead(_DR) == HIGH;
+}
+
+int ADIS16490_TeensyBus::dataReadyPin() {
+  return _DR;
+}
+
+void ADIS16490_TeensyBus::delayMicros(uint32_t us) {
+  delayMicroseconds(us);
+}
+
+void ADIS16490_TeensyBus::delayMillis(uint32_t ms) {
+  delay(ms);
+}
+
+uint32_t ADIS16490_TeensyBus::microsNow() {
+  return micros();
+}
+
+uint32_t ADIS16490_TeensyBus::cycleCount() {
+  return ARM_DWT_CYCCNT;
+}
+
+uint32_t ADIS16490_TeensyBus::cyclesPerMicro() {
+  return F_CPU / 1000000;
+}
+
+void ADIS16490_TeensyBus::delayCycles(uint32_t cycles) {
+  uint32_t start = ARM_DWT_CYCCNT;
+  while ((ARM_DWT_CYCCNT - start) < cycles) {}
+}
+
+#endif
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Bus.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Hardware abstraction used by the ADIS16490 library. Every SPI frame, pin toggle, and delay issued
+//  by the driver goes through an ADIS16490_Bus object so the same driver code can run against the
+//  Teensy SPI peripheral or against the register-map simulator in ADIS16490_Sim.h on a host PC.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Bus_h
+#define ADIS16490_Bus_h
+#ifdef ARDUINO
+#include "Arduino.h"
+#include <SPI.h>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+// Abstract SPI/GPIO interface used by the driver
+class ADIS16490_Bus {
+
+public:
+  virtual ~ADIS16490_Bus() {}
+
+  // Starts the SPI controller and sets default pin states
+  virtual void begin() = 0;
+
+  // Releases the SPI controller
+  virtual void end() = 0;
+
+  // Applies bit order, clock rate, and data mode (SPI mode 3, MSB first)
+  virtual void configure(uint32_t clock) = 0;
+
+  // Drives CS low to start a frame
+  virtual void select() = 0;
+
+  // Drives CS high to end a frame
+  virtual void deselect() = 0;
+
+  // Clocks one byte out on MOSI and returns the byte received on MISO
+  virtual uint8_t transfer(uint8_t data) = 0;
+
+  // Clocks len bytes from tx while storing MISO bytes into rx. The default
+  // loops over transfer(); implementations may use a FIFO or DMA.
+  virtual void transfer(const uint8_t *tx, uint8_t *rx, size_t len) {
+    for (size_t i = 0; i < len; i++)
+      rx[i] = transfer(tx[i]);
+  }
+
+  // Starts a transfer of len bytes and returns without waiting. done(context)
+  // is called once the last byte has been clocked. The default performs a
+  // blocking transfer and calls done() before returning; implementations
+  // with DMA return immediately and call done() from the DMA interrupt.
+  virtual void transferAsync(const uint8_t *tx, uint8_t *rx, size_t len,
+                             void (*done)(void *context), void *context) {
+    transfer(tx, rx, len);
+    done(context);
+  }
+
+  // Drives the hardware reset pin (0 = reset asserted)
+  virtual void writeReset(uint8_t level) = 0;
+
+  // Returns the state of the data ready pin
+  virtual bool dataReady() = 0;
+
+  // Returns the data ready pin number, or -1 if there is no physical pin
+  virtual int dataReadyPin() { return -1; }
+
+  // Blocking delay in microseconds
+  virtual void delayMicros(uint32_t us) = 0;
+
+  // Blocking delay in milliseconds
+  virtual void delayMillis(uint32_t ms) = 0;
+
+  // Free-running microsecond time base
+  virtual uint32_t microsNow() = 0;
+
+  // Free-running cycle counter used for sub-microsecond stall timing, and
+  // its rate. The default falls back to microsNow().
+  virtual uint32_t cycleCount() { return microsNow(); }
+  virtual uint32_t cyclesPerMicro() { return 1; }
+
+  // Blocking delay in counter cycles
+  virtual void delayCycles(uint32_t cycles) {
+    uint32_t perMicro = cyclesPerMicro();
+    delayMicros((cycles + perMicro - 1) / perMicro);
+  }
+
+};
+
+#ifdef ARDUINO
+// Teensy implementation using the global SPI object and Arduino pin functions
+class ADIS16490_TeensyBus : public ADIS16490_Bus {
+
+public:
+  ADIS16490_TeensyBus(int CS, int DR, int RST);
+
+  void begin();
+  void end();
+  void configure(uint32_t clock);
+  void select();
+  void deselect();
+  uint8_t transfer(uint8_t data);
+  void transfer(const uint8_t *tx, uint8_t *rx, size_t len);
+#ifdef SPI_HAS_TRANSFER_ASYNC
+  void transferAsync(const uint8_t *tx, uint8_t *rx, size_t len,
+                     void (*done)(void *context), void *context);
+#endif
+  void writeReset(uint8_t level);
+  bool dataReady();
+  int dataReadyPin();
+  void delayMicros(uint32_t us);
+  void delayMillis(uint32_t ms);
+  uint32_t microsNow();
+  uint32_t cycleCount();
+  uint32_t cyclesPerMicro();
+  void delayCycles(uint32_t cycles);
+
+private:
+  // Chip select pin
+  int _CS;
+
+  // IRQ output pin for data ready
+  int _DR;
+
+  // Hardware reset pin
+  int _RST;
+
+#ifdef SPI_HAS_TRANSFER_ASYNC
+  // DMA completion event and pending callback
+  static void dmaEvent(EventResponderRef event);
+  EventResponder _event;
+  void (*_done)(void *context);
+  void *_doneContext;
+#endif
+
+};
+#endif
+
+#endif
@@ -0,0 +1,819 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Calibration.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  In-field calibration for the ADIS16490. See ADIS16490_Calibration.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Calibration.h"
+#include <math.h>
+#include <string.h>
+
+// LOW register of a bias channel (X/Y/Z gyro, X/Y/Z accel); HIGH follows
+static inline uint16_t biasAddr(uint8_t channel) {
+  return XG_BIAS_LOW + 4 * channel;
+}
+
+static inline int32_t &biasValue(ADIS16490_Bias &bias, uint8_t channel) {
+  return *(channel < 3 ? bias.gyro + channel : bias.accel + (channel - 3));
+}
+
+static inline int32_t biasValue(const ADIS16490_Bias &bias, uint8_t channel) {
+  return *(channel < 3 ? bias.gyro + channel : bias.accel + (channel - 3));
+}
+
+void ADIS16490_Window::clear() {
+  memset(sum, 0, sizeof(sum));
+  memset(sumSquares, 0, sizeof(sumSquares));
+  count = 0;
+}
+
+void ADIS16490_Window::add(const ADIS16490_Sample &sample) {
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    int32_t gyro = sample.gyro[axis], accel = sample.accel[axis];
+    sum[axis] += gyro;
+    sumSquares[axis] += (int64_t)gyro * gyro;
+    sum[axis + 3] += accel;
+    sumSquares[axis + 3] += (int64_t)accel * accel;
+  }
+  count++;
+}
+
+bool ADIS16490_Window::quiet(const float *limits) const {
+  float n = count;
+  for (uint8_t c = 0; c < 6; c++) {
+    int64_t spread = (int64_t)count * sumSquares[c] - sum[c] * sum[c];
+    if ((float)spread > limits[c] * limits[c] * n * n)
+      return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Waits for the next rising edge of data ready and burst reads the output
+// Returns 1 for a new output, 0 for a repeated DATA_CNT, -1 for a checksum
+// error, -2 if data ready did not toggle within BIAS_TIMEOUT_MICROS.
+////////////////////////////////////////////////////////////////////////////
+// imu - driver
+// sample - output read
+// primed - lastCount is valid; set on return
+// lastCount - DATA_CNT of the previous output
+////////////////////////////////////////////////////////////////////////////
+static int nextSample(ADIS16490 *imu, ADIS16490_Sample &sample, bool &primed, uint16_t &lastCount) {
+  ADIS16490_Bus *bus = imu->bus();
+  uint32_t start = bus->microsNow();
+  while (bus->dataReady())
+    if (bus->microsNow() - start > BIAS_TIMEOUT_MICROS)
+      return -2;
+    else
+      bus->delayMicros(1);
+  while (!bus->dataReady())
+    if (bus->microsNow() - start > BIAS_TIMEOUT_MICROS)
+      return -2;
+    else
+      bus->delayMicros(1);
+
+  if (!imu->burstRead(sample))
+    return -1;
+  if (primed && sample.dataCount == lastCount)
+    return 0;
+  primed = true;
+  lastCount = sample.dataCount;
+  return 1;
+}
+
+// Solves A x = b in place by Gaussian elimination with partial pivoting
+// (A is n x n, row major, n <= 4). Returns false if A is singular.
+static bool solveLinear(float *A, float *b, uint8_t n) {
+  for (uint8_t col = 0; col < n; col++) {
+    uint8_t pivot = col;
+    for (uint8_t row = col + 1; row < n; row++)
+      if (fabsf(A[row * n + col]) > fabsf(A[pivot * n + col]))
+        pivot = row;
+    if (fabsf(A[pivot * n + col]) < 1e-12f)
+      return false;
+    if (pivot != col) {
+      for (uint8_t k = 0; k < n; k++) {
+        float t = A[col * n + k];
+        A[col * n + k] = A[pivot * n + k];
+        A[pivot * n + k] = t;
+      }
+      float t = b[col];
+      b[col] = b[pivot];
+      b[pivot] = t;
+    }
+    for (uint8_t row = col + 1; row < n; row++) {
+      float f = A[row * n + col] / A[col * n + col];
+      for (uint8_t k = col; k < n; k++)
+        A[row * n + k] -= f * A[col * n + k];
+      b[row] -= f * b[col];
+    }
+  }
+  for (int8_t row = n - 1; row >= 0; row--) {
+    for (uint8_t k = row + 1; k < n; k++)
+      b[row] -= A[row * n + k] * b[k];
+    b[row] /= A[row * n + row];
+  }
+  return true;
+}
+
+// Inverts a 3x3 matrix. Returns false if it is singular.
+static bool invert3(const float m[3][3], float inv[3][3]) {
+  float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+  float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+  float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+  float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+  if (fabsf(det) < 1e-12f)
+    return false;
+  float s = 1.0f / det;
+  inv[0][0] = c00 * s;
+  inv[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * s;
+  inv[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * s;
+  inv[1][0] = c01 * s;
+  inv[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * s;
+  inv[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * s;
+  inv[2][0] = c02 * s;
+  inv[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * s;
+  inv[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * s;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor. Default windows and limits, level gravity.
+////////////////////////////////////////////////////////////////////////////
+// imu - driver used for all register access
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_BiasCalibration::ADIS16490_BiasCalibration(ADIS16490 &imu) {
+  _imu = &imu;
+  setWindows(BIAS_WINDOW, BIAS_WINDOWS);
+  setMotionLimits(BIAS_GYRO_NOISE, BIAS_ACCEL_NOISE, BIAS_GYRO_SHIFT, BIAS_ACCEL_SHIFT);
+  setGravity(0, 0, -1000);
+  memset(&_initial, 0, sizeof(_initial));
+  memset(&_written, 0, sizeof(_written));
+  memset(&_stats, 0, sizeof(_stats));
+  memset(_total, 0, sizeof(_total));
+  _totalCount = 0;
+  _shiftedRun = 0;
+}
+
+void ADIS16490_BiasCalibration::setWindows(uint16_t samples, uint16_t windows, uint16_t maxWindows) {
+  _windowSamples = samples < 2 ? 2 : samples;
+  _windows = windows < 1 ? 1 : windows;
+  _maxWindows = maxWindows < _windows ? _windows : maxWindows;
+}
+
+void ADIS16490_BiasCalibration::setMotionLimits(float gyroNoise, float accelNoise, float gyroShift, float accelShift) {
+  for (uint8_t c = 0; c < 3; c++) {
+    _noise[c] = gyroNoise / GYRO_LSB;
+    _noise[c + 3] = accelNoise / ACCL_LSB;
+    _shift[c] = gyroShift / GYRO_LSB;
+    _shift[c + 3] = accelShift / ACCL_LSB;
+  }
+}
+
+void ADIS16490_BiasCalibration::setGravity(float x, float y, float z) {
+  _expected[0] = _expected[1] = _expected[2] = 0;
+  _expected[3] = x / ACCL_LSB;
+  _expected[4] = y / ACCL_LSB;
+  _expected[5] = z / ACCL_LSB;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Starts a new calibration
+// Returns 1 when the bias registers have been read.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_BiasCalibration::begin() {
+  memset(&_stats, 0, sizeof(_stats));
+  memset(_total, 0, sizeof(_total));
+  _window.clear();
+  _totalCount = 0;
+  _shiftedRun = 0;
+  read(_initial);
+  _written = _initial;
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Adds one sample to the current window and closes it when full
+// Returns 1 once enough still windows have been averaged.
+////////////////////////////////////////////////////////////////////////////
+// sample - sample record from burstRead() or a capture buffer
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_BiasCalibration::add(const ADIS16490_Sample &sample) {
+  if (done())
+    return(1);
+  _window.add(sample);
+  if (_window.count >= _windowSamples)
+    closeWindow();
+  return(done());
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Accepts the window if it is quiet and agrees with the running average
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_BiasCalibration::closeWindow() {
+  bool noisy = !_window.quiet(_noise), shifted = false;
+  for (uint8_t c = 0; c < 6; c++)
+    if (_totalCount && fabsf(_window.mean(c) - (float)_total[c] / _totalCount) > _shift[c])
+      shifted = true;
+
+  _stats.windows++;
+  if (noisy)
+    _stats.noisy++;
+  else if (shifted && ++_shiftedRun < BIAS_RESTART_WINDOWS)
+    _stats.shifted++;
+  else {
+    // Still and consistent, or settled in a new place: start over from it
+    if (shifted) {
+      _stats.shifted++;
+      _stats.restarts++;
+      memset(_total, 0, sizeof(_total));
+      _totalCount = 0;
+      _stats.accepted = 0;
+    }
+    for (uint8_t c = 0; c < 6; c++)
+      _total[c] += _window.sum[c];
+    _totalCount += _window.count;
+    _stats.accepted++;
+    _shiftedRun = 0;
+  }
+  _window.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads each new output at the output rate. Waits for the rising edge of
+// data ready and skips reads that repeat DATA_CNT.
+// Returns 1 when enough still windows were found, 0 on the window limit or
+// if data ready stops toggling.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_BiasCalibration::collect() {
+  bool primed = false;
+  uint16_t lastCount = 0;
+  while (!done() && _stats.windows < _maxWindows) {
+    ADIS16490_Sample sample;
+    int result = nextSample(_imu, sample, primed, lastCount);
+    if (result == -2)
+      return(0);
+    if (result == -1)
+      _stats.checksumErrors++;
+    else if (result == 0)
+      _stats.duplicates++;
+    else
+      add(sample);
+  }
+  return(done());
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Average of the accepted windows minus the expected outputs, rounded to
+// the 16.16 bias register format. The 16-bit outputs are the 32-bit ones
+// truncated, so with noise above 1 LSB their mean sits half an LSB low.
+// Returns 1 if any window was accepted.
+////////////////////////////////////////////////////////////////////////////
+// offset - output offset per channel
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_BiasCalibration::offset(ADIS16490_Bias &offset) const {
+  memset(&offset, 0, sizeof(offset));
+  if (!_totalCount)
+    return(0);
+  for (uint8_t c = 0; c < 6; c++) {
+    int64_t scaled = (_total[c] * 2 + _totalCount) * 32768;
+    int64_t mean = (scaled >= 0 ? scaled + _totalCount / 2 : scaled - _totalCount / 2) / (int64_t)_totalCount;
+    biasValue(offset, c) = (int32_t)(mean - (int64_t)lroundf(_expected[c] * 65536.0f));
+  }
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads XG_BIAS ~ ZA_BIAS with one batch of chained reads
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_BiasCalibration::read(ADIS16490_Bias &bias) {
+  ADIS16490_RegOp ops[12];
+  for (uint8_t c = 0; c < 6; c++) {
+    ops[2 * c] = {biasAddr(c), 0, REG_OP_READ};
+    ops[2 * c + 1] = {(uint16_t)(biasAddr(c) + 2), 0, REG_OP_READ};
+  }
+  _imu->regBatch(ops, 12);
+  for (uint8_t c = 0; c < 6; c++)
+    biasValue(bias, c) = (int32_t)(((uint32_t)(uint16_t)ops[2 * c + 1].data << 16) | (uint16_t)ops[2 * c].data);
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Writes the LOW and HIGH words of the selected bias registers and reads
+// them back in the same batch
+// Returns 1 when every register reads back as written.
+////////////////////////////////////////////////////////////////////////////
+// bias - register contents
+// quantities - BIAS_GYRO and/or BIAS_ACCEL
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_BiasCalibration::write(const ADIS16490_Bias &bias, uint8_t quantities) {
+  ADIS16490_RegOp ops[24];
+  uint8_t channels[6];
+  size_t writes = 0, selected = 0;
+  for (uint8_t c = 0; c < 6; c++) {
+    if (!(quantities & (c < 3 ? BIAS_GYRO : BIAS_ACCEL)))
+      continue;
+    uint32_t value = (uint32_t)biasValue(bias, c);
+    ops[writes++] = {biasAddr(c), (int16_t)(value & 0xFFFF), REG_OP_WRITE};
+    ops[writes++] = {(uint16_t)(biasAddr(c) + 2), (int16_t)(value >> 16), REG_OP_WRITE};
+    channels[selected++] = c;
+  }
+  size_t count = writes;
+  for (size_t i = 0; i < writes; i++)
+    ops[count++] = {ops[i].addr, 0, REG_OP_READ};
+
+  ADIS16490_BatchStats batch;
+  _imu->regBatch(ops, count, &batch);
+  _stats.frames = batch.frames;
+  _stats.naiveFrames = batch.naiveFrames;
+  _stats.verifyErrors = 0;
+  for (size_t i = 0; i < writes; i++)
+    if (ops[writes + i].data != ops[i].data)
+      _stats.verifyErrors++;
+  for (size_t i = 0; i < selected; i++)
+    biasValue(_written, channels[i]) = biasValue(bias, channels[i]);
+  return(_stats.verifyErrors == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Cancels the measured offset of the selected quantities
+// Returns 1 when the new registers read back as written, 0 if no window
+// was accepted.
+////////////////////////////////////////////////////////////////////////////
+// quantities - BIAS_GYRO and/or BIAS_ACCEL
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_BiasCalibration::apply(uint8_t quantities) {
+  ADIS16490_Bias measured, bias = _initial;
+  if (!offset(measured))
+    return(0);
+  for (uint8_t c = 0; c < 6; c++) {
+    int64_t value = (int64_t)biasValue(_initial, c) - biasValue(measured, c);
+    biasValue(bias, c) = value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : (int32_t)value);
+  }
+  return(write(bias, quantities));
+}
+
+int ADIS16490_BiasCalibration::run(uint8_t quantities) {
+  begin();
+  if (!collect())
+    return(0);
+  return(apply(quantities));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor. Default windows and limits, 4250 Hz output rate, identity
+// model.
+////////////////////////////////////////////////////////////////////////////
+// imu - driver used for all register access
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_TumbleCalibration::ADIS16490_TumbleCalibration(ADIS16490 &imu) {
+  _imu = &imu;
+  setWindows(TUMBLE_WINDOW, TUMBLE_MIN_WINDOWS);
+  setSampleRate(TUMBLE_BASE_RATE);
+  setMotionLimits(BIAS_GYRO_NOISE, BIAS_ACCEL_NOISE, TUMBLE_STILL_RATE, BIAS_ACCEL_SHIFT);
+  memset(_scale, 0, sizeof(_scale));
+  memset(_bias, 0, sizeof(_bias));
+  memset(&_model, 0, sizeof(_model));
+  for (uint8_t i = 0; i < 3; i++)
+    _model.gyro[i][i] = _model.accel[i][i] = 1;
+  clear();
+}
+
+void ADIS16490_TumbleCalibration::setWindows(uint16_t samples, uint16_t minWindows) {
+  _windowSamples = samples < 2 ? 2 : samples;
+  _minWindows = minWindows < 1 ? 1 : minWindows;
+}
+
+void ADIS16490_TumbleCalibration::setMotionLimits(float gyroNoise, float accelNoise, float stillRate, float accelShift) {
+  for (uint8_t c = 0; c < 3; c++) {
+    _noise[c] = gyroNoise / GYRO_LSB;
+    _noise[c + 3] = accelNoise / ACCL_LSB;
+  }
+  _stillRate = stillRate / GYRO_LSB;
+  _accelShift = accelShift / ACCL_LSB;
+}
+
+void ADIS16490_TumbleCalibration::clear() {
+  memset(&_stats, 0, sizeof(_stats));
+  _window.clear();
+  endSegment();
+  memset(_gyroSum, 0, sizeof(_gyroSum));
+  _gyroCount = 0;
+  _lastCount = 0;
+  _primed = false;
+  memset(_anchorSum, 0, sizeof(_anchorSum));
+  _anchorCount = 0;
+  memset(_gyroS, 0, sizeof(_gyroS));
+  memset(_accelS, 0, sizeof(_accelS));
+  memset(_gyroB, 0, sizeof(_gyroB));
+  memset(_accelB, 0, sizeof(_accelB));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Starts a new tumble. The output period is set from DEC_RATE and the
+// internal sample clock.
+// Returns 1 when the scale, bias, and DEC_RATE registers have been read.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_TumbleCalibration::begin() {
+  clear();
+  ADIS16490_RegOp ops[19];
+  for (uint8_t c = 0; c < 6; c++) {
+    ops[c] = {(uint16_t)(X_GYRO_SCALE + 2 * c), 0, REG_OP_READ};
+    ops[6 + 2 * c] = {biasAddr(c), 0, REG_OP_READ};
+    ops[7 + 2 * c] = {(uint16_t)(biasAddr(c) + 2), 0, REG_OP_READ};
+  }
+  ops[18] = {DEC_RATE, 0, REG_OP_READ};
+  _imu->regBatch(ops, 19);
+  for (uint8_t c = 0; c < 6; c++) {
+    _scale[c] = ops[c].data;
+    _bias[c] = (int32_t)(((uint32_t)(uint16_t)ops[7 + 2 * c].data << 16) | (uint16_t)ops[6 + 2 * c].data);
+  }
+  setSampleRate(TUMBLE_BASE_RATE / ((ops[18].data & 0x07FF) + 1));
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Adds one sample to the gyro integral and the current window. The sample
+// is integrated over every output period since the previous DATA_CNT, so
+// outputs lost to a ring overrun or a late read are filled with the next
+// rate instead of shrinking the move angle.
+// Returns 1 once the tumble is complete.
+////////////////////////////////////////////////////////////////////////////
+// sample - sample record from burstRead() or a capture buffer
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_TumbleCalibration::add(const ADIS16490_Sample &sample) {
+  uint16_t periods = _primed ? (uint16_t)(sample.dataCount - _lastCount) : 1;
+  _primed = true;
+  _lastCount = sample.dataCount;
+  if (periods == 0) {
+    _stats.duplicates++;
+    return(complete());
+  }
+  _stats.lost += periods - 1;
+  for (uint8_t axis = 0; axis < 3; axis++)
+    _gyroSum[axis] += (int32_t)sample.gyro[axis] * periods;
+  _gyroCount += periods;
+  _window.add(sample);
+  if (_window.count >= _windowSamples)
+    closeWindow();
+  return(complete());
+}
+
+////////////////////////////////////////////////////////////////////////////
+// A window is still when it is quiet and the mean rate is small. A still
+// window whose accel moved away from the previous one starts a new
+// segment. The first window of a segment is dropped and the latest is held
+// back, since either may include part of a move.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TumbleCalibration::closeWindow() {
+  _stats.windows++;
+  bool still = _window.quiet(_noise);
+  for (uint8_t axis = 0; axis < 3; axis++)
+    if (fabsf(_window.mean(axis)) > _stillRate)
+      still = false;
+  if (!still) {
+    endSegment();
+    _window.clear();
+    return;
+  }
+  _stats.still++;
+  for (uint8_t axis = 0; axis < 3; axis++)
+    if (_segment && fabsf(_window.mean(axis + 3) - _lastMean[axis]) > _accelShift)
+      endSegment();
+  for (uint8_t axis = 0; axis < 3; axis++)
+    _lastMean[axis] = _window.mean(axis + 3);
+
+  if (!_segment)
+    _segment = true;
+  else {
+    if (_pending)
+      commit(_pendingWindow);
+    _pendingWindow = _window;
+    _pending = true;
+  }
+  _window.clear();
+}
+
+void ADIS16490_TumbleCalibration::commit(const ADIS16490_Window &window) {
+  if (_position >= 0) {
+    for (uint8_t c = 0; c < 6; c++)
+      _positionSum[_position][c] += window.sum[c];
+    _positionCount[_position] += window.count;
+    return;
+  }
+  for (uint8_t c = 0; c < 6; c++)
+    _segmentSum[c] += window.sum[c];
+  _segmentCount += window.count;
+  if (++_segmentWindows == _minWindows)
+    addPosition();
+}
+
+void ADIS16490_TumbleCalibration::endSegment() {
+  _segment = false;
+  _pending = false;
+  _position = -1;
+  memset(_segmentSum, 0, sizeof(_segmentSum));
+  _segmentCount = 0;
+  _segmentWindows = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Labels the segment with the face gravity points along and records the
+// move from the previous position
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TumbleCalibration::addPosition() {
+  const float g = 1000.0f / ACCL_LSB, tolerance = TUMBLE_FACE_TOLERANCE / ACCL_LSB;
+  float mean[3];
+  uint8_t axis = 0;
+  for (uint8_t a = 0; a < 3; a++) {
+    mean[a] = (float)_segmentSum[a + 3] / _segmentCount;
+    if (fabsf(mean[a]) > fabsf(mean[axis]))
+      axis = a;
+  }
+  bool face = fabsf(fabsf(mean[axis]) - g) < tolerance;
+  for (uint8_t a = 0; a < 3; a++)
+    if (a != axis && fabsf(mean[a]) > tolerance)
+      face = false;
+  if (!face || _stats.positions >= TUMBLE_MAX_POSITIONS) {
+    _stats.rejectedPositions++;
+    return;
+  }
+
+  uint8_t p = _stats.positions++;
+  _face[p] = 2 * axis + (mean[axis] < 0);
+  _stats.faces |= 1 << _face[p];
+  memcpy(_positionSum[p], _segmentSum, sizeof(_segmentSum));
+  _positionCount[p] = _segmentCount;
+  _position = p;
+
+  if (p > 0) {
+    // Gyro bias from the positions so far is good enough to round the move
+    int64_t biasSum[3] = {0, 0, 0};
+    uint32_t biasCount = 0;
+    for (uint8_t i = 0; i <= p; i++) {
+      for (uint8_t a = 0; a < 3; a++)
+        biasSum[a] += _positionSum[i][a];
+      biasCount += _positionCount[i];
+    }
+    uint32_t count = _gyroCount - _anchorCount;
+    float measured[3], nominal[3], largest = 0;
+    for (uint8_t a = 0; a < 3; a++) {
+      float sum = (float)(_gyroSum[a] - _anchorSum[a]) - (float)biasSum[a] / biasCount * count;
+      measured[a] = sum * GYRO_LSB * _period;
+      largest = fmaxf(largest, fabsf(measured[a]));
+    }
+    if (largest >= TUMBLE_ANGLE_TOLERANCE) {
+      if (nominalMove(measured, nominal)) {
+        uint8_t m = _stats.moves++;
+        for (uint8_t a = 0; a < 3; a++) {
+          _moveSum[m][a] = _gyroSum[a] - _anchorSum[a];
+          if (nominal[a] != 0)
+            _stats.moveAxes |= 1 << a;
+        }
+        _moveCount[m] = count;
+      }
+      else
+        _stats.rejectedMoves++;
+    }
+  }
+  memcpy(_anchorSum, _gyroSum, sizeof(_gyroSum));
+  _anchorCount = _gyroCount;
+}
+
+bool ADIS16490_TumbleCalibration::nominalMove(const float *measured, float *nominal) const {
+  uint8_t axis = 0;
+  for (uint8_t a = 1; a < 3; a++)
+    if (fabsf(measured[a]) > fabsf(measured[axis]))
+      axis = a;
+  for (uint8_t a = 0; a < 3; a++)
+    nominal[a] = a == axis ? 90.0f * roundf(measured[a] / 90.0f) : 0;
+  for (uint8_t a = 0; a < 3; a++)
+    if (fabsf(measured[a] - nominal[a]) > TUMBLE_ANGLE_TOLERANCE)
+      return false;
+  return nominal[axis] != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads each new output until the tumble is complete
+// Returns 1 when complete, 0 on timeout or if data ready stops toggling.
+////////////////////////////////////////////////////////////////////////////
+// timeoutMicros - longest time to wait for the tumble
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_TumbleCalibration::collect(uint32_t timeoutMicros) {
+  ADIS16490_Bus *bus = _imu->bus();
+  uint32_t start = bus->microsNow();
+  bool primed = false;
+  uint16_t lastCount = 0;
+  while (!complete() && bus->microsNow() - start < timeoutMicros) {
+    ADIS16490_Sample sample;
+    int result = nextSample(_imu, sample, primed, lastCount);
+    if (result == -2)
+      return(0);
+    if (result == -1)
+      _stats.checksumErrors++;
+    else if (result == 0)
+      _stats.duplicates++;
+    else
+      add(sample);
+  }
+  return(complete());
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Least squares fits. Accel: each position gives output = S * g_face + b,
+// four unknowns per output axis. Gyro: each move gives the integrated
+// output minus bias = S * nominal rotation, three unknowns per output axis,
+// with the bias from the still positions.
+// Returns 1 when complete, 0 if the tumble is incomplete or degenerate.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_TumbleCalibration::solve() {
+  if (!complete())
+    return(0);
+  const float g = 1000.0f / ACCL_LSB;
+  uint8_t positions = _stats.positions, moves = _stats.moves;
+
+  // Accel
+  float residual = 0;
+  for (uint8_t i = 0; i < 3; i++) {
+    float A[16] = {0}, x[4] = {0};
+    for (uint8_t p = 0; p < positions; p++) {
+      float row[4] = {0, 0, 0, 1};
+      row[_face[p] / 2] = (_face[p] & 1) ? -1.0f : 1.0f;
+      float y = (float)_positionSum[p][i + 3] / _positionCount[p];
+      for (uint8_t r = 0; r < 4; r++) {
+        for (uint8_t c = 0; c < 4; c++)
+          A[r * 4 + c] += row[r] * row[c];
+        x[r] += row[r] * y;
+      }
+    }
+    if (!solveLinear(A, x, 4))
+      return(0);
+    for (uint8_t j = 0; j < 3; j++)
+      _accelS[i][j] = x[j] / g;
+    _accelB[i] = x[3] + 0.5f;
+    for (uint8_t p = 0; p < positions; p++) {
+      float y = (float)_positionSum[p][i + 3] / _positionCount[p];
+      float e = y - x[3] - ((_face[p] & 1) ? -x[_face[p] / 2] : x[_face[p] / 2]);
+      residual += e * e;
+    }
+  }
+  _stats.accelResidual = sqrtf(residual / (3 * positions)) * ACCL_LSB;
+
+  // Gyro bias from all positions, in the truncated 16-bit scale
+  float bias[3];
+  uint32_t biasCount = 0;
+  for (uint8_t p = 0; p < positions; p++)
+    biasCount += _positionCount[p];
+  for (uint8_t a = 0; a < 3; a++) {
+    int64_t sum = 0;
+    for (uint8_t p = 0; p < positions; p++)
+      sum += _positionSum[p][a];
+    bias[a] = (float)sum / biasCount;
+    _gyroB[a] = bias[a] + 0.5f;
+  }
+
+  // Gyro
+  float measured[TUMBLE_MAX_POSITIONS][3], nominal[TUMBLE_MAX_POSITIONS][3];
+  for (uint8_t m = 0; m < moves; m++) {
+    for (uint8_t a = 0; a < 3; a++)
+      measured[m][a] = ((float)_moveSum[m][a] - bias[a] * _moveCount[m]) * GYRO_LSB * _period;
+    nominalMove(measured[m], nominal[m]);
+  }
+  residual = 0;
+  for (uint8_t i = 0; i < 3; i++) {
+    float A[9] = {0}, x[3] = {0};
+    for (uint8_t m = 0; m < moves; m++)
+      for (uint8_t r = 0; r < 3; r++) {
+        for (uint8_t c = 0; c < 3; c++)
+          A[r * 3 + c] += nominal[m][r] * nominal[m][c];
+        x[r] += nominal[m][r] * measured[m][i];
+      }
+    if (!solveLinear(A, x, 3))
+      return(0);
+    for (uint8_t j = 0; j < 3; j++)
+      _gyroS[i][j] = x[j];
+    for (uint8_t m = 0; m < moves; m++) {
+      float e = measured[m][i] - (x[0] * nominal[m][0] + x[1] * nominal[m][1] + x[2] * nominal[m][2]);
+      residual += e * e;
+    }
+  }
+  _stats.gyroResidual = sqrtf(residual / (3 * moves));
+
+  const float unchanged[3] = {1, 1, 1};
+  setModel(_gyroS, _gyroB, unchanged, _bias, _model.gyro, _model.gyroOffset);
+  setModel(_accelS, _accelB, unchanged, _bias + 3, _model.accel, _model.accelOffset);
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Model for the device scale changed by d per axis. The outputs become
+// D * (S * truth + b - B) + B, with B the bias registers.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TumbleCalibration::setModel(const float S[3][3], const float *b, const float *d, const int32_t *bias,
+                                           float M[3][3], float *offset) {
+  float scaled[3][3];
+  for (uint8_t i = 0; i < 3; i++) {
+    float B = bias[i] / 65536.0f;
+    for (uint8_t j = 0; j < 3; j++)
+      scaled[i][j] = d[i] * S[i][j];
+    offset[i] = d[i] * (b[i] - B) + B;
+  }
+  invert3(scaled, M);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Moves the diagonal of S into the scale registers. The new register is
+// (1 + old / 32768) / S[i][i] - 1 in units of 1/32768; the model keeps the
+// rest.
+// Returns 1 when every register reads back as written, 0 before solve().
+////////////////////////////////////////////////////////////////////////////
+// quantities - BIAS_GYRO and/or BIAS_ACCEL
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_TumbleCalibration::apply(uint8_t quantities) {
+  if (_gyroS[0][0] == 0)
+    return(0);
+  ADIS16490_RegOp ops[12];
+  float d[6];
+  size_t writes = 0;
+  for (uint8_t c = 0; c < 6; c++) {
+    d[c] = 1;
+    if (!(quantities & (c < 3 ? BIAS_GYRO : BIAS_ACCEL)))
+      continue;
+    float S = c < 3 ? _gyroS[c][c] : _accelS[c - 3][c - 3];
+    float k = 1.0f + _scale[c] / 32768.0f;
+    long reg = lroundf((k / S - 1.0f) * 32768.0f);
+    reg = reg > 32767 ? 32767 : (reg < -32768 ? -32768 : reg);
+    d[c] = (1.0f + reg / 32768.0f) / k;
+    ops[writes++] = {(uint16_t)(X_GYRO_SCALE + 2 * c), (int16_t)reg, REG_OP_WRITE};
+  }
+  size_t count = writes;
+  for (size_t i = 0; i < writes; i++)
+    ops[count++] = {ops[i].addr, 0, REG_OP_READ};
+
+  ADIS16490_BatchStats batch;
+  _imu->regBatch(ops, count, &batch);
+  _stats.frames = batch.frames;
+  _stats.naiveFrames = batch.naiveFrames;
+  _stats.verifyErrors = 0;
+  for (size_t i = 0; i < writes; i++)
+    if (ops[writes + i].data != ops[i].data)
+      _stats.verifyErrors++;
+
+  setModel(_gyroS, _gyroB, d, _bias, _model.gyro, _model.gyroOffset);
+  setModel(_accelS, _accelB, d + 3, _bias + 3, _model.accel, _model.accelOffset);
+  return(_stats.verifyErrors == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// truth = M * (output - offset). The 16-bit outputs are truncated, so half
+// an LSB is added back.
+////////////////////////////////////////////////////////////////////////////
+// sample - 16-bit outputs
+// gyro - rates (deg/sec)
+// accel - specific force (mg)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TumbleCalibration::compensate(const ADIS16490_Sample &sample, float gyro[3], float accel[3]) const {
+  float g[3], a[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    g[i] = sample.gyro[i] + 0.5f - _model.gyroOffset[i];
+    a[i] = sample.accel[i] + 0.5f - _model.accelOffset[i];
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    gyro[i] = (_model.gyro[i][0] * g[0] + _model.gyro[i][1] * g[1] + _model.gyro[i][2] * g[2]) * GYRO_LSB;
+    accel[i] = (_model.accel[i][0] * a[0] + _model.accel[i][1] * a[1] + _model.accel[i][2] * a[2]) * ACCL_LSB;
+  }
+}
+
+void ADIS16490_TumbleCalibration::compensate(const ADIS16490_HighRes &data, float gyro[3], float accel[3]) const {
+  float g[3], a[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    g[i] = data.gyro[i] / 65536.0f - _model.gyroOffset[i];
+    a[i] = data.accel[i] / 65536.0f - _model.accelOffset[i];
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    gyro[i] = (_model.gyro[i][0] * g[0] + _model.gyro[i][1] * g[1] + _model.gyro[i][2] * g[2]) * GYRO_LSB;
+    accel[i] = (_model.accel[i][0] * a[0] + _model.accel[i][1] * a[1] + _model.accel[i][2] * a[2]) * ACCL_LSB;
+  }
+}
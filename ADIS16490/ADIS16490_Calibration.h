@@ -0,0 +1,402 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Calibration.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  In-field bias calibration for the ADIS16490. ADIS16490_BiasCalibration averages stationary
+//  samples and writes 32-bit corrections to the page 2 bias registers (XG_BIAS_LOW/HIGH ~
+//  ZA_BIAS_LOW/HIGH). The device applies them to its outputs right away; they are lost at power off
+//  unless saved with the GLOB_CMD flash update command.
+//
+//  Samples are checked in windows. A window is rejected when the standard deviation of any gyro or
+//  accel axis shows vibration or handling, or when its mean moved away from the average of the
+//  windows accepted so far, which catches slow rotation and tilt changes that a variance check
+//  misses. A run of shifted windows means the unit has settled somewhere new, so the average starts
+//  over from there. The corrections are relative to the bias registers in effect while the samples
+//  were taken, which are read when collection starts, so running the calibration again refines the
+//  result instead of undoing it.
+//
+//  The gyro bias is the mean rate (the earth rate, up to 0.004 deg/sec, is included). The accel
+//  bias needs the specific force the unit should measure where it sits, set with setGravity(); the
+//  default is level with the Z axis reading -1 g. All registers written are sent as one regBatch()
+//  with readback. The GLOB_CMD bias null command does a similar average for the gyros on the device
+//  itself, without motion rejection.
+//
+//  ADIS16490_TumbleCalibration fits scale and misalignment of both sensors from a six-position
+//  tumble: the unit rests on each of its six faces in turn, rotating about one body axis at a time
+//  between rests. Still segments are found with the same windows; each becomes a position labelled
+//  with the face gravity points along. The gyro is integrated from one position to the next, and the
+//  move is rounded to a multiple of 90 degrees about the dominant axis. Least squares then gives,
+//  per sensor, the 3x3 matrix S and offset b in output = S * truth + b. The diagonal of S is
+//  written to X_GYRO_SCALE ~ Z_ACCL_SCALE (the device multiplies its outputs by 1 + SCALE / 32768,
+//  ahead of the bias registers); what the registers cannot express, the cross-axis terms and the
+//  offsets, stays in an ADIS16490_ScaleModel applied by compensate(). Offsets of the earth rate
+//  (under 0.004 deg/sec, changing with the face) are not separated from the gyro bias.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Calibration_h
+#define ADIS16490_Calibration_h
+#include "ADIS16490.h"
+#include "ADIS1649x.h"
+
+// Window and motion rejection defaults
+#define BIAS_WINDOW          425   // Samples per window (100 ms at 4250 Hz)
+#define BIAS_WINDOWS         20    // Still windows averaged
+#define BIAS_MAX_WINDOWS     200   // Windows examined before giving up
+#define BIAS_GYRO_NOISE      0.5f  // Gyro standard deviation limit within a window (deg/sec)
+#define BIAS_ACCEL_NOISE     10.0f // Accel standard deviation limit within a window (mg)
+#define BIAS_GYRO_SHIFT      0.05f // Gyro window mean limit from the running average (deg/sec)
+#define BIAS_ACCEL_SHIFT     2.0f  // Accel window mean limit from the running average (mg)
+#define BIAS_RESTART_WINDOWS 3     // Shifted windows in a row that restart the average
+
+// Longest wait for one data ready edge in collect() (us)
+#define BIAS_TIMEOUT_MICROS  100000
+
+// Quantities corrected by apply()
+#define BIAS_GYRO  0x01
+#define BIAS_ACCEL 0x02
+
+// XG_BIAS ~ ZA_BIAS contents. Each value is the 32-bit word (HIGH << 16 |
+// LOW), i.e. 16.16 fixed point in units of the 16-bit output LSB, added to
+// the output by the device.
+struct ADIS16490_Bias {
+  int32_t gyro[3];
+  int32_t accel[3];
+};
+
+// Collection and write-back counters
+struct ADIS16490_BiasStats {
+  uint16_t windows;        // Windows examined
+  uint16_t accepted;       // Windows in the average
+  uint16_t noisy;          // Windows rejected for their standard deviation
+  uint16_t shifted;        // Windows rejected for their mean
+  uint16_t restarts;       // Times the average started over
+  uint16_t duplicates;     // Reads skipped because DATA_CNT did not advance
+  uint16_t checksumErrors; // Burst reads skipped for a checksum mismatch
+  uint16_t frames;         // Frames of the write-back batch
+  uint16_t naiveFrames;    // Frames regWrite() and a verifying regRead() per register would take
+  uint16_t verifyErrors;   // Registers whose readback did not match
+};
+
+// Sums of one window of samples. Channel order: X/Y/Z gyro, X/Y/Z accel.
+class ADIS16490_Window {
+
+public:
+  ADIS16490_Window() { clear(); }
+
+  void clear();
+  void add(const ADIS16490_Sample &sample);
+
+  // True if no channel's standard deviation exceeds its limit (LSB). The
+  // test n * sum(x^2) - sum(x)^2 > (n * limit)^2 is exact in 64 bits for
+  // windows up to 65535 samples.
+  bool quiet(const float *limits) const;
+
+  float mean(uint8_t channel) const { return (float)sum[channel] / count; }
+
+  int64_t sum[6];
+  int64_t sumSquares[6];
+  uint16_t count;
+
+};
+
+// Bias calibration class definition
+class ADIS16490_BiasCalibration {
+
+public:
+  ADIS16490_BiasCalibration(ADIS16490 &imu);
+
+  // Thresholds and results use the ADIS16490 burst and scale factors, so
+  // other models are rejected at compile time
+  template <class Model>
+  ADIS16490_BiasCalibration(ADIS1649x<Model> &imu)
+    : ADIS16490_BiasCalibration(static_cast<ADIS16490 &>(imu)) {
+    static_assert(ADIS1649x_Base<Model>::burst && ADIS1649x_Base<Model>::scale,
+                  "ADIS16490_BiasCalibration uses the ADIS16490 burst layout and scale factors");
+  }
+
+  // Samples per window, still windows averaged, and windows examined
+  // before collect() gives up
+  void setWindows(uint16_t samples, uint16_t windows, uint16_t maxWindows = BIAS_MAX_WINDOWS);
+
+  // Standard deviation limits within a window and mean limits against the
+  // running average (deg/sec and mg)
+  void setMotionLimits(float gyroNoise, float accelNoise, float gyroShift, float accelShift);
+
+  // Specific force expected while still, in the sensor frame (mg)
+  void setGravity(float x, float y, float z);
+
+  // Clears the average and reads the bias registers in effect.
+  // Returns 1 when complete.
+  int begin();
+
+  // Adds one sample, e.g. from ADIS16490_Capture. Returns 1 once enough
+  // still windows have been averaged.
+  int add(const ADIS16490_Sample &sample);
+
+  // True once enough still windows have been averaged
+  bool done() const { return _stats.accepted >= _windows; }
+
+  // Burst reads every output until done() or the window limit, waiting
+  // on data ready. The bus must not be in use by a capture ISR.
+  // Returns 1 when enough still windows were found.
+  int collect();
+
+  // Offset of the average from the expected outputs (zero rate, gravity)
+  // in bias register units. Returns 1 if any window was accepted.
+  int offset(ADIS16490_Bias &offset) const;
+
+  // Reads or writes all six bias registers in one batch; write() reads
+  // them back. Return 1 when complete / when the readback matches.
+  int read(ADIS16490_Bias &bias);
+  int write(const ADIS16490_Bias &bias, uint8_t quantities = BIAS_GYRO | BIAS_ACCEL);
+
+  // Subtracts the offset from the registers read by begin() for the
+  // selected quantities and writes them. Returns 1 when they read back.
+  int apply(uint8_t quantities = BIAS_GYRO);
+
+  // begin(), collect(), and apply() in one call
+  int run(uint8_t quantities = BIAS_GYRO);
+
+  // Registers read by begin(), and the last ones written
+  const ADIS16490_Bias &initial() const { return _initial; }
+  const ADIS16490_Bias &written() const { return _written; }
+
+  const ADIS16490_BiasStats &stats() const { return _stats; }
+
+private:
+  // Checks the finished window and adds it to the average
+  void closeWindow();
+
+  ADIS16490 *_imu;
+  uint16_t _windowSamples;
+  uint16_t _windows;
+  uint16_t _maxWindows;
+  float _noise[6];       // Standard deviation limits (LSB)
+  float _shift[6];       // Mean limits (LSB)
+  float _expected[6];    // Expected outputs (LSB)
+  ADIS16490_Bias _initial;
+  ADIS16490_Bias _written;
+  ADIS16490_BiasStats _stats;
+
+  // Current window and accepted totals
+  ADIS16490_Window _window;
+  int64_t _total[6];
+  uint32_t _totalCount;
+  uint8_t _shiftedRun;
+
+};
+
+// Tumble calibration defaults
+#define TUMBLE_WINDOW          425    // Samples per window (100 ms at 4250 Hz)
+#define TUMBLE_MIN_WINDOWS     10     // Still windows that make a position
+#define TUMBLE_MAX_POSITIONS   16     // Positions recorded
+#define TUMBLE_STILL_RATE      1.0f   // Gyro mean limit for a still window (deg/sec)
+#define TUMBLE_FACE_TOLERANCE  200.0f // Off-axis gravity limit for a face (mg, about 11 degrees)
+#define TUMBLE_ANGLE_TOLERANCE 15.0f  // Off-axis and angle error limit for a move (degrees)
+#define TUMBLE_BASE_RATE       4250.0f // Internal sample clock (Hz)
+
+// Faces, named by the accel axis that reads 1 g and its sign
+#define TUMBLE_X_POS 0
+#define TUMBLE_X_NEG 1
+#define TUMBLE_Y_POS 2
+#define TUMBLE_Y_NEG 3
+#define TUMBLE_Z_POS 4
+#define TUMBLE_Z_NEG 5
+#define TUMBLE_FACES 6
+
+// Software compensation: truth = matrix * (output - offset), in output
+// LSB. Offsets are in the 32-bit output scale (half an LSB above the mean
+// of the truncated 16-bit outputs).
+struct ADIS16490_ScaleModel {
+  float gyro[3][3];
+  float gyroOffset[3];
+  float accel[3][3];
+  float accelOffset[3];
+};
+
+// Tumble progress, fit, and write-back counters
+struct ADIS16490_TumbleStats {
+  uint16_t windows;           // Windows examined
+  uint16_t still;             // Still windows
+  uint8_t positions;          // Positions recorded
+  uint8_t faces;              // Bit per face seen (1 << TUMBLE_X_POS ...)
+  uint8_t rejectedPositions;  // Still segments not resting on a face
+  uint8_t moves;              // Moves recorded
+  uint8_t moveAxes;           // Bit per body axis rotated about
+  uint8_t rejectedMoves;      // Moves not about a single axis by a multiple of 90 degrees
+  uint16_t duplicates;        // Samples skipped because DATA_CNT did not advance
+  uint16_t checksumErrors;    // Burst reads skipped for a checksum mismatch (collect() only)
+  uint32_t lost;              // Outputs missing between samples, filled from the next one
+  float accelResidual;        // RMS fit residual (mg)
+  float gyroResidual;         // RMS fit residual (degrees)
+  uint16_t frames;            // Frames of the write-back batch
+  uint16_t naiveFrames;       // Frames regWrite() and a verifying regRead() per register would take
+  uint16_t verifyErrors;      // Registers whose readback did not match
+};
+
+// Tumble calibration class definition
+class ADIS16490_TumbleCalibration {
+
+public:
+  ADIS16490_TumbleCalibration(ADIS16490 &imu);
+
+  // The fit reads ADIS16490 bursts and scale factors; other models fail to
+  // compile
+  template <class Model>
+  ADIS16490_TumbleCalibration(ADIS1649x<Model> &imu)
+    : ADIS16490_TumbleCalibration(static_cast<ADIS16490 &>(imu)) {
+    static_assert(ADIS1649x_Base<Model>::burst && ADIS1649x_Base<Model>::scale,
+                  "ADIS16490_TumbleCalibration uses the ADIS16490 burst layout and scale factors");
+  }
+
+  // Samples per window and still windows needed for a position
+  void setWindows(uint16_t samples, uint16_t minWindows);
+
+  // Output rate used to integrate the gyro (Hz). begin() sets it from
+  // DEC_RATE and the internal clock; call this after begin() when a sync
+  // input sets the rate, e.g. with ADIS16490_RateManager::rate().
+  void setSampleRate(float hz) { _period = 1.0f / hz; }
+
+  // Standard deviation limits within a window (deg/sec, mg), gyro mean
+  // limit (deg/sec), and accel change between windows (mg) for still
+  // windows
+  void setMotionLimits(float gyroNoise, float accelNoise, float stillRate, float accelShift);
+
+  // Clears the positions and reads the scale, bias, and DEC_RATE
+  // registers in effect. Returns 1 when complete.
+  int begin();
+
+  // Adds one sample, e.g. from ADIS16490_Capture. DATA_CNT weights the
+  // gyro integral: a sample after a gap also stands in for the outputs
+  // missed, and a repeated count is skipped. Returns 1 once the tumble is
+  // complete.
+  int add(const ADIS16490_Sample &sample);
+
+  // True once all six faces and moves about all three axes are recorded
+  bool complete() const { return _stats.faces == 0x3F && _stats.moveAxes == 0x07; }
+
+  // Burst reads every output until complete() or timeoutMicros, waiting on
+  // data ready. The bus must not be in use by a capture ISR.
+  // Returns 1 when the tumble is complete.
+  int collect(uint32_t timeoutMicros);
+
+  // Fits both sensors and sets the model for the registers in effect.
+  // Returns 1 when complete, 0 if the tumble is not.
+  int solve();
+
+  // Writes the fitted scale factors of the selected quantities to
+  // X_GYRO_SCALE ~ Z_ACCL_SCALE in one batch and moves them out of the
+  // model. Returns 1 when they read back as written.
+  int apply(uint8_t quantities = BIAS_GYRO | BIAS_ACCEL);
+
+  // Fitted output = S * truth + b for the registers read by begin(), with
+  // b in the 32-bit output scale (LSB)
+  const float (*gyroMatrix() const)[3] { return _gyroS; }
+  const float (*accelMatrix() const)[3] { return _accelS; }
+  const float *gyroOffset() const { return _gyroB; }
+  const float *accelOffset() const { return _accelB; }
+
+  // Compensation for the registers in effect, e.g. saved in EEPROM and
+  // restored with setModel() at startup
+  const ADIS16490_ScaleModel &model() const { return _model; }
+  void setModel(const ADIS16490_ScaleModel &model) { _model = model; }
+
+  // Applies the model to 16-bit or 32-bit outputs. Gyro in deg/sec, accel
+  // in mg.
+  void compensate(const ADIS16490_Sample &sample, float gyro[3], float accel[3]) const;
+  void compensate(const ADIS16490_HighRes &data, float gyro[3], float accel[3]) const;
+
+  const ADIS16490_TumbleStats &stats() const { return _stats; }
+
+private:
+  // Forgets the positions and moves
+  void clear();
+
+  // Classifies the finished window and extends or ends the still segment
+  void closeWindow();
+
+  // Adds a still window to the segment or the position it became
+  void commit(const ADIS16490_Window &window);
+
+  // Ends the still segment
+  void endSegment();
+
+  // Records the current still segment as a position
+  void addPosition();
+
+  // Rounds a measured move (degrees) to a multiple of 90 degrees about one
+  // axis. Returns false if it is not close to one.
+  bool nominalMove(const float *measured, float *nominal) const;
+
+  // Sets the model from S and b with the device scale change d per axis
+  void setModel(const float S[3][3], const float *b, const float *d, const int32_t *bias,
+                float M[3][3], float *offset);
+
+  ADIS16490 *_imu;
+  uint16_t _windowSamples;
+  uint16_t _minWindows;
+  float _period;
+  float _noise[6];
+  float _stillRate;
+  float _accelShift;
+
+  // Registers read by begin(): scale (X/Y/Z gyro, X/Y/Z accel) and bias
+  int16_t _scale[6];
+  int32_t _bias[6];
+
+  // Window, still segment (all still windows but the first and the
+  // latest, which may hold the start or end of a move), and running gyro
+  // sums for integration
+  ADIS16490_Window _window;
+  float _lastMean[3];
+  bool _segment;
+  bool _pending;
+  ADIS16490_Window _pendingWindow;
+  int64_t _segmentSum[6];
+  uint32_t _segmentCount;
+  uint16_t _segmentWindows;
+  int8_t _position;        // Position being extended, -1 if none
+  int64_t _gyroSum[3];
+  uint32_t _gyroCount;     // Output periods integrated
+  uint16_t _lastCount;     // DATA_CNT of the previous sample
+  bool _primed;            // _lastCount is valid
+
+  // Positions: face and sums over their still windows
+  uint8_t _face[TUMBLE_MAX_POSITIONS];
+  int64_t _positionSum[TUMBLE_MAX_POSITIONS][6];
+  uint32_t _positionCount[TUMBLE_MAX_POSITIONS];
+
+  // Moves: gyro sums and samples from one position to the next
+  int64_t _anchorSum[3];
+  uint32_t _anchorCount;
+  int64_t _moveSum[TUMBLE_MAX_POSITIONS][3];
+  uint32_t _moveCount[TUMBLE_MAX_POSITIONS];
+
+  float _gyroS[3][3], _accelS[3][3];
+  float _gyroB[3], _accelB[3];
+  ADIS16490_ScaleModel _model;
+  ADIS16490_TumbleStats _stats;
+
+};
+
+#endif
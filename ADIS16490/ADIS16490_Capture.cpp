@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Capture.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Interrupt-driven sample capture for the ADIS16490. See ADIS16490_Capture.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "ADIS16490_Capture.h"
+
+ADIS16490_Capture *ADIS16490_Capture::_instance = 0;
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// imu - driver instance used for burst reads
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_Capture::ADIS16490_Capture(ADIS16490 &imu) {
+  _imu = &imu;
+  _pin = -1;
+  _checksumErrors = 0;
+  _captured = 0;
+  _timeSync = 0;
+  _timeSyncInterval = 0;
+  _timeSyncCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Attaches the capture ISR to the data ready pin on the rising edge.
+// Only one capture instance can be attached at a time.
+// Returns 1 when complete, 0 if the bus has no data ready pin.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_Capture::begin() {
+  _sequence.reset();
+  _pin = _imu->bus()->dataReadyPin();
+  if (_pin < 0)
+    return(0);
+  _instance = this;
+#ifdef ARDUINO
+  attachInterrupt(digitalPinToInterrupt(_pin), isr, RISING);
+#endif
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Detaches the capture ISR. Samples already captured remain readable.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Capture::end() {
+#ifdef ARDUINO
+  if (_pin >= 0)
+    detachInterrupt(digitalPinToInterrupt(_pin));
+#endif
+  if (_instance == this)
+    _instance = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads one burst frame straight into the next free ring buffer slot.
+// If the buffer is full the sample is skipped and counted as an overrun.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Capture::service() {
+  ADIS16490_Sample *slot = _ring.reserve();
+  if (!slot)
+    return;
+  if (!_imu->burstRead(*slot)) {
+    _checksumErrors++;
+    return;
+  }
+  if (!_sequence.check(*slot))
+    return;
+  // The burst start stands in for the data ready edge time
+  uint32_t edge = slot->timestamp;
+  uint16_t dataCount = slot->dataCount;
+  _ring.commit();
+  _captured++;
+  if (_timeSync && ++_timeSyncCount >= _timeSyncInterval) {
+    _timeSyncCount = 0;
+    _timeSync->sync(*_imu, edge, dataCount);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Attaches a time correlation module fed from the capture ISR
+////////////////////////////////////////////////////////////////////////////
+// sync - correlation module, or 0 to detach
+// interval - samples between correlation points
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Capture::setTimeSync(ADIS16490_TimeSync *sync, uint16_t interval) {
+  _timeSyncInterval = interval ? interval : 1;
+  _timeSyncCount = 0;
+  _timeSync = sync;
+}
+
+void ADIS16490_Capture::isr() {
+  if (_instance)
+    _instance->service();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Clears the continuity counters. The next sample starts a new sequence.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_SequenceCheck::reset() {
+  _stats = ADIS16490_SequenceStats();
+  _lastTimestamp = 0;
+  _lastCount = 0;
+  _primed = false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Compares DATA_CNT and the read time with the previous sample.
+// Returns false if the sample repeats the previous output.
+////////////////////////////////////////////////////////////////////////////
+// sample - captured sample
+////////////////////////////////////////////////////////////////////////////
+bool ADIS16490_SequenceCheck::check(const ADIS16490_Sample &sample) {
+  _stats.samples++;
+  uint16_t step = sample.dataCount - _lastCount; // DATA_CNT wraps at 16 bits
+  uint32_t interval = sample.timestamp - _lastTimestamp;
+  bool primed = _primed;
+  _primed = true;
+  if (primed && step == 0) {
+    _stats.duplicates++;
+    return false;
+  }
+  _lastCount = sample.dataCount;
+  _lastTimestamp = sample.timestamp;
+  if (!primed)
+    return true;
+  if (step > 1) {
+    _stats.gaps++;
+    _stats.lost += step - 1;
+    return true;
+  }
+  // Jitter only means something between consecutive outputs
+  uint32_t ns = interval * 1000;
+  uint32_t jitter = (ns > _periodNs ? ns - _periodNs : _periodNs - ns) / 1000;
+  _stats.lastJitter = jitter;
+  if (jitter > _stats.maxJitter)
+    _stats.maxJitter = jitter;
+  return true;
+}
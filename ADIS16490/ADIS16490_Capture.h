@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Capture.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Interrupt-driven sample capture for the ADIS16490. The data ready ISR performs one burst read
+//  straight into a slot of a lock-free ring buffer; loop() drains the buffer at its own pace.
+//  No formatting or serial output happens in interrupt context, so samples are not lost at the
+//  full output rate as long as loop() keeps up on average.
+//
+//  Every captured sample carries DATA_CNT from the same burst. ADIS16490_SequenceCheck compares it
+//  with the previous one to count outputs read twice or skipped by a late ISR, and the read time
+//  against the output period to measure jitter.
+//
+//  While capture is running the ISR owns the SPI bus. Call end() before using regRead() or
+//  regWrite() from loop().
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Capture_h
+#define ADIS16490_Capture_h
+#include "ADIS16490.h"
+#include "ADIS1649x.h"
+#include "ADIS16490_RingBuffer.h"
+#include "ADIS16490_TimeSync.h"
+
+// Ring buffer depth in samples (power of two). At 4250 Hz, 256 samples
+// give loop() ~60 ms of slack.
+#ifndef CAPTURE_DEPTH
+#define CAPTURE_DEPTH 256
+#endif
+
+// Nominal output period at the default DEC_RATE (ns)
+#define CAPTURE_PERIOD_NS 235294
+
+// Data counter continuity counters
+struct ADIS16490_SequenceStats {
+  uint32_t samples;    // Samples checked
+  uint32_t gaps;       // Reads where DATA_CNT advanced by more than one
+  uint32_t lost;       // Output samples skipped in those gaps
+  uint32_t duplicates; // Reads where DATA_CNT did not advance
+  uint32_t lastJitter; // |read interval - output period| of the last consecutive pair (us)
+  uint32_t maxJitter;  // Worst jitter since reset() (us)
+};
+
+// Tracks DATA_CNT across captured samples. A late ISR either reads the same
+// output twice (duplicate) or misses one (gap); read timing against the
+// output period gives the jitter.
+class ADIS16490_SequenceCheck {
+
+public:
+  ADIS16490_SequenceCheck() : _periodNs(CAPTURE_PERIOD_NS) { reset(); }
+
+  // Clears the counters and forgets the previous sample
+  void reset();
+
+  // Output period used for the jitter figure (ns)
+  void setPeriod(uint32_t periodNs) { _periodNs = periodNs; }
+
+  // Updates the counters with the next sample. Returns false if it repeats
+  // the previous DATA_CNT.
+  bool check(const ADIS16490_Sample &sample);
+
+  const ADIS16490_SequenceStats &stats() const { return _stats; }
+
+private:
+  ADIS16490_SequenceStats _stats;
+  uint32_t _periodNs;
+  uint32_t _lastTimestamp;
+  uint16_t _lastCount;
+  bool _primed;
+
+};
+
+// ADIS16490 capture class definition
+class ADIS16490_Capture {
+
+public:
+  ADIS16490_Capture(ADIS16490 &imu);
+
+  // Models with another burst layout are rejected at compile time
+  template <class Model>
+  ADIS16490_Capture(ADIS1649x<Model> &imu)
+    : ADIS16490_Capture(static_cast<ADIS16490 &>(imu)) {
+    static_assert(ADIS1649x_Base<Model>::burst,
+                  "ADIS16490_Capture decodes the ADIS16490 burst layout");
+  }
+
+  // Attaches the capture ISR to the data ready pin (rising edge).
+  // Returns 1 on success, 0 if the bus has no data ready pin.
+  int begin();
+
+  // Detaches the capture ISR
+  void end();
+
+  // Capture routine run on each data ready edge. Called by the ISR on
+  // target; host code can call it directly.
+  void service();
+
+  // Copies the oldest sample out. Returns false if none are waiting.
+  bool read(ADIS16490_Sample &sample) { return _ring.pop(sample); }
+
+  // Copies up to max samples out. Returns the number copied.
+  size_t drain(ADIS16490_Sample *samples, size_t max) { return _ring.drain(samples, max); }
+
+  // Zero-copy access to the oldest sample (0 if none); release() frees it
+  const ADIS16490_Sample *peek() const { return _ring.peek(); }
+  void release() { _ring.release(); }
+
+  // Number of samples waiting
+  uint16_t available() const { return _ring.available(); }
+
+  // Samples dropped because loop() did not drain the buffer in time
+  uint32_t overruns() const { return _ring.overruns(); }
+
+  // Samples held before overruns start (1 to CAPTURE_DEPTH - 1). Set while
+  // capture is stopped.
+  void setDepth(uint16_t samples) { _ring.setLimit(samples); }
+  uint16_t depth() const { return _ring.capacity(); }
+
+  // Burst reads with a checksum mismatch (discarded)
+  uint32_t checksumErrors() const { return _checksumErrors; }
+
+  // Samples captured since begin()
+  uint32_t captured() const { return _captured; }
+
+  // Adds a TIME_STAMP correlation point to sync every interval samples,
+  // read right after the burst in the same handler (0 detaches)
+  void setTimeSync(ADIS16490_TimeSync *sync, uint16_t interval = 16);
+  ADIS16490_TimeSync *timeSync() const { return _timeSync; }
+
+  // DATA_CNT gap, duplicate, and jitter counters. Duplicates are not
+  // stored; gaps include samples skipped as overruns.
+  ADIS16490_SequenceCheck &sequence() { return _sequence; }
+  const ADIS16490_SequenceStats &sequenceStats() const { return _sequence.stats(); }
+
+private:
+  // Trampoline used by attachInterrupt()
+  static void isr();
+
+  // Instance serviced by isr()
+  static ADIS16490_Capture *_instance;
+
+  ADIS16490 *_imu;
+  int _pin;
+  ADIS16490_RingBuffer<ADIS16490_Sample, CAPTURE_DEPTH> _ring;
+  volatile uint32_t _checksumErrors;
+  volatile uint32_t _captured;
+  ADIS16490_SequenceCheck _sequence;
+  ADIS16490_TimeSync *_timeSync;
+  uint16_t _timeSyncInterval;
+  uint16_t _timeSyncCount;
+
+};
+
+#endif
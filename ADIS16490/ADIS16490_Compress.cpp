@@ -0,0 +1,331 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Compress.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Delta/zigzag/bit-packing block compressor and decompressor for ADIS16490 sample streams. See
+//  ADIS16490_Compress.h for the packet layout.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Compress.h"
+#include "ADIS16490_Stream.h"
+
+// Field order inside a packet
+#define FIELD_TIME   0
+#define FIELD_STATUS 1
+#define FIELD_COUNT  2
+#define FIELD_GYRO   3
+#define FIELD_ACCEL  6
+#define FIELD_TEMP   9
+
+static inline void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t *p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+static inline uint16_t get16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+// Zigzag maps small signed values to small unsigned ones (0, -1, 1, -2 ...)
+static inline uint32_t zigzag32(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag32(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+static inline uint16_t zigzag16(int16_t v) { return (uint16_t)(((uint16_t)v << 1) ^ (uint16_t)(v >> 15)); }
+static inline int16_t unzigzag16(uint16_t v) { return (int16_t)((v >> 1) ^ -(int16_t)(v & 1)); }
+
+// Bits needed to hold v
+static inline uint8_t bitWidth(uint32_t v) {
+  uint8_t width = 0;
+  while (v) {
+    width++;
+    v >>= 1;
+  }
+  return width;
+}
+
+// Zigzag-coded residual of every field of sample i (i >= 1) in a block
+static void residuals(const ADIS16490_Sample *block, uint8_t i, uint32_t tsStep, uint16_t countStep,
+                      uint32_t *out) {
+  const ADIS16490_Sample &cur = block[i];
+  const ADIS16490_Sample &prev = block[i - 1];
+  uint32_t tsDelta = cur.timestamp - prev.timestamp;
+  uint16_t countDelta = cur.dataCount - prev.dataCount;
+  if (i > 1) {
+    tsStep = prev.timestamp - block[i - 2].timestamp;
+    countStep = prev.dataCount - block[i - 2].dataCount;
+  }
+  out[FIELD_TIME] = zigzag32((int32_t)(tsDelta - tsStep));
+  out[FIELD_STATUS] = zigzag16((int16_t)(cur.status - prev.status));
+  out[FIELD_COUNT] = zigzag16((int16_t)(uint16_t)(countDelta - countStep));
+  for (int axis = 0; axis < 3; axis++) {
+    out[FIELD_GYRO + axis] = zigzag16((int16_t)(cur.gyro[axis] - prev.gyro[axis]));
+    out[FIELD_ACCEL + axis] = zigzag16((int16_t)(cur.accel[axis] - prev.accel[axis]));
+  }
+  out[FIELD_TEMP] = zigzag16((int16_t)(cur.temp - prev.temp));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// blockSize - samples per packet; clamped to 1..COMPRESS_BLOCK
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_Compressor::ADIS16490_Compressor(uint8_t blockSize) {
+  if (blockSize < 1)
+    blockSize = 1;
+  if (blockSize > COMPRESS_BLOCK)
+    blockSize = COMPRESS_BLOCK;
+  _blockSize = blockSize;
+  _count = 0;
+  _sequence = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Buffers one sample and emits a packet when the block is full
+////////////////////////////////////////////////////////////////////////////
+// sample - sample to compress
+// packet - destination, COMPRESS_MAX_PACKET bytes
+// return - packet length, or 0 if the block is not yet full
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_Compressor::add(const ADIS16490_Sample &sample, uint8_t *packet) {
+  _block[_count++] = sample;
+  if (_count < _blockSize)
+    return 0;
+  return flush(packet);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Encodes the buffered samples. The residuals are computed twice, once to
+// find the field widths and once to pack them, so no residual buffer is
+// needed.
+////////////////////////////////////////////////////////////////////////////
+// packet - destination, COMPRESS_MAX_PACKET bytes
+// return - packet length, or 0 if no samples are pending
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_Compressor::flush(uint8_t *packet) {
+  if (_count == 0)
+    return 0;
+
+  const ADIS16490_Sample &key = _block[0];
+  uint32_t tsStep = 0;
+  uint16_t countStep = 0;
+  if (_count > 1) {
+    tsStep = _block[1].timestamp - key.timestamp;
+    countStep = _block[1].dataCount - key.dataCount;
+  }
+
+  // Header and keyframe
+  packet[0] = COMPRESS_SYNC0;
+  packet[1] = COMPRESS_SYNC1;
+  put16(packet + 2, _sequence++);
+  packet[4] = _count;
+  put32(packet + 5, key.timestamp);
+  put16(packet + 9, key.status);
+  put16(packet + 11, key.dataCount);
+  for (int axis = 0; axis < 3; axis++) {
+    put16(packet + 13 + 2 * axis, key.gyro[axis]);
+    put16(packet + 19 + 2 * axis, key.accel[axis]);
+  }
+  put16(packet + 25, key.temp);
+  put32(packet + 27, tsStep);
+  put16(packet + 31, countStep);
+
+  // Widths from the largest residual of each field
+  uint32_t res[COMPRESS_FIELDS];
+  uint32_t merged[COMPRESS_FIELDS] = {0};
+  for (uint8_t i = 1; i < _count; i++) {
+    residuals(_block, i, tsStep, countStep, res);
+    for (int f = 0; f < COMPRESS_FIELDS; f++)
+      merged[f] |= res[f];
+  }
+  uint8_t *widths = packet + 33;
+  for (int f = 0; f < COMPRESS_FIELDS; f++)
+    widths[f] = bitWidth(merged[f]);
+
+  // Bit-pack the residuals, LSB first
+  uint8_t *out = packet + COMPRESS_HEADER;
+  uint64_t acc = 0;
+  uint8_t bits = 0;
+  for (uint8_t i = 1; i < _count; i++) {
+    residuals(_block, i, tsStep, countStep, res);
+    for (int f = 0; f < COMPRESS_FIELDS; f++) {
+      acc |= (uint64_t)res[f] << bits;
+      bits += widths[f];
+      while (bits >= 8) {
+        *out++ = acc & 0xFF;
+        acc >>= 8;
+        bits -= 8;
+      }
+    }
+  }
+  if (bits)
+    *out++ = acc & 0xFF;
+
+  size_t length = out - packet;
+  put16(out, ADIS16490_streamCrc(packet + 2, length - 2));
+  _count = 0;
+  return length + 2;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Clears the decompressor state
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Decompressor::reset() {
+  _length = 0;
+  _sequence = 0;
+  _synced = false;
+  _stats = ADIS16490_CompressStats();
+}
+
+void ADIS16490_Decompressor::discard(size_t count) {
+  for (size_t i = count; i < _length; i++)
+    _buffer[i - count] = _buffer[i];
+  _length -= count;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Feeds one byte into the decompressor. After a bad packet the buffered
+// bytes are rescanned from the next byte so a packet starting inside the
+// bad one is still found.
+////////////////////////////////////////////////////////////////////////////
+// byte - received byte
+// return - samples decoded, or 0 if no packet completed
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_Decompressor::push(uint8_t byte) {
+  _buffer[_length++] = byte;
+
+  while (_length) {
+    // Hunt for the sync word
+    if (_buffer[0] != COMPRESS_SYNC0 || (_length > 1 && _buffer[1] != COMPRESS_SYNC1)) {
+      _stats.skipped++;
+      discard(1);
+      continue;
+    }
+    if (_length < COMPRESS_HEADER)
+      return 0;
+
+    // Packet length follows from the sample count and field widths
+    uint8_t count = _buffer[4];
+    const uint8_t *widths = _buffer + 33;
+    uint32_t bitsPerSample = 0;
+    bool valid = count >= 1 && count <= COMPRESS_BLOCK;
+    for (int f = 0; f < COMPRESS_FIELDS; f++) {
+      if (widths[f] > (f == FIELD_TIME ? 32 : 16))
+        valid = false;
+      bitsPerSample += widths[f];
+    }
+    if (!valid) {
+      _stats.crcErrors++;
+      discard(1);
+      continue;
+    }
+    size_t length = COMPRESS_HEADER + ((count - 1) * bitsPerSample + 7) / 8 + 2;
+    if (_length < length)
+      return 0;
+
+    size_t decoded = decode(length);
+    if (!decoded) {
+      _stats.crcErrors++;
+      discard(1);
+      continue;
+    }
+    discard(length);
+    return decoded;
+  }
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Verifies the CRC and rebuilds the block from the keyframe and residuals
+////////////////////////////////////////////////////////////////////////////
+// length - packet length including sync and CRC
+// return - samples decoded, or 0 on a CRC mismatch
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_Decompressor::decode(size_t length) {
+  const uint8_t *p = _buffer;
+  if (ADIS16490_streamCrc(p + 2, length - 4) != get16(p + length - 2))
+    return 0;
+
+  uint16_t sequence = get16(p + 2);
+  if (_synced)
+    _stats.lost += (uint16_t)(sequence - _sequence - 1);
+  _sequence = sequence;
+  _synced = true;
+
+  uint8_t count = p[4];
+  ADIS16490_Sample &key = _samples[0];
+  key.timestamp = get32(p + 5);
+  key.status = get16(p + 9);
+  key.dataCount = get16(p + 11);
+  for (int axis = 0; axis < 3; axis++) {
+    key.gyro[axis] = get16(p + 13 + 2 * axis);
+    key.accel[axis] = get16(p + 19 + 2 * axis);
+  }
+  key.temp = get16(p + 25);
+  key.reserved = 0;
+  uint32_t tsStep = get32(p + 27);
+  uint16_t countStep = get16(p + 31);
+  const uint8_t *widths = p + 33;
+
+  const uint8_t *in = p + COMPRESS_HEADER;
+  uint64_t acc = 0;
+  uint8_t bits = 0;
+  for (uint8_t i = 1; i < count; i++) {
+    const ADIS16490_Sample &prev = _samples[i - 1];
+    ADIS16490_Sample &cur = _samples[i];
+    uint32_t res[COMPRESS_FIELDS];
+    for (int f = 0; f < COMPRESS_FIELDS; f++) {
+      while (bits < widths[f]) {
+        acc |= (uint64_t)*in++ << bits;
+        bits += 8;
+      }
+      res[f] = widths[f] ? (uint32_t)(acc & ((1ULL << widths[f]) - 1)) : 0;
+      acc >>= widths[f];
+      bits -= widths[f];
+    }
+    if (i > 1) {
+      tsStep = prev.timestamp - _samples[i - 2].timestamp;
+      countStep = prev.dataCount - _samples[i - 2].dataCount;
+    }
+    cur.timestamp = prev.timestamp + tsStep + unzigzag32(res[FIELD_TIME]);
+    cur.status = prev.status + unzigzag16(res[FIELD_STATUS]);
+    cur.dataCount = prev.dataCount + countStep + unzigzag16(res[FIELD_COUNT]);
+    for (int axis = 0; axis < 3; axis++) {
+      cur.gyro[axis] = prev.gyro[axis] + unzigzag16(res[FIELD_GYRO + axis]);
+      cur.accel[axis] = prev.accel[axis] + unzigzag16(res[FIELD_ACCEL + axis]);
+    }
+    cur.temp = prev.temp + unzigzag16(res[FIELD_TEMP]);
+    cur.reserved = 0;
+  }
+
+  _stats.packets++;
+  _stats.samples += count;
+  return count;
+}
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Compress.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Lossless block compressor for ADIS16490 sample streams on bandwidth-limited links. Consecutive
+//  samples differ by a few LSBs, so each block stores its first sample in full (a keyframe) and
+//  every following sample as per-field deltas, zigzag mapped and bit-packed at the smallest width
+//  that holds the block's largest delta. Timestamp and DATA_CNT use delta-of-delta coding so a
+//  steady rate costs zero bits. A lost or corrupted packet costs at most one block.
+//
+//  Packet layout (little-endian):
+//
+//    size  field
+//    2     sync word 0xA5 0x5B
+//    2     packet sequence number
+//    1     samples in the block (1..COMPRESS_BLOCK)
+//    22    keyframe: timestamp, DIAG_STS, DATA_CNT, X/Y/Z_GYRO_OUT, X/Y/Z_ACCL_OUT, TEMP_OUT
+//    4     timestamp step from the keyframe to the second sample
+//    2     DATA_CNT step from the keyframe to the second sample
+//    10    bit width per field (timestamp, status, count, gyro x3, accel x3, temp)
+//    n     bit-packed fields of samples 2..count, LSB first
+//    2     CRC-16/CCITT-FALSE over everything after the sync word
+//
+//  The compressor and decompressor use only fixed-size member buffers.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Compress_h
+#define ADIS16490_Compress_h
+#include "ADIS16490.h"
+
+// Samples per block (keyframe interval). At most 255.
+#ifndef COMPRESS_BLOCK
+#define COMPRESS_BLOCK 32
+#endif
+
+#define COMPRESS_SYNC0  0xA5
+#define COMPRESS_SYNC1  0x5B
+#define COMPRESS_FIELDS 10
+#define COMPRESS_HEADER (2 + 2 + 1 + 22 + 4 + 2 + COMPRESS_FIELDS)
+
+// Worst-case packet size: 32 bits for the timestamp and 16 for the rest
+#define COMPRESS_MAX_PACKET (COMPRESS_HEADER + ((COMPRESS_BLOCK - 1) * (32 + 9 * 16) + 7) / 8 + 2)
+
+// Block compressor
+class ADIS16490_Compressor {
+
+public:
+  // blockSize - samples per block, 1..COMPRESS_BLOCK
+  ADIS16490_Compressor(uint8_t blockSize = COMPRESS_BLOCK);
+
+  // Adds one sample. When the block fills, the packet is written to packet
+  // (COMPRESS_MAX_PACKET bytes) and its length returned; otherwise 0.
+  size_t add(const ADIS16490_Sample &sample, uint8_t *packet);
+
+  // Writes a packet for a partially filled block. Returns its length, or 0
+  // if no samples are pending.
+  size_t flush(uint8_t *packet);
+
+  // Samples waiting for the block to fill
+  uint8_t pending() const { return _count; }
+
+private:
+  ADIS16490_Sample _block[COMPRESS_BLOCK];
+  uint8_t _blockSize;
+  uint8_t _count;
+  uint16_t _sequence;
+
+};
+
+// Decompressor counters
+struct ADIS16490_CompressStats {
+  uint32_t packets;   // Packets with a valid CRC
+  uint32_t samples;   // Samples decoded
+  uint32_t crcErrors; // Packets discarded for a CRC mismatch or bad header
+  uint32_t skipped;   // Bytes discarded while searching for sync
+  uint32_t lost;      // Packets missing according to the sequence number
+};
+
+// Packet decompressor
+class ADIS16490_Decompressor {
+
+public:
+  ADIS16490_Decompressor() { reset(); }
+
+  // Clears buffered bytes and counters
+  void reset();
+
+  // Feeds one received byte. Returns the number of samples decoded when it
+  // completes a valid packet (available from samples()), 0 otherwise.
+  size_t push(uint8_t byte);
+
+  // Samples from the last completed packet
+  const ADIS16490_Sample *samples() const { return _samples; }
+
+  const ADIS16490_CompressStats &stats() const { return _stats; }
+
+private:
+  // Checks and decodes a complete packet of length bytes
+  size_t decode(size_t length);
+
+  // Drops count bytes from the front of the buffer
+  void discard(size_t count);
+
+  uint8_t _buffer[COMPRESS_MAX_PACKET];
+  size_t _length;
+  ADIS16490_Sample _samples[COMPRESS_BLOCK];
+  uint16_t _sequence;
+  bool _synced;
+  ADIS16490_CompressStats _stats;
+
+};
+
+#endif
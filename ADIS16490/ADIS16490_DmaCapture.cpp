@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_DmaCapture.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Non-blocking burst capture for the ADIS16490. See ADIS16490_DmaCapture.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_DmaCapture.h"
+
+ADIS16490_DmaCapture *ADIS16490_DmaCapture::_instance = 0;
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// imu - driver instance used for burst reads
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_DmaCapture::ADIS16490_DmaCapture(ADIS16490 &imu) {
+  _imu = &imu;
+  _pin = -1;
+  _callback = 0;
+  _context = 0;
+  _state = DMA_IDLE;
+  _edge = 0;
+  _slot = 0;
+  _stats = ADIS16490_DmaStats();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Attaches the engine to the data ready pin on the rising edge. Only one
+// engine can be attached at a time.
+// Returns 1 when attached, 0 if the bus has no data ready pin.
+////////////////////////////////////////////////////////////////////////////
+// callback - optional completion callback (DMA interrupt context)
+// context - passed through to callback
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_DmaCapture::begin(Callback callback, void *context) {
+  _callback = callback;
+  _context = context;
+  _stats = ADIS16490_DmaStats();
+  _sequence.reset();
+  _pin = _imu->bus()->dataReadyPin();
+  if (_pin < 0)
+    return(0);
+  _instance = this;
+#ifdef ARDUINO
+  attachInterrupt(digitalPinToInterrupt(_pin), isr, RISING);
+#endif
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Detaches from the data ready pin
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_DmaCapture::end() {
+#ifdef ARDUINO
+  if (_pin >= 0)
+    detachInterrupt(digitalPinToInterrupt(_pin));
+#endif
+  if (_instance == this)
+    _instance = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Data ready edge: IDLE -> BUSY and start the burst transfer. Edges while
+// BUSY are counted and ignored.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_DmaCapture::onDataReady() {
+  uint32_t edge = _imu->bus()->microsNow();
+  if (_state != DMA_IDLE) {
+    _stats.busySkips++;
+    return;
+  }
+  _state = DMA_BUSY;
+  _edge = edge;
+  _stats.started++;
+  _slot = _ring.reserve();
+  _imu->burstStart(dmaDone, this);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// DMA complete: release CS, decode into the reserved ring slot (or a
+// scratch record if the ring was full), publish it, BUSY -> IDLE. The
+// data ready ISR can preempt this handler, so the engine stays BUSY until
+// the slot is committed and the callback has returned; an edge before then
+// is skipped rather than reserving the same slot and restarting the DMA
+// into the sample being published.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_DmaCapture::complete() {
+  ADIS16490_Sample *sample = _slot ? _slot : &_scratch;
+  int good = _imu->burstFinish(*sample);
+  sample->timestamp = _edge;
+  uint32_t latency = _imu->bus()->microsNow() - _edge;
+  _stats.lastLatency = latency;
+  if (latency > _stats.maxLatency)
+    _stats.maxLatency = latency;
+  if (!good) {
+    _stats.checksumErrors++;
+  } else {
+    _stats.completed++;
+    if (_sequence.check(*sample)) {
+      if (_slot)
+        _ring.commit();
+      if (_callback)
+        _callback(*sample, _context);
+    }
+  }
+  _state = DMA_IDLE;
+}
+
+void ADIS16490_DmaCapture::isr() {
+  if (_instance)
+    _instance->onDataReady();
+}
+
+void ADIS16490_DmaCapture::dmaDone(void *context) {
+  ((ADIS16490_DmaCapture *)context)->complete();
+}
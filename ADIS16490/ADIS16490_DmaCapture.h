@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_DmaCapture.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Non-blocking burst capture for the ADIS16490. On each data ready edge the engine asserts CS and
+//  starts a DMA transfer of the complete burst frame, then returns from the interrupt. When the DMA
+//  completes, CS is released, the frame is decoded straight into a ring buffer slot, and an
+//  optional user callback runs. The CPU is free while the frame is on the wire.
+//
+//  Latency is tracked from the data ready edge to transfer completion. Edges that arrive while a
+//  transfer is still in flight are counted and skipped. On host builds the ADIS16490_Sim mock DMA
+//  backend completes transfers in virtual time so the state machine can be exercised on Linux.
+//
+//  While capture is running the engine owns the SPI bus. Call end() and wait for idle() before
+//  using regRead() or regWrite() from loop().
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_DmaCapture_h
+#define ADIS16490_DmaCapture_h
+#include "ADIS16490_Capture.h"
+
+// Capture engine states
+#define DMA_IDLE 0 // Waiting for data ready
+#define DMA_BUSY 1 // Burst transfer in flight
+
+// Capture engine counters
+struct ADIS16490_DmaStats {
+  uint32_t started;        // Transfers started
+  uint32_t completed;      // Transfers completed with a valid checksum
+  uint32_t busySkips;      // Data ready edges ignored because a transfer was in flight
+  uint32_t checksumErrors; // Transfers completed with a bad checksum
+  uint32_t lastLatency;    // Data ready edge to completion of the last transfer (us)
+  uint32_t maxLatency;     // Worst latency since begin() (us)
+};
+
+// ADIS16490 DMA capture class definition
+class ADIS16490_DmaCapture {
+
+public:
+  // Completion callback, run in DMA interrupt context. The engine is still
+  // BUSY while it runs, so data ready edges during it are skipped.
+  typedef void (*Callback)(const ADIS16490_Sample &sample, void *context);
+
+  ADIS16490_DmaCapture(ADIS16490 &imu);
+
+  // Models with another burst layout are rejected at compile time
+  template <class Model>
+  ADIS16490_DmaCapture(ADIS1649x<Model> &imu)
+    : ADIS16490_DmaCapture(static_cast<ADIS16490 &>(imu)) {
+    static_assert(ADIS1649x_Base<Model>::burst,
+                  "ADIS16490_DmaCapture decodes the ADIS16490 burst layout");
+  }
+
+  // Attaches the engine to the data ready pin. callback is optional.
+  // Returns 1 on success, 0 if the bus has no data ready pin (host builds
+  // call onDataReady() directly, e.g. from ADIS16490_Sim::attachDataReady).
+  int begin(Callback callback = 0, void *context = 0);
+
+  // Detaches from the data ready pin. A transfer in flight still completes.
+  void end();
+
+  // Data ready edge handler. Starts a transfer unless one is in flight.
+  void onDataReady();
+
+  // Current state (DMA_IDLE or DMA_BUSY)
+  uint8_t state() const { return _state; }
+  bool idle() const { return _state == DMA_IDLE; }
+
+  // Engine counters
+  const ADIS16490_DmaStats &stats() const { return _stats; }
+
+  // Copies the oldest sample out. Returns false if none are waiting.
+  bool read(ADIS16490_Sample &sample) { return _ring.pop(sample); }
+
+  // Copies up to max samples out. Returns the number copied.
+  size_t drain(ADIS16490_Sample *samples, size_t max) { return _ring.drain(samples, max); }
+
+  // Zero-copy access to the oldest sample (0 if none); release() frees it
+  const ADIS16490_Sample *peek() const { return _ring.peek(); }
+  void release() { _ring.release(); }
+
+  // Number of samples waiting
+  uint16_t available() const { return _ring.available(); }
+
+  // Samples dropped because loop() did not drain the buffer in time
+  uint32_t overruns() const { return _ring.overruns(); }
+
+  // Samples held before overruns start (1 to CAPTURE_DEPTH - 1). Set while
+  // capture is stopped.
+  void setDepth(uint16_t samples) { _ring.setLimit(samples); }
+  uint16_t depth() const { return _ring.capacity(); }
+
+  // DATA_CNT gap, duplicate, and jitter counters. Duplicates are not
+  // stored or passed to the callback.
+  ADIS16490_SequenceCheck &sequence() { return _sequence; }
+  const ADIS16490_SequenceStats &sequenceStats() const { return _sequence.stats(); }
+
+private:
+  // Trampolines for attachInterrupt() and the bus completion callback
+  static void isr();
+  static void dmaDone(void *context);
+
+  // Instance serviced by isr()
+  static ADIS16490_DmaCapture *_instance;
+
+  // Completes the transfer in flight
+  void complete();
+
+  ADIS16490 *_imu;
+  int _pin;
+  Callback _callback;
+  void *_context;
+  volatile uint8_t _state;
+  uint32_t _edge;
+  ADIS16490_Sample *_slot;
+  ADIS16490_Sample _scratch;
+  ADIS16490_DmaStats _stats;
+  ADIS16490_SequenceCheck _sequence;
+  ADIS16490_RingBuffer<ADIS16490_Sample, CAPTURE_DEPTH> _ring;
+
+};
+
+#endif
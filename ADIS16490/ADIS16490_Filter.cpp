@@ -0,0 +1,515 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Filter.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Software post-filtering for ADIS16490 samples. See ADIS16490_Filter.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Filter.h"
+#include <math.h>
+#include <string.h>
+
+// Rounds a fixed-point value to the nearest multiple of 2^shift, then
+// drops the fraction
+static inline int32_t roundShift(int64_t value, uint8_t shift) {
+  return (int32_t)((value + ((int64_t)1 << (shift - 1))) >> shift);
+}
+
+// Rounded division, halves away from zero
+static inline int32_t roundDivide(int64_t value, int64_t divisor) {
+  return (int32_t)((value >= 0 ? value + divisor / 2 : value - divisor / 2) / divisor);
+}
+
+// log2(value) if value is a power of two, else 0
+static uint8_t powerOfTwo(int64_t value) {
+  uint8_t shift = 0;
+  while (((int64_t)1 << shift) < value)
+    shift++;
+  return ((int64_t)1 << shift) == value ? shift : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor. All sections bypassed.
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_Biquad::ADIS16490_Biquad() {
+  _sections = 0;
+  memset(_coef, 0, sizeof(_coef));
+  memset(_coefQ, 0, sizeof(_coefQ));
+  reset();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Sets the coefficients of one section in float and Q29
+// Returns 1 when complete, 0 if the section is out of range or a
+// coefficient does not fit in Q29 (|c| >= 4).
+////////////////////////////////////////////////////////////////////////////
+// section - 0 ~ FILTER_MAX_SECTIONS - 1
+// b0, b1, b2 - numerator
+// a1, a2 - denominator, a0 = 1
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_Biquad::setSection(uint8_t section, double b0, double b1, double b2, double a1, double a2) {
+  if (section >= FILTER_MAX_SECTIONS)
+    return(0);
+  double coef[5] = {b0, b1, b2, a1, a2};
+  for (int k = 0; k < 5; k++)
+    if (fabs(coef[k]) >= 4.0)
+      return(0);
+  for (int k = 0; k < 5; k++) {
+    _coef[section][k] = (float)coef[k];
+    _coefQ[section][k] = (int32_t)lround(ldexp(coef[k], FILTER_Q));
+  }
+  if (section >= _sections)
+    _sections = section + 1;
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Second-order low-pass section by the bilinear transform. At low cutoffs
+// 1 + a1 + a2 is tiny and rounding the coefficients would change the DC
+// gain, so b1 absorbs the rounding of the others in both the float and the
+// Q29 set and the gain stays 1.
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// section - 0 ~ FILTER_MAX_SECTIONS - 1
+// sampleHz - rate the section runs at
+// cutoffHz - corner frequency, below sampleHz / 2
+// q - quality factor (0.7071 for a Butterworth response)
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_Biquad::setLowpass(uint8_t section, float sampleHz, float cutoffHz, float q) {
+  if (cutoffHz <= 0 || cutoffHz >= sampleHz / 2 || q <= 0)
+    return(0);
+  double w0 = 2.0 * M_PI * cutoffHz / sampleHz;
+  double c = cos(w0);
+  double alpha = sin(w0) / (2.0 * q);
+  double a0 = 1.0 + alpha;
+  double b = (1.0 - c) / 2.0 / a0;
+  if (!setSection(section, b, 2.0 * b, b, -2.0 * c / a0, (1.0 - alpha) / a0))
+    return(0);
+  balance(section);
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Butterworth low-pass: pole pairs with Q = 1 / (2 sin(theta)) and, for
+// odd orders, a first-order section last
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// order - 1 ~ 2 * FILTER_MAX_SECTIONS
+// sampleHz - rate the filter runs at
+// cutoffHz - -3 dB frequency
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_Biquad::setButterworth(uint8_t order, float sampleHz, float cutoffHz) {
+  if (order < 1 || order > 2 * FILTER_MAX_SECTIONS || cutoffHz <= 0 || cutoffHz >= sampleHz / 2)
+    return(0);
+  _sections = 0;
+  uint8_t pairs = order / 2;
+  for (uint8_t k = 0; k < pairs; k++) {
+    double theta = M_PI * (2 * k + 1) / (2.0 * order);
+    if (!setLowpass(k, sampleHz, cutoffHz, (float)(0.5 / sin(theta))))
+      return(0);
+  }
+  if (order & 1) {
+    double k = tan(M_PI * cutoffHz / sampleHz);
+    if (!setSection(pairs, k / (1 + k), k / (1 + k), 0, (k - 1) / (k + 1), 0))
+      return(0);
+    balance(pairs);
+  }
+  reset();
+  return(1);
+}
+
+// Makes b0 + b1 + b2 equal 1 + a1 + a2 in the stored coefficients
+void ADIS16490_Biquad::balance(uint8_t section) {
+  float *coef = _coef[section];
+  coef[1] = (float)(1.0 + (double)coef[3] + coef[4] - coef[0] - coef[2]);
+  int32_t *coefQ = _coefQ[section];
+  coefQ[1] = ((int32_t)1 << FILTER_Q) + coefQ[3] + coefQ[4] - coefQ[0] - coefQ[2];
+}
+
+void ADIS16490_Biquad::reset() {
+  memset(_state, 0, sizeof(_state));
+  memset(_stateQ, 0, sizeof(_stateQ));
+  memset(_errorQ, 0, sizeof(_errorQ));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Filters one channel in place, one section at a time over the block so
+// the coefficients stay in registers
+// Returns count.
+////////////////////////////////////////////////////////////////////////////
+// channel - 0 ~ FILTER_CHANNELS - 1
+// data - channel array
+// count - values in data
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_Biquad::process(uint8_t channel, float *data, size_t count) {
+  for (uint8_t s = 0; s < _sections; s++) {
+    const float b0 = _coef[s][0], b1 = _coef[s][1], b2 = _coef[s][2];
+    const float a1 = _coef[s][3], a2 = _coef[s][4];
+    float z1 = _state[channel][s][0];
+    float z2 = _state[channel][s][1];
+    for (size_t i = 0; i < count; i++) {
+      float x = data[i];
+      float y = b0 * x + z1;
+      z1 = b1 * x - a1 * y + z2;
+      z2 = b2 * x - a2 * y;
+      data[i] = y;
+    }
+    _state[channel][s][0] = z1;
+    _state[channel][s][1] = z2;
+  }
+  return count;
+}
+
+size_t ADIS16490_Biquad::process(uint8_t channel, int32_t *data, size_t count) {
+  const int64_t mask = ((int64_t)1 << FILTER_Q) - 1;
+  for (uint8_t s = 0; s < _sections; s++) {
+    const int32_t b0 = _coefQ[s][0], b1 = _coefQ[s][1], b2 = _coefQ[s][2];
+    const int32_t a1 = _coefQ[s][3], a2 = _coefQ[s][4];
+    int32_t *state = _stateQ[channel][s];
+    int32_t x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+    int64_t error = _errorQ[channel][s];
+    for (size_t i = 0; i < count; i++) {
+      int32_t x = data[i];
+      int64_t acc = error + (int64_t)b0 * x + (int64_t)b1 * x1 + (int64_t)b2 * x2
+                          - (int64_t)a1 * y1 - (int64_t)a2 * y2;
+      int32_t y = (int32_t)(acc >> FILTER_Q);
+      error = acc & mask;
+      x2 = x1;
+      x1 = x;
+      y2 = y1;
+      y1 = y;
+      data[i] = y;
+    }
+    state[0] = x1;
+    state[1] = x2;
+    state[2] = y1;
+    state[3] = y2;
+    _errorQ[channel][s] = error;
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// length - inputs averaged
+// decimate - output one average per length inputs
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_MovingAverage::ADIS16490_MovingAverage(uint8_t length, bool decimate) {
+  _length = 1;
+  _decimate = false;
+  configure(length, decimate);
+}
+
+int ADIS16490_MovingAverage::configure(uint8_t length, bool decimate) {
+  if (length < 1 || length > FILTER_MAX_AVERAGE)
+    return(0);
+  _length = length;
+  _decimate = decimate;
+  reset();
+  return(1);
+}
+
+void ADIS16490_MovingAverage::reset() {
+  memset(_history, 0, sizeof(_history));
+  memset(_historyQ, 0, sizeof(_historyQ));
+  memset(_sum, 0, sizeof(_sum));
+  memset(_sumQ, 0, sizeof(_sumQ));
+  memset(_index, 0, sizeof(_index));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Running sum over a circular history. The float sum is recomputed from
+// the history each time the index wraps so rounding cannot accumulate.
+// Returns the number of outputs.
+////////////////////////////////////////////////////////////////////////////
+// channel - 0 ~ FILTER_CHANNELS - 1
+// data - channel array
+// count - values in data
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_MovingAverage::process(uint8_t channel, float *data, size_t count) {
+  const uint8_t length = _length;
+  const float scale = 1.0f / length;
+  float sum = _sum[channel];
+  uint8_t index = _index[channel];
+  size_t outputs = 0;
+  if (_decimate) {
+    for (size_t i = 0; i < count; i++) {
+      sum += data[i];
+      if (++index == length) {
+        data[outputs++] = sum * scale;
+        sum = 0;
+        index = 0;
+      }
+    }
+  }
+  else {
+    float *history = _history[channel];
+    for (size_t i = 0; i < count; i++) {
+      float x = data[i];
+      sum += x - history[index];
+      history[index] = x;
+      if (++index == length) {
+        index = 0;
+        sum = 0;
+        for (uint8_t k = 0; k < length; k++)
+          sum += history[k];
+      }
+      data[i] = sum * scale;
+    }
+    outputs = count;
+  }
+  _sum[channel] = sum;
+  _index[channel] = index;
+  return outputs;
+}
+
+size_t ADIS16490_MovingAverage::process(uint8_t channel, int32_t *data, size_t count) {
+  const uint8_t length = _length;
+  const uint8_t shift = powerOfTwo(length);
+  int64_t sum = _sumQ[channel];
+  uint8_t index = _index[channel];
+  size_t outputs = 0;
+  if (_decimate) {
+    for (size_t i = 0; i < count; i++) {
+      sum += data[i];
+      if (++index == length) {
+        data[outputs++] = length == 1 ? (int32_t)sum : (shift ? roundShift(sum, shift) : roundDivide(sum, length));
+        sum = 0;
+        index = 0;
+      }
+    }
+  }
+  else {
+    int32_t *history = _historyQ[channel];
+    for (size_t i = 0; i < count; i++) {
+      int32_t x = data[i];
+      sum += (int64_t)x - history[index];
+      history[index] = x;
+      if (++index == length)
+        index = 0;
+      data[i] = length == 1 ? (int32_t)sum : (shift ? roundShift(sum, shift) : roundDivide(sum, length));
+    }
+    outputs = count;
+  }
+  _sumQ[channel] = sum;
+  _index[channel] = index;
+  return outputs;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// order - integrator/comb pairs
+// ratio - decimation ratio
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_Cic::ADIS16490_Cic(uint8_t order, uint8_t ratio) {
+  _order = 1;
+  _ratio = 2;
+  configure(1, 2);
+  configure(order, ratio);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Sets the order and ratio and derives the gain and the equivalent FIR
+// (the boxcar of length ratio convolved order times, divided by the gain)
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// order - 1 ~ FILTER_CIC_MAX_ORDER
+// ratio - 2 ~ FILTER_CIC_MAX_RATIO
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_Cic::configure(uint8_t order, uint8_t ratio) {
+  if (order < 1 || order > FILTER_CIC_MAX_ORDER || ratio < 2 || ratio > FILTER_CIC_MAX_RATIO)
+    return(0);
+  _order = order;
+  _ratio = ratio;
+  _taps = order * (ratio - 1) + 1;
+  _gain = 1;
+  for (uint8_t k = 0; k < order; k++)
+    _gain *= ratio;
+  _gainShift = powerOfTwo(_gain);
+
+  int64_t response[FILTER_CIC_MAX_TAPS] = {1};
+  uint8_t length = 1;
+  for (uint8_t k = 0; k < order; k++) {
+    int64_t next[FILTER_CIC_MAX_TAPS] = {0};
+    for (uint8_t i = 0; i < length; i++)
+      for (uint8_t j = 0; j < ratio; j++)
+        next[i + j] += response[i];
+    length += ratio - 1;
+    memcpy(response, next, sizeof(response));
+  }
+  for (uint8_t i = 0; i < _taps; i++)
+    _fir[i] = (float)((double)response[i] / _gain);
+  reset();
+  return(1);
+}
+
+void ADIS16490_Cic::reset() {
+  memset(_history, 0, sizeof(_history));
+  memset(_integrator, 0, sizeof(_integrator));
+  memset(_comb, 0, sizeof(_comb));
+  memset(_phase, 0, sizeof(_phase));
+  memset(_index, 0, sizeof(_index));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Float path: stores each input in a circular history and evaluates the
+// equivalent FIR every ratio inputs. The dot product is split in two
+// unit-stride runs around the wrap point.
+// Returns the number of outputs.
+////////////////////////////////////////////////////////////////////////////
+// channel - 0 ~ FILTER_CHANNELS - 1
+// data - channel array
+// count - values in data
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_Cic::process(uint8_t channel, float *data, size_t count) {
+  const uint8_t taps = _taps;
+  float *history = _history[channel];
+  uint8_t index = _index[channel];
+  uint8_t phase = _phase[channel];
+  size_t outputs = 0;
+  for (size_t i = 0; i < count; i++) {
+    // History is stored newest last; walking back from the newest input
+    // pairs it with _fir[0]
+    history[index] = data[i];
+    uint8_t newest = index;
+    if (++index == taps)
+      index = 0;
+    if (++phase < _ratio)
+      continue;
+    phase = 0;
+    float y = 0;
+    uint8_t k = 0;
+    for (int16_t j = newest; j >= 0; j--)
+      y += _fir[k++] * history[j];
+    for (int16_t j = taps - 1; k < taps; j--)
+      y += _fir[k++] * history[j];
+    data[outputs++] = y;
+  }
+  _index[channel] = index;
+  _phase[channel] = phase;
+  return outputs;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Fixed path: integrators at the input rate, combs at the output rate.
+// Unsigned arithmetic wraps, and the wrap cancels in the combs as long as
+// the normalized output fits in 32 bits.
+// Returns the number of outputs.
+////////////////////////////////////////////////////////////////////////////
+// channel - 0 ~ FILTER_CHANNELS - 1
+// data - channel array
+// count - values in data
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_Cic::process(uint8_t channel, int32_t *data, size_t count) {
+  const uint8_t order = _order;
+  uint64_t *integrator = _integrator[channel];
+  uint64_t *comb = _comb[channel];
+  uint8_t phase = _phase[channel];
+  size_t outputs = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t v = (uint64_t)(int64_t)data[i];
+    for (uint8_t k = 0; k < order; k++)
+      v = integrator[k] += v;
+    if (++phase < _ratio)
+      continue;
+    phase = 0;
+    for (uint8_t k = 0; k < order; k++) {
+      uint64_t delayed = comb[k];
+      comb[k] = v;
+      v -= delayed;
+    }
+    int64_t sum = (int64_t)v;
+    data[outputs++] = _gainShift ? roundShift(sum, _gainShift) : roundDivide(sum, _gain);
+  }
+  _phase[channel] = phase;
+  return outputs;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Appends a stage; the pipeline keeps a pointer, not a copy
+// Returns 1 when complete, 0 if the pipeline is full.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_FilterPipeline::add(ADIS16490_FilterStage &stage) {
+  if (_count >= FILTER_MAX_STAGES)
+    return(0);
+  _stages[_count++] = &stage;
+  return(1);
+}
+
+void ADIS16490_FilterPipeline::reset() {
+  for (uint8_t s = 0; s < _count; s++)
+    _stages[s]->reset();
+}
+
+template <typename T>
+size_t ADIS16490_FilterPipeline::run(T *const *channels, size_t count) {
+  size_t outputs = count;
+  for (uint8_t channel = 0; channel < FILTER_CHANNELS; channel++) {
+    if (!channels[channel])
+      continue;
+    size_t n = count;
+    for (uint8_t s = 0; s < _count; s++)
+      n = _stages[s]->process(channel, channels[channel], n);
+    outputs = n;
+  }
+  return outputs;
+}
+
+size_t ADIS16490_FilterPipeline::process(const ADIS16490_ScaledBlock &block, size_t count) {
+  float *const channels[FILTER_CHANNELS] = {block.gyro[0], block.gyro[1], block.gyro[2],
+                                            block.accel[0], block.accel[1], block.accel[2], block.temp};
+  return run(channels, count);
+}
+
+size_t ADIS16490_FilterPipeline::process(const ADIS16490_RawBlock &block, size_t count) {
+  int32_t *const channels[FILTER_CHANNELS] = {block.gyro[0], block.gyro[1], block.gyro[2],
+                                              block.accel[0], block.accel[1], block.accel[2], block.temp};
+  return run(channels, count);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Copies sample records into per-channel arrays with FILTER_RAW_SHIFT
+// fraction bits
+////////////////////////////////////////////////////////////////////////////
+// samples - count records
+// block - channel arrays, each with room for count values
+// count - number of records
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_FilterPipeline::unpack(const ADIS16490_Sample *samples, const ADIS16490_RawBlock &block, size_t count) {
+  const int32_t scale = 1 << FILTER_RAW_SHIFT;
+  for (int axis = 0; axis < 3; axis++) {
+    int32_t *gyro = block.gyro[axis];
+    int32_t *accel = block.accel[axis];
+    if (gyro)
+      for (size_t i = 0; i < count; i++)
+        gyro[i] = samples[i].gyro[axis] * scale;
+    if (accel)
+      for (size_t i = 0; i < count; i++)
+        accel[i] = samples[i].accel[axis] * scale;
+  }
+  if (block.temp)
+    for (size_t i = 0; i < count; i++)
+      block.temp[i] = samples[i].temp * scale;
+}
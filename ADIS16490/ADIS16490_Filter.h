@@ -0,0 +1,220 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Filter.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Software post-filtering for ADIS16490 samples. Stages are cascaded biquads, a CIC decimator, and
+//  a moving average (optionally decimating). Each stage keeps state for every channel in fixed
+//  arrays and filters one channel array in place, so nothing is allocated and a stage works on the
+//  structure-of-arrays blocks that scaleSamples() fills. ADIS16490_FilterPipeline chains up to
+//  FILTER_MAX_STAGES caller-owned stages over all channels of a block and returns the number of
+//  outputs left after decimation.
+//
+//  Every stage has a float path (ADIS16490_ScaledBlock) and a fixed-point path (ADIS16490_RawBlock
+//  of int32 values). unpack() fills a raw block from sample records with FILTER_RAW_SHIFT bits of
+//  fraction, which keeps filter rounding below the sensor LSB; 16.16 words from highResRead() can
+//  be used directly. The inner loops are single multiply-accumulate chains over unit-stride arrays:
+//  the float paths compile to VFMA on the Cortex-M4F, the fixed biquad to SMLAL with Q29
+//  coefficients and error feedback, and the CIC to 64-bit adds, which keeps its integrators exact
+//  for any order and ratio within the limits.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Filter_h
+#define ADIS16490_Filter_h
+#include "ADIS16490.h"
+
+// Channels per stage: X/Y/Z gyro, X/Y/Z accel, temperature
+#define FILTER_CHANNELS 7
+
+// Stage limits
+#define FILTER_MAX_STAGES    4
+#define FILTER_MAX_SECTIONS  4  // Biquad sections (Butterworth order up to 8)
+#ifndef FILTER_MAX_AVERAGE
+#define FILTER_MAX_AVERAGE   32 // Moving average length
+#endif
+#define FILTER_CIC_MAX_ORDER 4
+#define FILTER_CIC_MAX_RATIO 16
+#define FILTER_CIC_MAX_TAPS  (FILTER_CIC_MAX_ORDER * (FILTER_CIC_MAX_RATIO - 1) + 1)
+
+// Fixed-point biquad coefficient fraction bits
+#define FILTER_Q 29
+
+// Fraction bits added by unpack()
+#define FILTER_RAW_SHIFT 8
+
+// Raw samples, structure-of-arrays layout. Each pointer is a caller owned
+// channel array with room for the whole block; null channels are skipped.
+struct ADIS16490_RawBlock {
+  int32_t *gyro[3];
+  int32_t *accel[3];
+  int32_t *temp;
+};
+
+// Filter stage interface. process() filters count values of one channel
+// in place and returns the number of outputs, which is smaller than count
+// for decimating stages. The float and fixed paths share the per-channel
+// state, so call reset() before switching a channel between them.
+class ADIS16490_FilterStage {
+
+public:
+  virtual ~ADIS16490_FilterStage() {}
+
+  // Clears the state of every channel
+  virtual void reset() = 0;
+
+  virtual size_t process(uint8_t channel, float *data, size_t count) = 0;
+  virtual size_t process(uint8_t channel, int32_t *data, size_t count) = 0;
+
+};
+
+// Cascaded biquad sections. The float path uses transposed direct form II;
+// the fixed path uses direct form I with Q29 coefficients, a 64-bit
+// accumulator, and the rounding remainder fed back into the next sample,
+// so low cutoffs at high rates do not add a DC offset or limit cycles.
+class ADIS16490_Biquad : public ADIS16490_FilterStage {
+
+public:
+  ADIS16490_Biquad();
+
+  // Sets one section: H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2).
+  // Sections past the last one set are bypassed. Returns 1 when complete.
+  int setSection(uint8_t section, double b0, double b1, double b2, double a1, double a2);
+
+  // Second-order low-pass section. Returns 1 when complete.
+  int setLowpass(uint8_t section, float sampleHz, float cutoffHz, float q = 0.70710678f);
+
+  // Butterworth low-pass of the given order (1 ~ 2 * FILTER_MAX_SECTIONS)
+  // using sections 0 onward. Returns 1 when complete.
+  int setButterworth(uint8_t order, float sampleHz, float cutoffHz);
+
+  uint8_t sections() const { return _sections; }
+
+  void reset();
+  size_t process(uint8_t channel, float *data, size_t count);
+  size_t process(uint8_t channel, int32_t *data, size_t count);
+
+private:
+  // Adjusts b1 for unity DC gain after rounding
+  void balance(uint8_t section);
+
+  uint8_t _sections;
+  float _coef[FILTER_MAX_SECTIONS][5];   // b0, b1, b2, a1, a2
+  int32_t _coefQ[FILTER_MAX_SECTIONS][5];
+  float _state[FILTER_CHANNELS][FILTER_MAX_SECTIONS][2];
+  int32_t _stateQ[FILTER_CHANNELS][FILTER_MAX_SECTIONS][4]; // x1, x2, y1, y2
+  int64_t _errorQ[FILTER_CHANNELS][FILTER_MAX_SECTIONS];
+
+};
+
+// Moving average over the last length inputs. With decimate set, one
+// average of each length inputs is output instead (a boxcar decimator).
+class ADIS16490_MovingAverage : public ADIS16490_FilterStage {
+
+public:
+  ADIS16490_MovingAverage(uint8_t length = 4, bool decimate = false);
+
+  // Length 1 ~ FILTER_MAX_AVERAGE. Resets the state. Returns 1 when complete.
+  int configure(uint8_t length, bool decimate = false);
+
+  void reset();
+  size_t process(uint8_t channel, float *data, size_t count);
+  size_t process(uint8_t channel, int32_t *data, size_t count);
+
+private:
+  uint8_t _length;
+  bool _decimate;
+  float _history[FILTER_CHANNELS][FILTER_MAX_AVERAGE];
+  int32_t _historyQ[FILTER_CHANNELS][FILTER_MAX_AVERAGE];
+  float _sum[FILTER_CHANNELS];
+  int64_t _sumQ[FILTER_CHANNELS];
+  uint8_t _index[FILTER_CHANNELS];
+
+};
+
+// CIC decimator (differential delay 1) normalized to unity DC gain. The
+// fixed path is the integrator/comb recursion in wrapping 64-bit
+// arithmetic. Float integrators would lose precision, so the float path
+// evaluates the equivalent FIR (order * (ratio - 1) + 1 taps) at the
+// output instants only, about order multiply-adds per input.
+class ADIS16490_Cic : public ADIS16490_FilterStage {
+
+public:
+  ADIS16490_Cic(uint8_t order = 3, uint8_t ratio = 4);
+
+  // Order 1 ~ FILTER_CIC_MAX_ORDER, ratio 2 ~ FILTER_CIC_MAX_RATIO. Resets
+  // the state. Returns 1 when complete.
+  int configure(uint8_t order, uint8_t ratio);
+
+  uint8_t ratio() const { return _ratio; }
+
+  void reset();
+  size_t process(uint8_t channel, float *data, size_t count);
+  size_t process(uint8_t channel, int32_t *data, size_t count);
+
+private:
+  uint8_t _order;
+  uint8_t _ratio;
+  uint8_t _taps;
+  uint8_t _gainShift;  // log2(ratio^order) when ratio is a power of two, else 0
+  int64_t _gain;       // ratio^order
+  float _fir[FILTER_CIC_MAX_TAPS]; // Equivalent FIR, newest input first
+  float _history[FILTER_CHANNELS][FILTER_CIC_MAX_TAPS];
+  uint64_t _integrator[FILTER_CHANNELS][FILTER_CIC_MAX_ORDER];
+  uint64_t _comb[FILTER_CHANNELS][FILTER_CIC_MAX_ORDER];
+  uint8_t _phase[FILTER_CHANNELS];
+  uint8_t _index[FILTER_CHANNELS];
+
+};
+
+// Chain of filter stages applied to every channel of a block
+class ADIS16490_FilterPipeline {
+
+public:
+  ADIS16490_FilterPipeline() : _count(0) {}
+
+  // Appends a stage. Returns 0 if FILTER_MAX_STAGES are already in use.
+  int add(ADIS16490_FilterStage &stage);
+
+  // Removes all stages
+  void clear() { _count = 0; }
+
+  // Resets every stage
+  void reset();
+
+  // Filters the non-null channels of a block in place. Returns the number
+  // of outputs left at the front of each channel array.
+  size_t process(const ADIS16490_ScaledBlock &block, size_t count);
+  size_t process(const ADIS16490_RawBlock &block, size_t count);
+
+  // Copies sample records into a raw block, shifted left by FILTER_RAW_SHIFT
+  static void unpack(const ADIS16490_Sample *samples, const ADIS16490_RawBlock &block, size_t count);
+
+private:
+  template <typename T>
+  size_t run(T *const *channels, size_t count);
+
+  ADIS16490_FilterStage *_stages[FILTER_MAX_STAGES];
+  uint8_t _count;
+
+};
+
+#endif
@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_FirBank.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  FIR filter bank manager for the ADIS16490. See ADIS16490_FirBank.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_FirBank.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+// Reads a coefficient from RAM or flash
+#ifdef ARDUINO
+#define FIR_WORD(table, i, progmem) ((progmem) ? (int16_t)pgm_read_word(&(table)[i]) : (table)[i])
+#else
+#define FIR_WORD(table, i, progmem) ((void)(progmem), (table)[i])
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// imu - driver instance used for register access
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_FirBank::ADIS16490_FirBank(ADIS16490 &imu) {
+  _imu = &imu;
+  _valid = 0;
+  _stats = ADIS16490_FirStats();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Writes the bytes that differ from the cached bank, then reads each
+// changed coefficient back. Each page is one regBatch(): byte writes in
+// tap order followed by the readbacks, chained so every readback costs one
+// frame. The cache takes the readback values.
+// Returns 1 when every coefficient reads back as written.
+////////////////////////////////////////////////////////////////////////////
+// bank - FIR_BANK_A ~ FIR_BANK_D
+// coeffs - FIR_TAPS coefficients
+// progmem - coeffs is in flash
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_FirBank::upload(uint8_t bank, const int16_t *coeffs, bool progmem) {
+  if (bank >= FIR_BANKS)
+    return(0);
+  uint32_t start = _imu->bus()->microsNow();
+  ADIS16490_FirStats stats = ADIS16490_FirStats();
+  _stats = stats;
+  if (!(_valid & (1 << bank)))
+    refresh(bank);
+
+  for (uint8_t first = 0; first < FIR_TAPS; first += FIR_TAPS_PER_PAGE) {
+    size_t count = 0;
+    uint8_t changed = 0;
+    for (uint8_t tap = first; tap < first + FIR_TAPS_PER_PAGE; tap++) {
+      int16_t want = FIR_WORD(coeffs, tap, progmem);
+      uint16_t diff = (uint16_t)(want ^ _cache[bank][tap]);
+      if (!diff)
+        continue;
+      uint16_t addr = coefAddr(bank, tap);
+      if (diff & 0x00FF)
+        _ops[count++] = {addr, (int16_t)(want & 0xFF), REG_OP_WRITE | REG_OP_BYTE};
+      if (diff & 0xFF00)
+        _ops[count++] = {(uint16_t)(addr + 1), (int16_t)((want >> 8) & 0xFF), REG_OP_WRITE | REG_OP_BYTE};
+      _taps[changed++] = tap;
+    }
+    if (!changed)
+      continue;
+    _stats.byteWrites += count;
+    size_t reads = count;
+    for (uint8_t i = 0; i < changed; i++)
+      _ops[count++] = {coefAddr(bank, _taps[i]), 0, REG_OP_READ};
+    send(count);
+
+    for (uint8_t i = 0; i < changed; i++) {
+      uint8_t tap = _taps[i];
+      _cache[bank][tap] = _ops[reads + i].data;
+      if (_ops[reads + i].data != FIR_WORD(coeffs, tap, progmem))
+        _stats.verifyErrors++;
+    }
+    _stats.changed += changed;
+  }
+
+  _stats.naiveFrames = 4 * FIR_TAPS + 2;
+  _stats.micros = _imu->bus()->microsNow() - start;
+  return(_stats.verifyErrors == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads a whole bank into the cache with chained reads
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// bank - FIR_BANK_A ~ FIR_BANK_D
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_FirBank::refresh(uint8_t bank) {
+  if (bank >= FIR_BANKS)
+    return(0);
+  for (uint8_t first = 0; first < FIR_TAPS; first += FIR_TAPS_PER_PAGE) {
+    for (uint8_t i = 0; i < FIR_TAPS_PER_PAGE; i++)
+      _ops[i] = {coefAddr(bank, first + i), 0, REG_OP_READ};
+    send(FIR_TAPS_PER_PAGE);
+    for (uint8_t i = 0; i < FIR_TAPS_PER_PAGE; i++)
+      _cache[bank][first + i] = _ops[i].data;
+  }
+  _valid |= 1 << bank;
+  return(1);
+}
+
+void ADIS16490_FirBank::send(size_t count) {
+  ADIS16490_BatchStats batch;
+  _imu->regBatch(_ops, count, &batch);
+  _stats.frames += batch.frames;
+}
+
+void ADIS16490_FirBank::encode(const uint8_t banks[FIR_AXES], uint16_t &bnk0, uint16_t &bnk1) {
+  bnk0 = 0;
+  bnk1 = 0;
+  for (uint8_t axis = 0; axis < FIR_AXES; axis++) {
+    uint16_t field = banks[axis] < FIR_BANKS ? (banks[axis] | FILTR_BNK_ENABLE) : 0;
+    if (axis < FIR_Z_ACCL)
+      bnk0 |= field << (FILTR_BNK_BITS * axis);
+    else
+      bnk1 |= field;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Writes FILTR_BNK_0/1 and reads them back
+// Returns 1 when both read back as written.
+////////////////////////////////////////////////////////////////////////////
+// banks - bank per axis (FIR_BANK_A ~ FIR_BANK_D, or FIR_OFF)
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_FirBank::assign(const uint8_t banks[FIR_AXES]) {
+  uint16_t bnk0, bnk1;
+  encode(banks, bnk0, bnk1);
+  ADIS16490_RegOp ops[] = {
+    {FILTR_BNK_0, (int16_t)bnk0, REG_OP_WRITE},
+    {FILTR_BNK_1, (int16_t)bnk1, REG_OP_WRITE},
+    {FILTR_BNK_0, 0, REG_OP_READ | REG_OP_BARRIER},
+    {FILTR_BNK_1, 0, REG_OP_READ} };
+  _imu->regBatch(ops, 4);
+  return((uint16_t)ops[2].data == bnk0 && (uint16_t)ops[3].data == bnk1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Changes the bank of one axis, keeping the others
+// Returns 1 when FILTR_BNK_0/1 read back as written.
+////////////////////////////////////////////////////////////////////////////
+// axis - FIR_X_GYRO ~ FIR_Z_ACCL
+// bank - FIR_BANK_A ~ FIR_BANK_D, or FIR_OFF
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_FirBank::assign(uint8_t axis, uint8_t bank) {
+  if (axis >= FIR_AXES)
+    return(0);
+  uint8_t banks[FIR_AXES];
+  assignment(banks);
+  banks[axis] = bank;
+  return(assign(banks));
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Decodes FILTR_BNK_0/1
+// Returns 1 when complete.
+////////////////////////////////////////////////////////////////////////////
+// banks - receives the bank per axis (FIR_OFF if disabled)
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_FirBank::assignment(uint8_t banks[FIR_AXES]) {
+  const uint16_t addrs[2] = {FILTR_BNK_0, FILTR_BNK_1};
+  int16_t words[2];
+  _imu->regReadMany(addrs, words, 2);
+  for (uint8_t axis = 0; axis < FIR_AXES; axis++) {
+    uint16_t field = axis < FIR_Z_ACCL ? (uint16_t)words[0] >> (FILTR_BNK_BITS * axis) : (uint16_t)words[1];
+    banks[axis] = (field & FILTR_BNK_ENABLE) ? (field & 0x03) : FIR_OFF;
+  }
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Parses a coefficient table from text. Numbers may be decimal, hex (0x),
+// or octal as in C, separated by commas, whitespace, or line breaks; //
+// and /* */ comments are skipped, and if the text contains '{', parsing
+// starts after it and stops at '}' so a C initializer can be used as is.
+// Returns the number of coefficients found (at most max), or 0 if a
+// number is malformed or outside -32768 ~ 32767.
+////////////////////////////////////////////////////////////////////////////
+// text - zero-terminated table
+// coeffs - receives the coefficients
+// max - capacity of coeffs
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_FirBank::parse(const char *text, int16_t *coeffs, size_t max) {
+  const char *p = text;
+  for (const char *q = text; *q; q++) {
+    if (*q == '{') {
+      p = q + 1;
+      break;
+    }
+  }
+  size_t count = 0;
+  while (*p && *p != '}' && count < max) {
+    if (p[0] == '/' && p[1] == '/') {
+      while (*p && *p != '\n')
+        p++;
+      continue;
+    }
+    if (p[0] == '/' && p[1] == '*') {
+      p += 2;
+      while (*p && !(p[0] == '*' && p[1] == '/'))
+        p++;
+      if (*p)
+        p += 2;
+      continue;
+    }
+    const char *digit = (*p == '-' || *p == '+') ? p + 1 : p;
+    if (*digit < '0' || *digit > '9') {
+      p++;
+      continue;
+    }
+    char *end;
+    long value = strtol(p, &end, 0);
+    if (value < -32768 || value > 32767 || isalnum((unsigned char)*end) || *end == '.')
+      return 0;
+    coeffs[count++] = (int16_t)value;
+    p = end;
+  }
+  return count;
+}
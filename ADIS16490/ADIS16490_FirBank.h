@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_FirBank.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  FIR filter bank manager for the ADIS16490. Each of the four banks (A ~ D) holds 120 coefficients
+//  spread over two register pages, and every register write is two byte-wide frames, so writing a
+//  bank with regWrite() costs 240 frames plus page switches. upload() compares the table with a
+//  cached copy of the bank, writes only the bytes that differ (one frame each with REG_OP_BYTE),
+//  and reads the changed coefficients back to verify them, one regBatch() per page. The cache is
+//  filled by reading the bank the first time and kept up to date from the readback, so reloading a
+//  table that differs in a few taps costs a few frames.
+//
+//  Tables can be plain arrays, arrays in flash (PROGMEM, read with pgm_read_word), or text parsed
+//  with parse(), e.g. a file read from an SD card or sent by a host. assign() selects the bank used
+//  by each axis through FILTR_BNK_0/1. Coefficients are lost at power off unless saved to flash
+//  with the GLOB_CMD flash update command.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_FirBank_h
+#define ADIS16490_FirBank_h
+#include "ADIS16490.h"
+
+// Axes selected in FILTR_BNK_0/1, in field order
+#define FIR_X_GYRO 0
+#define FIR_Y_GYRO 1
+#define FIR_Z_GYRO 2
+#define FIR_X_ACCL 3
+#define FIR_Y_ACCL 4
+#define FIR_Z_ACCL 5
+#define FIR_AXES   6
+
+// Banks
+#define FIR_BANK_A 0
+#define FIR_BANK_B 1
+#define FIR_BANK_C 2
+#define FIR_BANK_D 3
+#define FIR_OFF    0xFF // Filtering disabled for the axis
+
+// Cost of the last upload()
+struct ADIS16490_FirStats {
+  uint16_t changed;      // Coefficients that differed from the cache
+  uint16_t byteWrites;   // Byte write frames sent
+  uint16_t frames;       // Frames sent, including readback, cache refresh, and page switches
+  uint16_t naiveFrames;  // Frames a regWrite() and verifying regRead() per coefficient would take
+  uint16_t verifyErrors; // Coefficients whose readback did not match
+  uint32_t micros;       // Elapsed time
+};
+
+// FIR filter bank manager class definition
+class ADIS16490_FirBank {
+
+public:
+  ADIS16490_FirBank(ADIS16490 &imu);
+
+  // Writes the coefficients that differ from the cached bank and verifies
+  // them. Set progmem if coeffs is in flash.
+  // Returns 1 when every coefficient reads back as written.
+  int upload(uint8_t bank, const int16_t *coeffs, bool progmem = false);
+
+  // Reads a whole bank into the cache. Returns 1 when complete.
+  int refresh(uint8_t bank);
+
+  // Forgets the cached banks, e.g. after a reset reloads them from flash
+  void invalidate() { _valid = 0; }
+
+  // Cached coefficients of a bank (valid after refresh() or upload())
+  const int16_t *cached(uint8_t bank) const { return _cache[bank]; }
+
+  // Bank per axis, indexed by FIR_X_GYRO ~ FIR_Z_ACCL (FIR_OFF disables).
+  // Returns 1 when FILTR_BNK_0/1 read back as written.
+  int assign(const uint8_t banks[FIR_AXES]);
+
+  // Changes the bank of one axis. Returns 1 when it reads back as written.
+  int assign(uint8_t axis, uint8_t bank);
+
+  // Reads the bank per axis back. Returns 1 when complete.
+  int assignment(uint8_t banks[FIR_AXES]);
+
+  // Parses up to max integers from a text table (C initializer, CSV, or one
+  // per line). Text before the first '{' and comments are skipped.
+  // Returns the number of coefficients found, or 0 if one is malformed or
+  // does not fit in int16_t.
+  static size_t parse(const char *text, int16_t *coeffs, size_t max);
+
+  const ADIS16490_FirStats &stats() const { return _stats; }
+
+private:
+  // Register holding a coefficient
+  static uint16_t coefAddr(uint8_t bank, uint8_t tap) {
+    return ((FIR_PAGE_FIRST + 2 * bank + tap / FIR_TAPS_PER_PAGE) << 8) | (FIR_COEF_FIRST + 2 * (tap % FIR_TAPS_PER_PAGE));
+  }
+
+  // Sends the batch built in _ops and adds its frames to the stats
+  void send(size_t count);
+
+  // FILTR_BNK_0/1 words for a bank per axis
+  static void encode(const uint8_t banks[FIR_AXES], uint16_t &bnk0, uint16_t &bnk1);
+
+  ADIS16490 *_imu;
+  int16_t _cache[FIR_BANKS][FIR_TAPS];
+  uint8_t _valid;      // Bit per bank with a valid cache
+  ADIS16490_FirStats _stats;
+
+  // One page of byte writes and readbacks, and the tap read by each readback
+  ADIS16490_RegOp _ops[3 * FIR_TAPS_PER_PAGE];
+  uint8_t _taps[FIR_TAPS_PER_PAGE];
+
+};
+
+#endif
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Rate.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Output rate manager for the ADIS16490. See ADIS16490_Rate.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Rate.h"
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor. Assumes the power-on DEC_RATE until setRate() or read().
+////////////////////////////////////////////////////////////////////////////
+// imu - driver instance used for register access
+// baseHz - sample clock before decimation (Hz)
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_RateManager::ADIS16490_RateManager(ADIS16490 &imu, float baseHz) {
+  _imu = &imu;
+  _baseHz = baseHz;
+  _decRate = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Picks the divider nearest to the target rate. Rates are compared rather
+// than dividers, since the rate is inversely proportional to the divider.
+// Returns the DEC_RATE setting.
+////////////////////////////////////////////////////////////////////////////
+// baseHz - sample clock before decimation (Hz)
+// hz - target output rate (Hz)
+////////////////////////////////////////////////////////////////////////////
+uint16_t ADIS16490_RateManager::decimation(float baseHz, float hz) {
+  if (hz >= baseHz)
+    return 0;
+  if (hz <= baseHz / (DEC_RATE_MAX + 1))
+    return DEC_RATE_MAX;
+  uint16_t low = (uint16_t)(baseHz / hz); // Divider at or below the exact ratio
+  float fast = baseHz / low - hz;
+  float slow = hz - baseHz / (low + 1);
+  uint16_t divider = fast <= slow ? low : low + 1;
+  return divider - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Writes the DEC_RATE setting nearest to the target and reads it back
+// Returns 1 when the readback matches.
+////////////////////////////////////////////////////////////////////////////
+// hz - target output rate (Hz)
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_RateManager::setRate(float hz) {
+  uint16_t dec = decimation(_baseHz, hz);
+  _imu->regWrite(DEC_RATE, dec);
+  read();
+  return(_decRate == dec);
+}
+
+int ADIS16490_RateManager::read() {
+  _decRate = _imu->regRead(DEC_RATE) & DEC_RATE_MAX;
+  return(1);
+}
+
+uint16_t ADIS16490_RateManager::samplesFor(uint32_t micros) const {
+  float samples = micros / periodMicros();
+  if (samples < 1)
+    return 1;
+  return samples > 0xFFFF ? 0xFFFF : (uint16_t)samples;
+}
+
+uint16_t ADIS16490_RateManager::depthFor(uint32_t bufferMicros) const {
+  uint16_t depth = samplesFor(bufferMicros);
+  if (depth < RATE_MIN_DEPTH)
+    depth = RATE_MIN_DEPTH;
+  return depth > CAPTURE_DEPTH - 1 ? CAPTURE_DEPTH - 1 : depth;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Matches an interrupt-driven capture to the output period
+////////////////////////////////////////////////////////////////////////////
+// capture - stopped capture engine
+// bufferMicros - time of data the ring buffer holds (us)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_RateManager::apply(ADIS16490_Capture &capture, uint32_t bufferMicros) {
+  capture.sequence().setPeriod(periodNs());
+  capture.setDepth(depthFor(bufferMicros));
+  ADIS16490_TimeSync *sync = capture.timeSync();
+  if (sync) {
+    apply(*sync);
+    capture.setTimeSync(sync, samplesFor(RATE_TIMESYNC_MICROS));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Matches a DMA capture engine to the output period
+////////////////////////////////////////////////////////////////////////////
+// capture - stopped capture engine
+// bufferMicros - time of data the ring buffer holds (us)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_RateManager::apply(ADIS16490_DmaCapture &capture, uint32_t bufferMicros) {
+  capture.sequence().setPeriod(periodNs());
+  capture.setDepth(depthFor(bufferMicros));
+}
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Rate.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Output rate manager for the ADIS16490. The output rate is the sample clock divided by DEC_RATE +
+//  1, which is easy to get wrong when writing the register by hand. setRate() takes a target rate
+//  in Hz, picks the DEC_RATE setting whose rate is nearest, writes it, and reads it back. The
+//  achieved rate and period then come from the register value actually in the device, not the
+//  request.
+//
+//  Everything downstream that counts in samples follows from the period: the dt passed to the
+//  strapdown integrator and attitude filter, the DATA_CNT jitter check, the TimeSync output period,
+//  and how many samples of slack the capture ring buffer should hold. apply() updates a capture
+//  engine (and its TimeSync, if attached) to match; call it with capture stopped.
+//
+//  The sample clock defaults to the internal 4250 Hz. In scaled sync mode pass SYNC_SCALE times the
+//  sync input rate instead.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Rate_h
+#define ADIS16490_Rate_h
+#include "ADIS16490.h"
+#include "ADIS16490_Capture.h"
+#include "ADIS16490_DmaCapture.h"
+#include "ADIS16490_TimeSync.h"
+
+// Internal sample clock (Hz) and largest DEC_RATE setting
+#define RATE_BASE_HZ   4250.0f
+#define DEC_RATE_MAX   0x07FF
+
+// Default time of data the capture ring buffer holds (us). Longer stalls
+// in loop() drop samples instead of delivering stale ones.
+#define RATE_BUFFER_MICROS 250000
+
+// Smallest capture depth apply() sets (samples)
+#define RATE_MIN_DEPTH 4
+
+// Interval between TimeSync correlation points kept by apply() (us)
+#define RATE_TIMESYNC_MICROS 4000
+
+// Output rate manager class definition
+class ADIS16490_RateManager {
+
+public:
+  // baseHz - sample clock before decimation
+  ADIS16490_RateManager(ADIS16490 &imu, float baseHz = RATE_BASE_HZ);
+
+  // Sample clock before decimation (Hz)
+  void setBaseRate(float baseHz) { _baseHz = baseHz; }
+
+  // DEC_RATE setting whose output rate is nearest to hz
+  static uint16_t decimation(float baseHz, float hz);
+
+  // Writes the DEC_RATE setting nearest to hz and reads it back.
+  // Returns 1 when the readback matches.
+  int setRate(float hz);
+
+  // Reads DEC_RATE from the device, e.g. after a reset or a manual write.
+  // Returns 1 when complete.
+  int read();
+
+  // DEC_RATE value in the device as of the last setRate() or read()
+  uint16_t decRate() const { return _decRate; }
+
+  // Achieved output rate (Hz) and period (sec, ns, and us)
+  float rate() const { return _baseHz / (_decRate + 1); }
+  float period() const { return (_decRate + 1) / _baseHz; }
+  uint32_t periodNs() const { return (uint32_t)((_decRate + 1) * 1e9f / _baseHz + 0.5f); }
+  float periodMicros() const { return (_decRate + 1) * 1e6f / _baseHz; }
+
+  // Whole outputs in a time window, at least 1
+  uint16_t samplesFor(uint32_t micros) const;
+
+  // Matches a capture engine to the output period: DATA_CNT jitter period,
+  // ring depth for bufferMicros of data, and the attached TimeSync's period
+  // and correlation interval. Capture must be stopped.
+  void apply(ADIS16490_Capture &capture, uint32_t bufferMicros = RATE_BUFFER_MICROS);
+  void apply(ADIS16490_DmaCapture &capture, uint32_t bufferMicros = RATE_BUFFER_MICROS);
+
+  // Sets the TimeSync output period
+  void apply(ADIS16490_TimeSync &sync) { sync.setPeriod(periodMicros()); }
+
+private:
+  // Ring depth for bufferMicros of data, clamped to what the ring holds
+  uint16_t depthFor(uint32_t bufferMicros) const;
+
+  ADIS16490 *_imu;
+  float _baseHz;
+  uint16_t _decRate;
+
+};
+
+#endif
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_RingBuffer.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Lock-free single-producer/single-consumer ring buffer. The producer (typically the data ready
+//  ISR) only writes _head and the consumer (loop()) only writes _tail, so no interrupt masking is
+//  needed on a single-core Cortex-M. Capacity must be a power of two; one slot is kept empty to
+//  distinguish full from empty. setLimit() lowers the usable depth at run time without changing the
+//  storage.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_RingBuffer_h
+#define ADIS16490_RingBuffer_h
+#ifdef ARDUINO
+#include "Arduino.h"
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+template <typename T, uint16_t N>
+class ADIS16490_RingBuffer {
+
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "Ring buffer capacity must be a power of two");
+
+public:
+  ADIS16490_RingBuffer() : _head(0), _tail(0), _overruns(0), _limit(N - 1) {}
+
+  // Producer: returns the slot to fill, or 0 if the buffer is full. The
+  // slot becomes visible to the consumer only after commit().
+  T *reserve() {
+    uint16_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+    uint16_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    if (((head - tail) & (N - 1)) >= _limit) {
+      _overruns++;
+      return 0;
+    }
+    return &_buffer[head];
+  }
+
+  // Producer: publishes the slot returned by reserve()
+  void commit() {
+    uint16_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+    __atomic_store_n(&_head, (uint16_t)((head + 1) & (N - 1)), __ATOMIC_RELEASE);
+  }
+
+  // Producer: copies one record in. Returns false (and counts an overrun)
+  // if the buffer is full.
+  bool push(const T &item) {
+    T *slot = reserve();
+    if (!slot)
+      return false;
+    *slot = item;
+    commit();
+    return true;
+  }
+
+  // Consumer: copies the oldest record out. Returns false if empty.
+  bool pop(T &item) {
+    uint16_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+    uint16_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    if (tail == head)
+      return false;
+    item = _buffer[tail];
+    __atomic_store_n(&_tail, (uint16_t)((tail + 1) & (N - 1)), __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Consumer: returns the oldest record in place, or 0 if empty. The slot
+  // stays owned by the consumer until release().
+  const T *peek() const {
+    uint16_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+    uint16_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    if (tail == head)
+      return 0;
+    return &_buffer[tail];
+  }
+
+  // Consumer: frees the slot returned by peek()
+  void release() {
+    uint16_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+    __atomic_store_n(&_tail, (uint16_t)((tail + 1) & (N - 1)), __ATOMIC_RELEASE);
+  }
+
+  // Consumer: copies up to max records out. Returns the number copied.
+  size_t drain(T *items, size_t max) {
+    size_t count = 0;
+    while (count < max && pop(items[count]))
+      count++;
+    return count;
+  }
+
+  // Number of records waiting for the consumer
+  uint16_t available() const {
+    uint16_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    uint16_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+    return (head - tail) & (N - 1);
+  }
+
+  // Usable capacity
+  uint16_t capacity() const { return _limit; }
+
+  // Caps the records held at once (1 to N - 1), which bounds how stale the
+  // oldest one can be. Producer and consumer must be stopped.
+  void setLimit(uint16_t limit) { _limit = limit < 1 ? 1 : (limit > N - 1 ? N - 1 : limit); }
+
+  // Records dropped because the buffer was full
+  uint32_t overruns() const { return __atomic_load_n(&_overruns, __ATOMIC_RELAXED); }
+
+private:
+  T _buffer[N];
+  volatile uint16_t _head;
+  volatile uint16_t _tail;
+  volatile uint32_t _overruns;
+  uint16_t _limit;
+
+};
+
+#endif
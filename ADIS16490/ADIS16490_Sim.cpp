@@ -0,0 +1,441 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Sim.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Register-map simulator of the ADIS16490. See ADIS16490_Sim.h for a description of the model.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Sim.h"
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor. The simulator starts powered on at 2 MHz SCLK with the
+// datasheet minimum stall time of 16 us.
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_Sim::ADIS16490_Sim() {
+  _clock = SPI_CLOCK;
+  _maxClock = 15000000;
+  _maxBurstClock = 15000000;
+  _stallNs = STALL_NS;
+  _nowNs = 0;
+  _clockPpm = 0;
+  _clockPpmPerSec = 0;
+  _drIsr = 0;
+  _drContext = 0;
+  _drActive = false;
+  _drPending = false;
+  _syncPeriodNs = 0;
+  _nextSyncNs = SIM_NEVER;
+  _syncIsr = 0;
+  _syncContext = 0;
+  powerOn();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Restores the power-on register map and clears the statistics
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::powerOn() {
+  for (int p = 0; p < SIM_PAGES; p++) {
+    for (int w = 0; w < SIM_PAGE_WORDS; w++)
+      _regs[p][w] = 0;
+    _regs[p][0] = p; // PAGE_ID reads back the page number on every page
+  }
+  _regs[0][(PROD_ID & 0xFF) >> 1] = PROD_ID_VALUE;
+  _regs[3][(FNCTIO_CTRL & 0xFF) >> 1] = 0x000D;
+  _regs[3][(FILTR_BNK_0 & 0xFF) >> 1] = 0x0000;
+  _regs[3][(FILTR_BNK_1 & 0xFF) >> 1] = 0x0000;
+  _page = 0;
+  _response = 0;
+  _nextResponse = 0;
+  _rxCount = 0;
+  _selected = false;
+  _burst = false;
+  _lastDeselectNs = 0;
+  _selectNs = 0;
+  _sampleCount = 0;
+  _nextSampleNs = _nowNs;
+  _lastEdgeNs = _nowNs;
+  _deviceNs = 0;
+  _periodRemainder = 0;
+  _lastPulseNs = 0;
+  _havePulse = false;
+  _syncSampleNs = 0;
+  _syncDivider = 0;
+  _dmaDone = 0;
+  _dmaContext = 0;
+  _dmaDoneNs = 0;
+  resetStats();
+}
+
+void ADIS16490_Sim::resetStats() {
+  _stats.frames = 0;
+  _stats.bytes = 0;
+  _stats.pageSwitches = 0;
+  _stats.stallViolations = 0;
+  _stats.busNs = 0;
+}
+
+void ADIS16490_Sim::begin() {
+}
+
+void ADIS16490_Sim::end() {
+}
+
+void ADIS16490_Sim::configure(uint32_t clock) {
+  if (clock > 0)
+    _clock = clock;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Starts a frame. Frames that begin before the stall time has elapsed
+// since the previous CS deassertion are counted as violations.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::select() {
+  if (_stats.frames > 0 && (_nowNs - _lastDeselectNs) < _stallNs)
+    _stats.stallViolations++;
+  _selected = true;
+  _selectNs = _nowNs;
+  _response = _nextResponse;
+  _nextResponse = 0;
+  _rxCount = 0;
+  _burst = false;
+  _stats.frames++;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Ends a frame and decodes the command it carried
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::deselect() {
+  if (!_selected)
+    return;
+  _selected = false;
+  _stats.busNs += _nowNs - _selectNs;
+  _lastDeselectNs = _nowNs;
+  if (_burst)
+    _burst = false;
+  else if (_rxCount == 2)
+    decodeFrame((_rx[0] << 8) | _rx[1]);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Shifts one byte. MISO carries the word latched by the previous frame,
+// followed by the burst response if the first word was BURST_READ.
+////////////////////////////////////////////////////////////////////////////
+uint8_t ADIS16490_Sim::transfer(uint8_t data) {
+  uint8_t out = shift(data);
+  _stats.bytes++;
+  advance(byteNs());
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Mock DMA transfer. The bytes are shifted immediately but completion is
+// reported only once virtual time reaches the end of the last byte.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::transferAsync(const uint8_t *tx, uint8_t *rx, size_t len,
+                                  void (*done)(void *context), void *context) {
+  for (size_t i = 0; i < len; i++)
+    rx[i] = shift(tx[i]);
+  _stats.bytes += len;
+  _dmaDone = done;
+  _dmaContext = context;
+  _dmaDoneNs = _nowNs + len * byteNs();
+}
+
+uint8_t ADIS16490_Sim::shift(uint8_t data) {
+  uint8_t out = 0;
+  if (_selected) {
+    if (_rxCount == 0)
+      out = _response >> 8;
+    else if (_rxCount == 1)
+      out = _response & 0xFF;
+    else if (_burst && _rxCount < 2 + 2 * BURST_WORDS) {
+      uint16_t word = _burstWords[(_rxCount - 2) >> 1];
+      out = (_rxCount & 0x01) ? (word & 0xFF) : (word >> 8);
+    }
+    // Past the rated SCLK the MISO data is sampled one bit late
+    if (_clock > ((_burst && _rxCount >= 2) ? _maxBurstClock : _maxClock))
+      out >>= 1;
+    if (_rxCount < 2)
+      _rx[_rxCount] = data;
+    if (_rxCount < 0xFF)
+      _rxCount++;
+    if (_rxCount == 2 && _page == 0 && ((_rx[0] << 8) | _rx[1]) == BURST_READ)
+      startBurst();
+  }
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Latches DIAG_STS, gyro, accel, TEMP_OUT, and DATA_CNT followed by the
+// checksum (sum of the 18 preceding bytes)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::startBurst() {
+  static const uint8_t burstAddr[BURST_WORDS - 1] = {
+    DIAG_STS, X_GYRO_OUT, Y_GYRO_OUT, Z_GYRO_OUT, X_ACCL_OUT,
+    Y_ACCL_OUT, Z_ACCL_OUT, TEMP_OUT, DATA_CNT };
+  uint16_t sum = 0;
+  for (int i = 0; i < BURST_WORDS - 1; i++) {
+    _burstWords[i] = _regs[0][burstAddr[i] >> 1];
+    sum += (_burstWords[i] >> 8) + (_burstWords[i] & 0xFF);
+  }
+  _burstWords[BURST_WORDS - 1] = sum;
+  _burst = true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Decodes a 16-bit command. Bit 15 selects a byte write; otherwise the
+// upper byte is the address whose contents appear in the next frame.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::decodeFrame(uint16_t word) {
+  uint8_t address = (word >> 8) & 0x7F;
+  if (word & 0x8000) {
+    uint8_t data = word & 0xFF;
+    if (address == 0x00) {
+      if (data < SIM_PAGES)
+        _page = data;
+      _stats.pageSwitches++;
+    }
+    else if (address > 0x01 && _page != 0) {
+      uint16_t &reg = _regs[_page][address >> 1];
+      if (address & 0x01)
+        reg = (reg & 0x00FF) | (data << 8);
+      else
+        reg = (reg & 0xFF00) | data;
+    }
+    return;
+  }
+  if (address == 0x00)
+    _nextResponse = _page;
+  else
+    _nextResponse = _regs[_page][address >> 1];
+}
+
+void ADIS16490_Sim::writeReset(uint8_t level) {
+  if (level == 0)
+    powerOn();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Data ready is modelled as high for the first half of each output period
+////////////////////////////////////////////////////////////////////////////
+bool ADIS16490_Sim::dataReady() {
+  uint64_t periodNs = (1000000000ULL * ((_regs[3][(DEC_RATE & 0xFF) >> 1] & 0x07FF) + 1)) / SIM_BASE_RATE;
+  uint64_t sinceNs = _nowNs + periodNs - _nextSampleNs;
+  return sinceNs < periodNs / 2;
+}
+
+void ADIS16490_Sim::delayMicros(uint32_t us) {
+  advance((uint64_t)us * 1000);
+}
+
+void ADIS16490_Sim::delayMillis(uint32_t ms) {
+  advance((uint64_t)ms * 1000000);
+}
+
+void ADIS16490_Sim::advanceMicros(uint32_t us) {
+  advance((uint64_t)us * 1000);
+}
+
+uint32_t ADIS16490_Sim::microsNow() {
+  return (uint32_t)(_nowNs / 1000);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Peek/poke helpers used to set up and inspect the register map
+////////////////////////////////////////////////////////////////////////////
+uint16_t ADIS16490_Sim::peek(uint16_t regAddr) const {
+  uint8_t page = (regAddr >> 8) & 0xFF;
+  if (page >= SIM_PAGES)
+    return 0;
+  return _regs[page][(regAddr & 0x7F) >> 1];
+}
+
+void ADIS16490_Sim::poke(uint16_t regAddr, uint16_t value) {
+  uint8_t page = (regAddr >> 8) & 0xFF;
+  if (page >= SIM_PAGES)
+    return;
+  _regs[page][(regAddr & 0x7F) >> 1] = value;
+}
+
+void ADIS16490_Sim::loadSample(const int16_t gyro[3], const int16_t accel[3], int16_t temp) {
+  poke(X_GYRO_OUT, gyro[0]);
+  poke(Y_GYRO_OUT, gyro[1]);
+  poke(Z_GYRO_OUT, gyro[2]);
+  poke(X_ACCL_OUT, accel[0]);
+  poke(Y_ACCL_OUT, accel[1]);
+  poke(Z_ACCL_OUT, accel[2]);
+  poke(TEMP_OUT, temp);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Registers the host-side stand-in for the data ready interrupt
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::attachDataReady(void (*isr)(void *context), void *context) {
+  _drIsr = isr;
+  _drContext = context;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Moves virtual time forward, delivering DMA completions and sample
+// latches in time order. Callbacks may themselves advance time.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::advance(uint64_t ns) {
+  uint64_t target = _nowNs + ns;
+  // Leaving direct sync mode restarts the internal sample clock
+  if (_nextSampleNs == SIM_NEVER && syncMode() != FNCTIO_SYNC_ENABLE)
+    _nextSampleNs = _nowNs;
+  for (;;) {
+    bool dma = (_dmaDone != 0) && (_dmaDoneNs <= _nextSampleNs);
+    uint64_t next = dma ? _dmaDoneNs : _nextSampleNs;
+    bool sync = _nextSyncNs < next;
+    if (sync)
+      next = _nextSyncNs;
+    if (next > target)
+      break;
+    if (next > _nowNs)
+      _nowNs = next;
+    if (sync) {
+      _nextSyncNs += _syncPeriodNs;
+      if (_syncIsr)
+        _syncIsr(_syncContext);
+      syncPulse();
+    }
+    else if (dma) {
+      void (*done)(void *context) = _dmaDone;
+      _dmaDone = 0;
+      done(_dmaContext);
+    }
+    else
+      latchSample();
+  }
+  if (target > _nowNs)
+    _nowNs = target;
+}
+
+void ADIS16490_Sim::latchSample() {
+  uint16_t dec = _regs[3][(DEC_RATE & 0xFF) >> 1] & 0x07FF;
+  _sampleCount++;
+  generateSample(_sampleCount);
+  _regs[0][(DATA_CNT & 0xFF) >> 1] = (uint16_t)_sampleCount;
+  _regs[0][(TIME_STAMP & 0xFF) >> 1] = (uint16_t)(_deviceNs / 1000);
+  _lastEdgeNs = _nowNs;
+
+  // The output period is fixed in device time; a fast device clock
+  // shortens it in host time. Sync modes replace the internal clock.
+  uint64_t periodNs = (1000000000ULL * (dec + 1)) / SIM_BASE_RATE;
+  _deviceNs += periodNs;
+  uint16_t mode = syncMode();
+  if (mode == FNCTIO_SYNC_ENABLE)
+    _nextSampleNs = SIM_NEVER;
+  else {
+    double hostNs = periodNs;
+    if (mode && _syncSampleNs > 0)
+      hostNs = _syncSampleNs * (dec + 1);
+    else if (_clockPpm != 0 || _clockPpmPerSec != 0)
+      hostNs = periodNs / (1.0 + (_clockPpm + _clockPpmPerSec * (_nowNs * 1e-9)) * 1e-6);
+    hostNs += _periodRemainder;
+    periodNs = (uint64_t)hostNs;
+    _periodRemainder = hostNs - periodNs;
+    _nextSampleNs += periodNs;
+  }
+  if (!_drIsr)
+    return;
+  // An edge during the handler stays pending and runs once it returns,
+  // as the NVIC would do for an edge-triggered interrupt
+  if (_drActive) {
+    _drPending = true;
+    return;
+  }
+  _drActive = true;
+  do {
+    _drPending = false;
+    _drIsr(_drContext);
+  } while (_drPending);
+  _drActive = false;
+}
+
+void ADIS16490_Sim::generateSample(uint32_t sampleCount) {
+  (void)sampleCount;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Sync input edge
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::syncPulse() {
+  uint64_t last = _lastPulseNs;
+  bool had = _havePulse;
+  _lastPulseNs = _nowNs;
+  _havePulse = true;
+  uint16_t mode = syncMode();
+  uint16_t dec = _regs[3][(DEC_RATE & 0xFF) >> 1] & 0x07FF;
+  if (mode == FNCTIO_SYNC_ENABLE) {
+    _nextSampleNs = SIM_NEVER;
+    if (++_syncDivider > dec) {
+      _syncDivider = 0;
+      latchSample();
+    }
+    return;
+  }
+  uint16_t scale = _regs[3][(SYNC_SCALE & 0xFF) >> 1];
+  if (!mode || !had || scale == 0)
+    return;
+
+  // Lock the sample clock to the measured edge interval and phase the
+  // next output to this edge. An output latched within 1/16 of an
+  // internal sample already belongs to it; an earlier one leaves a short
+  // interval, as while the PLL acquires.
+  _syncSampleNs = (double)(_nowNs - last) / scale;
+  double periodNs = _syncSampleNs * (dec + 1);
+  _periodRemainder = 0;
+  if (_nowNs - _lastEdgeNs > _syncSampleNs / 16)
+    _nextSampleNs = _nowNs;
+  else
+    _nextSampleNs = _lastEdgeNs + (uint64_t)periodNs;
+  advance(0);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Starts or stops the periodic sync source. The first edge is one period
+// from now.
+////////////////////////////////////////////////////////////////////////////
+// periodMicros - edge interval (us), 0 to stop
+// isr - host callback run at each edge, or 0
+// context - passed to isr
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Sim::setSyncInput(uint32_t periodMicros, void (*isr)(void *context), void *context) {
+  _syncPeriodNs = (uint64_t)periodMicros * 1000;
+  _nextSyncNs = periodMicros ? _nowNs + _syncPeriodNs : SIM_NEVER;
+  _syncIsr = isr;
+  _syncContext = context;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Active sync mode: 0 (internal clock), FNCTIO_SYNC_ENABLE (direct), or
+// FNCTIO_SYNC_ENABLE | FNCTIO_SYNC_SCALED (scaled)
+////////////////////////////////////////////////////////////////////////////
+uint16_t ADIS16490_Sim::syncMode() const {
+  uint16_t fnctio = _regs[3][(FNCTIO_CTRL & 0xFF) >> 1];
+  if (!(fnctio & FNCTIO_SYNC_ENABLE))
+    return 0;
+  return fnctio & (FNCTIO_SYNC_ENABLE | FNCTIO_SYNC_SCALED);
+}
@@ -0,0 +1,233 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Sim.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Register-map simulator of the ADIS16490 implementing the ADIS16490_Bus interface. The simulator
+//  models all thirteen register pages (0 ~ 12), PAGE_ID switching, byte-wide register writes, and
+//  the one-frame-delayed read pipeline (the data for an address is returned in the frame after the
+//  address is sent). Time is virtual and advanced by SCLK edges and delays, so latency figures are
+//  reproducible on a host PC. Frame, byte, page switch, and stall violation counters are kept so
+//  the cost of each driver function can be measured without hardware. TIME_STAMP counts device
+//  microseconds, and the device clock can be given a frequency error that drifts over time. The
+//  sync input (direct and scaled modes) is driven by syncPulse() or by a periodic reference that
+//  also raises a host interrupt, standing in for a PPS source wired to both.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Sim_h
+#define ADIS16490_Sim_h
+#include "ADIS16490.h"
+
+// Number of register pages and 16-bit words per page
+#define SIM_PAGES     13
+#define SIM_PAGE_WORDS 64
+
+// Internal sample rate of the ADIS16490 before decimation (Hz)
+#define SIM_BASE_RATE 4250
+
+// Sample time used while no sample is scheduled (direct sync mode)
+#define SIM_NEVER 0xFFFFFFFFFFFFFFFFULL
+
+// Bus activity counters
+struct ADIS16490_SimStats {
+  uint32_t frames;          // CS assertions
+  uint32_t bytes;           // Bytes clocked in either direction
+  uint32_t pageSwitches;    // Writes to PAGE_ID
+  uint32_t stallViolations; // Frames started before the minimum stall time elapsed
+  uint64_t busNs;           // Time spent with CS asserted
+};
+
+// ADIS16490 simulator class definition
+class ADIS16490_Sim : public ADIS16490_Bus {
+
+public:
+  ADIS16490_Sim();
+
+  // ADIS16490_Bus interface
+  void begin();
+  void end();
+  void configure(uint32_t clock);
+  void select();
+  void deselect();
+  uint8_t transfer(uint8_t data);
+  using ADIS16490_Bus::transfer;
+  void transferAsync(const uint8_t *tx, uint8_t *rx, size_t len,
+                     void (*done)(void *context), void *context);
+  void writeReset(uint8_t level);
+  bool dataReady();
+  void delayMicros(uint32_t us);
+  void delayMillis(uint32_t ms);
+  uint32_t microsNow();
+  uint32_t cycleCount() { return (uint32_t)_nowNs; }
+  uint32_t cyclesPerMicro() { return 1000; }
+  void delayCycles(uint32_t cycles) { advance(cycles); }
+
+  // Restores the power-on register map and clears the statistics
+  void powerOn();
+
+  // Reads a register directly, bypassing the SPI model
+  uint16_t peek(uint16_t regAddr) const;
+
+  // Writes a register directly, bypassing the SPI model
+  void poke(uint16_t regAddr, uint16_t value);
+
+  // Loads a new set of 16-bit outputs into the page 0 registers
+  void loadSample(const int16_t gyro[3], const int16_t accel[3], int16_t temp);
+
+  // Advances virtual time without bus activity. Pending DMA completions and
+  // data ready edges are delivered in time order.
+  void advanceMicros(uint32_t us);
+
+  // Registers a callback run on every data ready rising edge, standing in
+  // for attachInterrupt() on host builds
+  void attachDataReady(void (*isr)(void *context), void *context);
+
+  // True while a transferAsync() is in flight
+  bool dmaBusy() const { return _dmaDone != 0; }
+
+  // Virtual time in nanoseconds
+  uint64_t nanos() const { return _nowNs; }
+
+  // Highest SCLK rates at which MISO data is read correctly (Hz)
+  void setMaxClock(uint32_t regClock, uint32_t burstClock) { _maxClock = regClock; _maxBurstClock = burstClock; }
+
+  // Device oscillator error (ppm, positive runs fast) and its drift rate
+  // (ppm/sec). The output period and TIME_STAMP follow the device clock.
+  void setClockError(double ppm, double ppmPerSecond = 0) { _clockPpm = ppm; _clockPpmPerSec = ppmPerSecond; }
+
+  // Sync input edge. In direct sync mode each edge is one internal sample;
+  // in scaled sync mode the sample clock runs at SYNC_SCALE times the edge
+  // rate, phased to the edge, and holds its rate if edges stop.
+  void syncPulse();
+
+  // Periodic sync input, such as a PPS source also wired to a host pin.
+  // Edges are delivered in time order with the other events; isr (if
+  // any) runs at the edge time, before the device sees it. A period of
+  // 0 stops the source.
+  void setSyncInput(uint32_t periodMicros, void (*isr)(void *context) = 0, void *context = 0);
+
+  // Virtual time of the most recent data ready edge (ns)
+  uint64_t lastEdgeNanos() const { return _lastEdgeNs; }
+
+  // Minimum CS high time enforced between frames (us)
+  void setStallTime(uint32_t us) { _stallNs = (uint64_t)us * 1000; }
+
+  // Bus activity counters
+  const ADIS16490_SimStats &stats() const { return _stats; }
+  void resetStats();
+
+protected:
+  // Called once per internal sample period. The default holds the loaded
+  // outputs constant; override to generate motion profiles.
+  virtual void generateSample(uint32_t sampleCount);
+
+  // Register storage, indexed by page and word
+  uint16_t _regs[SIM_PAGES][SIM_PAGE_WORDS];
+
+private:
+  // Latches the burst response after a BURST_READ command
+  void startBurst();
+
+  // Shifts one byte through the SPI model without advancing time
+  uint8_t shift(uint8_t data);
+
+  // Duration of one byte at the current SCLK rate
+  uint64_t byteNs() const { return 8000000000ULL / _clock; }
+
+  // Latches a new sample and raises data ready
+  void latchSample();
+
+  // Decodes a completed 16-bit frame
+  void decodeFrame(uint16_t word);
+
+  // Advances virtual time and latches any samples that became due
+  void advance(uint64_t ns);
+
+  // Active sync mode bits of FNCTIO_CTRL
+  uint16_t syncMode() const;
+
+  // Currently selected page
+  uint8_t _page;
+
+  // Word shifted out on MISO during the current frame
+  uint16_t _response;
+
+  // Word to be shifted out during the next frame
+  uint16_t _nextResponse;
+
+  // Bytes received in the current frame
+  uint8_t _rx[2];
+  uint8_t _rxCount;
+  bool _selected;
+
+  // Burst response (DIAG_STS ~ CHECKSUM), valid when _burst is set
+  uint16_t _burstWords[BURST_WORDS];
+  bool _burst;
+
+  // SCLK rate and timing
+  uint32_t _clock;
+  uint32_t _maxClock;
+  uint32_t _maxBurstClock;
+  uint64_t _nowNs;
+  uint64_t _lastDeselectNs;
+  uint64_t _selectNs;
+  uint64_t _stallNs;
+  uint64_t _nextSampleNs;
+  uint64_t _lastEdgeNs;
+  uint32_t _sampleCount;
+
+  // Device clock model: elapsed device time and fraction of a host
+  // nanosecond carried between output periods
+  double _clockPpm;
+  double _clockPpmPerSec;
+  uint64_t _deviceNs;
+  double _periodRemainder;
+
+  // Sync input state: last edge, sample period locked to the edges (0
+  // until two edges have been seen), and direct mode decimation count
+  uint64_t _lastPulseNs;
+  bool _havePulse;
+  double _syncSampleNs;
+  uint16_t _syncDivider;
+
+  // Periodic sync source and its host callback
+  uint64_t _syncPeriodNs;
+  uint64_t _nextSyncNs;
+  void (*_syncIsr)(void *context);
+  void *_syncContext;
+
+  // Pending mock DMA transfer
+  void (*_dmaDone)(void *context);
+  void *_dmaContext;
+  uint64_t _dmaDoneNs;
+
+  // Data ready edge callback
+  void (*_drIsr)(void *context);
+  void *_drContext;
+  bool _drActive;
+  bool _drPending;
+
+  ADIS16490_SimStats _stats;
+
+};
+
+#endif
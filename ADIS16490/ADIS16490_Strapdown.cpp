@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Strapdown.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Quaternion strapdown integrator for the ADIS16490 delta angle and delta velocity outputs. See
+//  ADIS16490_Strapdown.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Strapdown.h"
+#include <math.h>
+
+// 32-bit delta output LSBs to rad and m/sec
+#define DELTANG_RAD (DELTANG_LSB / 65536.0f * 0.017453293f)
+#define DELTVEL_MPS (DELTVEL_LSB / 65536.0f * 0.001f)
+
+static inline void cross(const float *a, const float *b, float *out) {
+  out[0] = a[1] * b[2] - a[2] * b[1];
+  out[1] = a[2] * b[0] - a[0] * b[2];
+  out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor. Starts level, at rest, at the origin, with gravity and
+// compensation enabled.
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_Strapdown::ADIS16490_Strapdown() {
+  _gravity = STRAPDOWN_GRAVITY;
+  _compensate = true;
+  reset();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Restarts the integration
+////////////////////////////////////////////////////////////////////////////
+// quaternion - initial attitude (w, x, y, z), or 0 for level
+// velocity - initial NED velocity (m/sec), or 0 for at rest
+// position - initial NED position (m), or 0 for the origin
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Strapdown::reset(const float *quaternion, const float *velocity, const float *position) {
+  for (int i = 0; i < 4; i++)
+    _q[i] = quaternion ? quaternion[i] : (i == 0 ? 1.0f : 0.0f);
+  for (int i = 0; i < 3; i++) {
+    _v[i] = velocity ? velocity[i] : 0.0f;
+    _p[i] = position ? position[i] : 0.0f;
+    _prevAngle[i] = 0.0f;
+    _prevVelocity[i] = 0.0f;
+  }
+  _updates = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Integrates one output period. The two-sample corrections use the
+// previous increments, so the first update after reset() is uncorrected.
+////////////////////////////////////////////////////////////////////////////
+// dAngle - body delta angle (rad)
+// dVelocity - body delta velocity (m/sec)
+// dt - output period (sec)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Strapdown::update(const float *dAngle, const float *dVelocity, float dt) {
+  float phi[3], dv[3], t0[3], t1[3];
+
+  // Rotation vector with coning correction, and body velocity increment
+  // with rotation compensation and sculling correction
+  cross(dAngle, dVelocity, t0);
+  for (int i = 0; i < 3; i++) {
+    phi[i] = dAngle[i];
+    dv[i] = dVelocity[i] + 0.5f * t0[i];
+  }
+  if (_compensate && _updates) {
+    cross(_prevAngle, dAngle, t0);
+    for (int i = 0; i < 3; i++)
+      phi[i] += t0[i] * (1.0f / 12.0f);
+    cross(_prevAngle, dVelocity, t0);
+    cross(_prevVelocity, dAngle, t1);
+    for (int i = 0; i < 3; i++)
+      dv[i] += (t0[i] + t1[i]) * (1.0f / 12.0f);
+  }
+
+  // Rotate the velocity increment into NED with the attitude at the start
+  // of the period: v' = v + 2w(r x v) + 2r x (r x v)
+  const float *r = _q + 1;
+  cross(r, dv, t0);
+  cross(r, t0, t1);
+  float vPrev[3] = {_v[0], _v[1], _v[2]};
+  for (int i = 0; i < 3; i++)
+    _v[i] += dv[i] + 2.0f * (_q[0] * t0[i] + t1[i]);
+  _v[2] += _gravity * dt;
+
+  // Trapezoidal position
+  for (int i = 0; i < 3; i++)
+    _p[i] += 0.5f * (vPrev[i] + _v[i]) * dt;
+
+  // Quaternion of the rotation vector from the series of cos(|phi|/2) and
+  // sin(|phi|/2)/|phi|; the terms kept are exact to float precision for
+  // |phi| below 0.1 rad per update (1000 deg/sec at 4250 Hz)
+  float n2 = phi[0] * phi[0] + phi[1] * phi[1] + phi[2] * phi[2];
+  float n4 = n2 * n2;
+  float dw = 1.0f - n2 * (1.0f / 8.0f) + n4 * (1.0f / 384.0f);
+  float ds = 0.5f - n2 * (1.0f / 48.0f) + n4 * (1.0f / 3840.0f);
+  float dx = phi[0] * ds, dy = phi[1] * ds, dz = phi[2] * ds;
+  float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+  _q[0] = w * dw - x * dx - y * dy - z * dz;
+  _q[1] = w * dx + x * dw + y * dz - z * dy;
+  _q[2] = w * dy - x * dz + y * dw + z * dx;
+  _q[3] = w * dz + x * dy - y * dx + z * dw;
+
+  // One Newton step toward unit length keeps the norm without a sqrt
+  float norm = 0.5f * (3.0f - (_q[0] * _q[0] + _q[1] * _q[1] + _q[2] * _q[2] + _q[3] * _q[3]));
+  for (int i = 0; i < 4; i++)
+    _q[i] *= norm;
+
+  for (int i = 0; i < 3; i++) {
+    _prevAngle[i] = dAngle[i];
+    _prevVelocity[i] = dVelocity[i];
+  }
+  _updates++;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Integrates one output period of raw 32-bit delta outputs
+////////////////////////////////////////////////////////////////////////////
+// delta - deltaRead() result
+// dt - output period (sec)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Strapdown::update(const ADIS16490_Delta &delta, float dt) {
+  float dAngle[3], dVelocity[3];
+  for (int i = 0; i < 3; i++) {
+    dAngle[i] = (float)delta.angle[i] * DELTANG_RAD;
+    dVelocity[i] = (float)delta.velocity[i] * DELTVEL_MPS;
+  }
+  update(dAngle, dVelocity, dt);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Converts the attitude quaternion to ZYX Euler angles
+////////////////////////////////////////////////////////////////////////////
+// roll, pitch, yaw - rotation about X, Y, Z (rad)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_Strapdown::euler(float &roll, float &pitch, float &yaw) const {
+  float w = _q[0], x = _q[1], y = _q[2], z = _q[3];
+  roll = atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y));
+  float s = 2.0f * (w * y - z * x);
+  pitch = asinf(s > 1.0f ? 1.0f : (s < -1.0f ? -1.0f : s));
+  yaw = atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z));
+}
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Strapdown.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Quaternion strapdown integrator driven by the ADIS16490 delta angle and delta velocity outputs.
+//  Each update applies two-sample coning and sculling corrections plus velocity rotation
+//  compensation, advances the body-to-navigation quaternion with a truncated series (no trig or
+//  square roots), and integrates velocity and position in a north-east-down frame with constant
+//  gravity. Every update costs the same fixed number of float operations, so it can run once per
+//  output from loop() or from a capture callback.
+//
+//  deltaRead() needs more than one output period at DEC_RATE = 0, so the delta path runs at
+//  DEC_RATE >= 1 (2125 Hz or less). Skip reads that return 0 and check dataCount for missed outputs;
+//  each delta covers one output period only.
+//
+//  Earth rate and transport rate are ignored; over the time spans a MEMS IMU can navigate they are
+//  well below the sensor bias.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Strapdown_h
+#define ADIS16490_Strapdown_h
+#include "ADIS16490.h"
+
+// Standard gravity (m/sec^2)
+#define STRAPDOWN_GRAVITY 9.80665f
+
+// Strapdown integrator class definition
+class ADIS16490_Strapdown {
+
+public:
+  ADIS16490_Strapdown();
+
+  // Restarts from the given attitude (w, x, y, z; body to NED), velocity
+  // (m/sec, NED), and position (m, NED). Null arguments default to level,
+  // at rest, and at the origin.
+  void reset(const float *quaternion = 0, const float *velocity = 0, const float *position = 0);
+
+  // Gravity along the down axis (m/sec^2). 0 disables gravity.
+  void setGravity(float gravity) { _gravity = gravity; }
+
+  // Enables the coning and sculling corrections (on by default)
+  void setCompensation(bool enabled) { _compensate = enabled; }
+
+  // Integrates one output period.
+  // dAngle - body delta angle (rad)
+  // dVelocity - body delta velocity (m/sec)
+  // dt - output period (sec)
+  void update(const float *dAngle, const float *dVelocity, float dt);
+
+  // Integrates one output period from deltaRead() data
+  void update(const ADIS16490_Delta &delta, float dt);
+
+  // Attitude quaternion (w, x, y, z), velocity (m/sec), position (m)
+  const float *quaternion() const { return _q; }
+  const float *velocity() const { return _v; }
+  const float *position() const { return _p; }
+
+  // Attitude as roll, pitch, yaw (rad). Uses trig; keep it out of the
+  // update loop.
+  void euler(float &roll, float &pitch, float &yaw) const;
+
+  // Updates since reset()
+  uint32_t updates() const { return _updates; }
+
+private:
+  float _q[4];
+  float _v[3];
+  float _p[3];
+  float _prevAngle[3];
+  float _prevVelocity[3];
+  float _gravity;
+  bool _compensate;
+  uint32_t _updates;
+
+};
+
+#endif
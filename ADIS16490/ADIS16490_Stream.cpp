@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Stream.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Binary frame encoder and decoder for streaming ADIS16490 samples. See ADIS16490_Stream.h for the
+//  frame layout.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Stream.h"
+
+// Little-endian field helpers
+static inline void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static inline uint16_t get16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// CRC-16/CCITT-FALSE, four bits at a time from a 16-entry table
+////////////////////////////////////////////////////////////////////////////
+// data - bytes to check
+// len - number of bytes
+// return - CRC of the bytes
+////////////////////////////////////////////////////////////////////////////
+uint16_t ADIS16490_streamCrc(const uint8_t *data, size_t len) {
+  static const uint16_t table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF };
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+  return crc;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Encodes one sample
+////////////////////////////////////////////////////////////////////////////
+// sample - sample to send
+// frame - destination, STREAM_FRAME_BYTES long
+// return - bytes written
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_StreamEncoder::encode(const ADIS16490_Sample &sample, uint8_t *frame) {
+  frame[0] = STREAM_SYNC0;
+  frame[1] = STREAM_SYNC1;
+  put16(frame + 2, _sequence++);
+  put16(frame + 4, sample.timestamp & 0xFFFF);
+  put16(frame + 6, sample.timestamp >> 16);
+  put16(frame + 8, sample.status);
+  put16(frame + 10, sample.dataCount);
+  for (int i = 0; i < 3; i++) {
+    put16(frame + 12 + 2 * i, sample.gyro[i]);
+    put16(frame + 18 + 2 * i, sample.accel[i]);
+  }
+  put16(frame + 24, sample.temp);
+  put16(frame + 26, ADIS16490_streamCrc(frame + 2, STREAM_FRAME_BYTES - 4));
+  return STREAM_FRAME_BYTES;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Encodes a block of samples into one buffer, e.g. for a single
+// Serial.write()
+////////////////////////////////////////////////////////////////////////////
+// samples - samples to send
+// count - number of samples
+// buffer - destination
+// size - length of buffer in bytes
+// return - bytes written
+////////////////////////////////////////////////////////////////////////////
+size_t ADIS16490_StreamEncoder::encode(const ADIS16490_Sample *samples, size_t count,
+                                       uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  for (size_t i = 0; i < count && written + STREAM_FRAME_BYTES <= size; i++)
+    written += encode(samples[i], buffer + written);
+  return written;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Clears the decoder state
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_StreamDecoder::reset() {
+  _length = 0;
+  _sequence = 0;
+  _synced = false;
+  _stats = ADIS16490_StreamStats();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Feeds one byte into the decoder
+////////////////////////////////////////////////////////////////////////////
+// byte - received byte
+// sample - filled when a frame completes
+// return - 1 if a valid frame completed, 0 otherwise
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_StreamDecoder::push(uint8_t byte, ADIS16490_Sample &sample) {
+  // Hunt for the sync word
+  if (_length == 0 && byte != STREAM_SYNC0) {
+    _stats.skipped++;
+    return 0;
+  }
+  if (_length == 1 && byte != STREAM_SYNC1) {
+    _stats.skipped++;
+    _length = 0;
+    return push(byte, sample);
+  }
+
+  _frame[_length++] = byte;
+  if (_length < STREAM_FRAME_BYTES)
+    return 0;
+
+  if (ADIS16490_streamCrc(_frame + 2, STREAM_FRAME_BYTES - 4) != get16(_frame + 26)) {
+    _stats.crcErrors++;
+    resync();
+    return 0;
+  }
+  _length = 0;
+
+  uint16_t sequence = get16(_frame + 2);
+  if (_synced)
+    _stats.lost += (uint16_t)(sequence - _sequence - 1);
+  _sequence = sequence;
+  _synced = true;
+  _stats.frames++;
+
+  sample.timestamp = get16(_frame + 4) | ((uint32_t)get16(_frame + 6) << 16);
+  sample.status = get16(_frame + 8);
+  sample.dataCount = get16(_frame + 10);
+  for (int i = 0; i < 3; i++) {
+    sample.gyro[i] = get16(_frame + 12 + 2 * i);
+    sample.accel[i] = get16(_frame + 18 + 2 * i);
+  }
+  sample.temp = get16(_frame + 24);
+  sample.reserved = 0;
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// After a CRC failure the sync word may have been a false match, and a
+// real frame may start inside the rejected bytes. Drop the first byte and
+// replay the rest through the sync search.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_StreamDecoder::resync() {
+  uint8_t pending[STREAM_FRAME_BYTES - 1];
+  size_t count = _length - 1;
+  for (size_t i = 0; i < count; i++)
+    pending[i] = _frame[i + 1];
+  _length = 0;
+  _stats.skipped++;
+
+  ADIS16490_Sample discard;
+  for (size_t i = 0; i < count; i++)
+    push(pending[i], discard);
+}
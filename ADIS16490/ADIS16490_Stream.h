@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Stream.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Compact binary framing for streaming ADIS16490 samples over a serial link. Each sample becomes
+//  one fixed-size frame:
+//
+//    offset  size  field
+//    0       2     sync word 0xA5 0x5A
+//    2       2     sequence number (increments per frame, wraps)
+//    4       4     timestamp (us)
+//    8       18    DIAG_STS, DATA_CNT, X/Y/Z_GYRO_OUT, X/Y/Z_ACCL_OUT, TEMP_OUT
+//    26      2     CRC-16/CCITT-FALSE over bytes 2..25
+//
+//  All multi-byte fields are little-endian. The encoder writes into a caller buffer and never
+//  allocates. The decoder is a byte-at-a-time state machine that resynchronizes on the sync word
+//  after corruption; it is shared by the host decoder tool in extras/.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_Stream_h
+#define ADIS16490_Stream_h
+#include "ADIS16490.h"
+
+// Frame layout
+#define STREAM_SYNC0       0xA5
+#define STREAM_SYNC1       0x5A
+#define STREAM_FRAME_BYTES 28
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+uint16_t ADIS16490_streamCrc(const uint8_t *data, size_t len);
+
+// Frame encoder
+class ADIS16490_StreamEncoder {
+
+public:
+  ADIS16490_StreamEncoder() : _sequence(0) {}
+
+  // Writes one frame for sample into frame (STREAM_FRAME_BYTES long) and
+  // returns the number of bytes written
+  size_t encode(const ADIS16490_Sample &sample, uint8_t *frame);
+
+  // Encodes up to count samples back to back into buffer (size bytes).
+  // Returns the number of bytes written; only whole frames are written.
+  size_t encode(const ADIS16490_Sample *samples, size_t count, uint8_t *buffer, size_t size);
+
+  // Sequence number of the next frame
+  uint16_t sequence() const { return _sequence; }
+
+private:
+  uint16_t _sequence;
+
+};
+
+// Decoder counters
+struct ADIS16490_StreamStats {
+  uint32_t frames;     // Frames with a valid CRC
+  uint32_t crcErrors;  // Frames discarded for a CRC mismatch
+  uint32_t skipped;    // Bytes discarded while searching for sync
+  uint32_t lost;       // Frames missing according to the sequence number
+};
+
+// Frame decoder
+class ADIS16490_StreamDecoder {
+
+public:
+  ADIS16490_StreamDecoder() { reset(); }
+
+  // Clears the partial frame and the counters
+  void reset();
+
+  // Feeds one received byte. Returns 1 and fills sample when the byte
+  // completes a valid frame, 0 otherwise.
+  int push(uint8_t byte, ADIS16490_Sample &sample);
+
+  // Sequence number of the last valid frame
+  uint16_t sequence() const { return _sequence; }
+
+  const ADIS16490_StreamStats &stats() const { return _stats; }
+
+private:
+  // Drops the first byte of a bad frame and rescans the rest for sync
+  void resync();
+
+  uint8_t _frame[STREAM_FRAME_BYTES];
+  size_t _length;
+  uint16_t _sequence;
+  bool _synced;
+  ADIS16490_StreamStats _stats;
+
+};
+
+#endif
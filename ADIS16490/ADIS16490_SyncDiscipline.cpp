@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_SyncDiscipline.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Sample clock discipline for the ADIS16490. See ADIS16490_SyncDiscipline.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_SyncDiscipline.h"
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// imu - driver instance used to apply the configuration
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_SyncDiscipline::ADIS16490_SyncDiscipline(ADIS16490 &imu) {
+  _imu = &imu;
+  _config = ADIS16490_SyncConfig();
+  _expected = 0;
+  _halfPeriod = 0;
+  _tolerance = SYNC_PHASE_TOLERANCE;
+  _pending = false;
+  _state = SYNC_ACQUIRING;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Applies the configuration and derives the expected output count per
+// reference interval from it and DEC_RATE
+// Returns 1 when the configuration was accepted.
+////////////////////////////////////////////////////////////////////////////
+// config - sample clock configuration
+// inputHz - sync input rate, ignored for SYNC_INTERNAL
+// referenceMicros - interval between reference pulses (us)
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_SyncDiscipline::begin(const ADIS16490_SyncConfig &config, float inputHz, uint32_t referenceMicros) {
+  _config = config;
+  float decimation = (float)((_imu->regRead(DEC_RATE) & 0x07FF) + 1);
+  float rate;
+  if (config.mode == SYNC_SCALED)
+    rate = config.scale * inputHz / decimation;
+  else if (config.mode == SYNC_DIRECT)
+    rate = inputHz / decimation;
+  else
+    rate = 4250.0f / decimation;
+  _expected = rate * referenceMicros * 1e-6f;
+  _halfPeriod = (uint32_t)(500000.0f / rate);
+  _pending = false;
+  _marked = false;
+  _outputs = 0;
+  _expectedTotal = 0;
+  _carry = 0;
+  _state = SYNC_ACQUIRING;
+  _matchRun = 0;
+  _missRun = 0;
+  _stats = ADIS16490_SyncStats();
+  return(_imu->setSync(config));
+}
+
+void ADIS16490_SyncDiscipline::onPulse(uint32_t micros) {
+  _pulse = micros;
+  _pending = true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Marks the pending pulse with the first output no more than half an
+// output period before it, then compares the DATA_CNT step since the
+// previous mark with the expected count and, in scaled sync mode, the
+// marking output time with the pulse
+// Returns the state.
+////////////////////////////////////////////////////////////////////////////
+// sample - next captured sample
+////////////////////////////////////////////////////////////////////////////
+uint8_t ADIS16490_SyncDiscipline::update(const ADIS16490_Sample &sample) {
+  if (!_pending)
+    return(_state);
+  int32_t phase = (int32_t)(sample.timestamp - _pulse);
+  if (phase < -(int32_t)_halfPeriod)
+    return(_state);
+  _pending = false;
+  _stats.pulses++;
+  _stats.phase = phase;
+  if (!_marked) {
+    _marked = true;
+    _markCount = sample.dataCount;
+    return(_state);
+  }
+
+  // Carrying the rounding remainder lets fractional counts per interval
+  // average out
+  uint16_t outputs = sample.dataCount - _markCount;
+  _markCount = sample.dataCount;
+  float due = _expected + _carry;
+  uint32_t count = (uint32_t)(due + 0.5f);
+  _carry = due - count;
+  _expectedTotal += count;
+  _outputs += outputs;
+  _stats.lastError = (int32_t)outputs - (int32_t)count;
+  _stats.totalError = (int32_t)(_outputs - _expectedTotal);
+  // A scaled sync output clock is phased to the reference, so a matching
+  // count with the output elsewhere means the device is free running
+  bool inPhase = true;
+  if (_config.mode == SYNC_SCALED && (uint32_t)(phase < 0 ? -phase : phase) > _tolerance) {
+    _stats.outOfPhase++;
+    inPhase = false;
+  }
+  if (_stats.lastError == 0 && inPhase) {
+    _stats.matches++;
+    _missRun = 0;
+    if (_matchRun < SYNC_LOCK_PULSES)
+      _matchRun++;
+    if (_matchRun >= SYNC_LOCK_PULSES)
+      _state = SYNC_LOCKED;
+  }
+  else {
+    _stats.misses++;
+    _matchRun = 0;
+    if (_missRun < 0xFF)
+      _missRun++;
+    _state = SYNC_UNLOCKED;
+  }
+  return(_state);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Writes the configuration again and restarts the lock
+// Returns 1 when the configuration was accepted.
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_SyncDiscipline::reapply() {
+  _stats.reapplied++;
+  _missRun = 0;
+  _matchRun = 0;
+  _marked = false;
+  _pending = false;
+  _state = SYNC_ACQUIRING;
+  return(_imu->setSync(_config));
+}
+
+float ADIS16490_SyncDiscipline::rateError() const {
+  if (_expectedTotal == 0)
+    return 0;
+  return (float)_stats.totalError / (float)_expectedTotal * 1e6f;
+}
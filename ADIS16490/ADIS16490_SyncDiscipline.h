@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_SyncDiscipline.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Sample clock discipline for the ADIS16490. setSync() configures the clock source; this loop
+//  checks that the configuration holds. A reference pulse (typically the same GPS PPS that drives
+//  the sync input) is timestamped by the host, and the captured sample stream is checked against
+//  it: the first output no more than half a period before each pulse marks the pulse, and the
+//  DATA_CNT difference between consecutive marks is compared with the number of outputs the
+//  configuration should produce.
+//
+//  The offset of the marking output from the pulse is the phase. In scaled sync mode the outputs
+//  are phased to the reference, so a phase beyond the tolerance also counts as a miss; this catches
+//  a unit that lost its configuration and free runs at nearly the same rate. Units locked to the
+//  same pulse report the same phase, which is how their alignment is verified.
+//
+//  After SYNC_LOCK_PULSES matching intervals the loop reports SYNC_LOCKED. A miss unlocks it, and
+//  after SYNC_RETRY_PULSES misses in a row reapplyNeeded() asks the application to stop capture and
+//  call reapply().
+//
+//  onPulse() is cheap enough for the pulse interrupt; update() runs in loop() on each sample.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_SyncDiscipline_h
+#define ADIS16490_SyncDiscipline_h
+#include "ADIS16490.h"
+
+// Discipline states
+#define SYNC_ACQUIRING 0 // Fewer than two pulses marked
+#define SYNC_LOCKED    1 // Output count matched for SYNC_LOCK_PULSES intervals
+#define SYNC_UNLOCKED  2 // Last interval did not match
+
+// Intervals to lock, and consecutive misses before reapplying the config
+#define SYNC_LOCK_PULSES  3
+#define SYNC_RETRY_PULSES 5
+
+// Default phase tolerance in scaled sync mode (us)
+#define SYNC_PHASE_TOLERANCE 20
+
+// Discipline counters
+struct ADIS16490_SyncStats {
+  uint32_t pulses;     // Reference pulses marked in the sample stream
+  uint32_t matches;    // Intervals with the expected output count
+  uint32_t misses;     // Intervals with more or fewer outputs, or out of phase
+  uint32_t outOfPhase; // Scaled sync intervals whose marking output missed the pulse
+  uint32_t reapplied;  // Calls to reapply()
+  int32_t lastError;   // Outputs in the last interval minus expected
+  int32_t totalError;  // Outputs since the first marked pulse minus expected
+  int32_t phase;       // Marking output time minus pulse time (us)
+};
+
+// Sample clock discipline class definition
+class ADIS16490_SyncDiscipline {
+
+public:
+  ADIS16490_SyncDiscipline(ADIS16490 &imu);
+
+  // Applies config with setSync() and derives the expected outputs per
+  // reference interval
+  // config - sample clock configuration
+  // inputHz - sync input rate (SYNC_DIRECT and SYNC_SCALED)
+  // referenceMicros - interval between reference pulses (us)
+  // Returns 1 when the configuration was accepted.
+  int begin(const ADIS16490_SyncConfig &config, float inputHz = 1.0f, uint32_t referenceMicros = 1000000);
+
+  // Reference pulse timestamp (host us). Interrupt safe.
+  void onPulse(uint32_t micros);
+
+  // Largest |phase| accepted in scaled sync mode, where outputs should
+  // fall on the reference pulse (us)
+  void setPhaseTolerance(uint32_t micros) { _tolerance = micros; }
+
+  // Checks one captured sample against the pending pulse. Samples must be
+  // passed in capture order. Returns the state.
+  uint8_t update(const ADIS16490_Sample &sample);
+
+  // True after SYNC_RETRY_PULSES consecutive misses
+  bool reapplyNeeded() const { return _missRun >= SYNC_RETRY_PULSES; }
+
+  // Writes the configuration again. The bus must be free (capture stopped).
+  // Returns 1 when the configuration was accepted.
+  int reapply();
+
+  uint8_t state() const { return _state; }
+  const ADIS16490_SyncStats &stats() const { return _stats; }
+
+  // Outputs expected per reference interval
+  float expected() const { return _expected; }
+
+  // Average output rate error against the reference since the first
+  // marked pulse (ppm)
+  float rateError() const;
+
+private:
+  ADIS16490 *_imu;
+  ADIS16490_SyncConfig _config;
+  float _expected;
+  float _carry;               // Rounding remainder of the expected count
+  uint32_t _expectedTotal;    // Expected outputs since the first marked pulse
+  uint32_t _halfPeriod;      // Half an output period (us)
+  uint32_t _tolerance;       // Phase tolerance in scaled sync mode (us)
+  volatile uint32_t _pulse;  // Time of the pending pulse
+  volatile bool _pending;
+  bool _marked;              // A pulse has been marked
+  uint16_t _markCount;       // DATA_CNT of the last marking output
+  uint32_t _outputs;         // Outputs since the first marked pulse
+  uint8_t _state;
+  uint8_t _matchRun;
+  uint8_t _missRun;
+  ADIS16490_SyncStats _stats;
+
+};
+
+#endif
@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_TimeSync.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  TIME_STAMP to host time correlation for the ADIS16490. See ADIS16490_TimeSync.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_TimeSync.h"
+
+// Assumed edge jitter (us) and initial drift uncertainty (ppm) of the fit
+#define TIMESYNC_JITTER 2.0f
+#define TIMESYNC_DRIFT0 200.0f
+
+// Offset beyond which whole microseconds move into _base (us)
+#define TIMESYNC_REBASE 1000.0f
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor. Defaults to the 4250 Hz output period and a forgetting
+// factor averaging roughly the last 200 correlation points.
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_TimeSync::ADIS16490_TimeSync() {
+  _version = 0;
+  _lambda = 0.995f;
+  _period = 1000000.0f / 4250;
+  reset();
+}
+
+void ADIS16490_TimeSync::reset() {
+  beginWrite();
+  _deviceRef = 0;
+  _base = 0;
+  _countRef = 0;
+  _stampRef = 0;
+  _offset = 0;
+  _drift = 0;
+  _residual = 0;
+  _updates = 0;
+  _rejected = 0;
+  endWrite();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Sequence counter around writes to the fit. Readers retry while it is odd
+// or if it changed during their read.
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TimeSync::beginWrite() {
+  __atomic_store_n(&_version, _version + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void ADIS16490_TimeSync::endWrite() {
+  __atomic_store_n(&_version, _version + 1, __ATOMIC_RELEASE);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Adds a correlation point. The fit is re-anchored at every point, so its
+// offset is the host time of the newest edge and the measurement only
+// observes the offset directly.
+////////////////////////////////////////////////////////////////////////////
+// timeStamp - TIME_STAMP read in the same output period as dataCount
+// dataCount - DATA_CNT of that output period
+// edgeMicros - host time of the data ready edge that latched it (us)
+////////////////////////////////////////////////////////////////////////////
+void ADIS16490_TimeSync::update(uint16_t timeStamp, uint16_t dataCount, uint32_t edgeMicros) {
+  beginWrite();
+  if (_updates == 0) {
+    _deviceRef = timeStamp;
+    _base = edgeMicros - timeStamp;
+    _countRef = dataCount;
+    _stampRef = timeStamp;
+    _offset = 0;
+    _drift = 0;
+    _P[0][0] = TIMESYNC_JITTER * TIMESYNC_JITTER;
+    _P[0][1] = _P[1][0] = 0;
+    _P[1][1] = TIMESYNC_DRIFT0 * 1e-6f * TIMESYNC_DRIFT0 * 1e-6f;
+    _updates = 1;
+    endWrite();
+    return;
+  }
+
+  // Unwrap TIME_STAMP: pick the 65536 us multiple closest to the elapsed
+  // device time predicted by the DATA_CNT step
+  float predicted = (float)(int16_t)(dataCount - _countRef) * _period;
+  uint16_t raw = timeStamp - _stampRef;
+  int32_t wraps = (int32_t)((predicted - raw) * (1.0f / 65536) + (predicted >= raw ? 0.5f : -0.5f));
+  int32_t elapsed = (int32_t)raw + wraps * 65536;
+
+  // Move the anchor to the new point: offset += drift * elapsed and
+  // P = T P T' / lambda with T = [1 elapsed; 0 1]
+  float d = (float)elapsed;
+  _offset += _drift * d;
+  float p00 = _P[0][0] + d * (_P[0][1] + _P[1][0]) + d * d * _P[1][1];
+  float p01 = _P[0][1] + d * _P[1][1];
+  float inv = 1.0f / _lambda;
+  _P[0][0] = p00 * inv;
+  _P[0][1] = _P[1][0] = p01 * inv;
+  _P[1][1] *= inv;
+  _deviceRef += elapsed;
+
+  // Measurement: host minus device time at the edge
+  float measured = (float)(int32_t)(edgeMicros - _deviceRef - _base);
+  _residual = measured - _offset;
+  float s = _P[0][0] + TIMESYNC_JITTER * TIMESYNC_JITTER;
+  float k0 = _P[0][0] / s, k1 = _P[1][0] / s;
+  _offset += k0 * _residual;
+  _drift += k1 * _residual;
+  float q00 = _P[0][0], q01 = _P[0][1];
+  _P[0][0] -= k0 * q00;
+  _P[0][1] = _P[1][0] = _P[0][1] - k0 * q01;
+  _P[1][1] -= k1 * q01;
+
+  // Keep the float offset small
+  if (_offset > TIMESYNC_REBASE || _offset < -TIMESYNC_REBASE) {
+    int32_t whole = (int32_t)_offset;
+    _base += whole;
+    _offset -= whole;
+  }
+  _countRef = dataCount;
+  _stampRef = timeStamp;
+  _updates++;
+  endWrite();
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads TIME_STAMP and DATA_CNT in one chained sequence, then DATA_CNT
+// again to confirm no new output was latched in between. A late call can
+// read the next output whole; pairing it with edgeMicros would put the
+// point a full period off, so DATA_CNT must also match the edge's output.
+// Returns 1 when complete, 0 if an output arrived before or during the
+// read.
+////////////////////////////////////////////////////////////////////////////
+// imu - driver instance
+// edgeMicros - host time of the data ready edge (us)
+// dataCount - DATA_CNT of the output latched at edgeMicros
+////////////////////////////////////////////////////////////////////////////
+int ADIS16490_TimeSync::sync(ADIS16490 &imu, uint32_t edgeMicros, uint16_t dataCount) {
+  static const uint16_t regs[] = {DATA_CNT, TIME_STAMP, DATA_CNT};
+  int16_t data[3];
+  imu.regReadMany(regs, data, 3);
+  if (data[0] != data[2] || (uint16_t)data[0] != dataCount) {
+    _rejected++;
+    return(0);
+  }
+  update((uint16_t)data[1], (uint16_t)data[0], edgeMicros);
+  return(1);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Maps an output to host time through the fit. Outputs between
+// correlation points are placed by their DATA_CNT distance from the last
+// one.
+////////////////////////////////////////////////////////////////////////////
+// dataCount - DATA_CNT of the output
+////////////////////////////////////////////////////////////////////////////
+uint32_t ADIS16490_TimeSync::hostTime(uint16_t dataCount) const {
+  uint32_t version, origin;
+  float offset;
+  do {
+    version = __atomic_load_n(&_version, __ATOMIC_ACQUIRE);
+    float device = (float)(int16_t)(dataCount - _countRef) * _period;
+    origin = _deviceRef + _base;
+    offset = _offset + device * (1.0f + _drift);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((version & 1) || version != __atomic_load_n(&_version, __ATOMIC_RELAXED));
+  return origin + (int32_t)(offset + (offset >= 0 ? 0.5f : -0.5f));
+}
+
+bool ADIS16490_TimeSync::stamp(ADIS16490_Sample &sample) const {
+  if (_updates == 0)
+    return false;
+  sample.timestamp = hostTime(sample.dataCount);
+  return true;
+}
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_TimeSync.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Correlates the ADIS16490 TIME_STAMP register (device microseconds, 16 bits) with the host
+//  microsecond time base. Each correlation point pairs a TIME_STAMP/DATA_CNT reading with the host
+//  time of the data ready edge that latched it. An online least-squares fit with exponential
+//  forgetting tracks host time as device time plus an offset and a drift, so the timestamps of
+//  every sample, including those between correlation points, are mapped to the host time base from
+//  their DATA_CNT alone.
+//
+//  TIME_STAMP wraps every 65.5 ms; it is unwrapped against the DATA_CNT step, so correlation points
+//  may be up to half the DATA_CNT range (about 7 s at 4250 Hz) apart. Updating the fit and stamping
+//  a sample each cost a few floating point operations and no bus traffic; only sync() reads the
+//  sensor.
+//
+//  update() runs in interrupt context when attached to ADIS16490_Capture; stamp() and hostTime()
+//  can be called from loop() at any time and retry if an update lands while they read the fit.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS16490_TimeSync_h
+#define ADIS16490_TimeSync_h
+#include "ADIS16490.h"
+
+// TIME_STAMP scale (us/LSB)
+#define TIME_STAMP_LSB 1
+
+// Time correlation class definition
+class ADIS16490_TimeSync {
+
+public:
+  ADIS16490_TimeSync();
+
+  // Forgets the fit. The next update() starts a new one.
+  void reset();
+
+  // Output period in device time (us), (DEC_RATE + 1) / 4250 Hz
+  void setPeriod(float deviceMicros) { _period = deviceMicros; }
+
+  // Forgetting factor per correlation point (0 < lambda <= 1). Smaller
+  // values track drift changes faster but average less edge jitter.
+  void setForgetting(float lambda) { _lambda = lambda; }
+
+  // Adds a correlation point
+  // timeStamp - TIME_STAMP read in the same output period as dataCount
+  // dataCount - DATA_CNT of that output period
+  // edgeMicros - host time of the data ready edge that latched it
+  void update(uint16_t timeStamp, uint16_t dataCount, uint32_t edgeMicros);
+
+  // Reads TIME_STAMP and DATA_CNT in one chained sequence and adds them as
+  // a correlation point. Call right after the data ready edge at
+  // edgeMicros, before the next output period starts; dataCount is the
+  // DATA_CNT of the output that edge latched (e.g. from its burst).
+  // Returns 1 when complete, 0 if the two reads straddled an output or
+  // the read caught a later output than dataCount.
+  int sync(ADIS16490 &imu, uint32_t edgeMicros, uint16_t dataCount);
+
+  // Host time (us) of the data ready edge of output dataCount
+  uint32_t hostTime(uint16_t dataCount) const;
+
+  // Replaces sample.timestamp with hostTime(sample.dataCount). Returns
+  // false (leaving the sample alone) until the first update().
+  bool stamp(ADIS16490_Sample &sample) const;
+
+  // Device clock error against the host (ppm, positive runs slow)
+  float drift() const { return _drift * 1e6f; }
+
+  // Last innovation: measured minus predicted edge time (us)
+  float residual() const { return _residual; }
+
+  // Correlation points since reset()
+  uint32_t updates() const { return _updates; }
+
+  // sync() calls since reset() that added no point
+  uint32_t rejected() const { return _rejected; }
+
+private:
+  // Brackets writes to the fit for lock-free readers
+  void beginWrite();
+  void endWrite();
+
+  // Fit: host = device + _base + _offset + _drift * (device - _deviceRef)
+  volatile uint32_t _version; // Odd while update() is writing the fit
+  uint32_t _deviceRef;        // Unwrapped device time at the last point (us)
+  uint32_t _base;             // Integer part of host minus device time (us)
+  uint16_t _countRef;         // DATA_CNT at the last point
+  uint16_t _stampRef;         // Raw TIME_STAMP at the last point
+  float _offset;
+  float _drift;
+  float _P[2][2];
+  float _lambda;
+  float _period;
+  float _residual;
+  uint32_t _updates;
+  uint32_t _rejected;
+
+};
+
+#endif
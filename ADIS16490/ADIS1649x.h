@@ -0,0 +1,360 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS1649x.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Compile-time model descriptors for the ADIS1649x family. Each part is a traits struct (scale
+//  factors, register map, burst layout, sample rate, and SPI limits) and ADIS1649x<Model>
+//  specializes the ADIS16490 driver for it at compile time. Scaling is constexpr and the burst
+//  decoder is unrolled for the model's layout, so there is no runtime dispatch.
+//
+//  Supporting another variant means adding a traits struct, usually derived from the closest
+//  existing one with only the differing constants overridden.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ADIS1649x_h
+#define ADIS1649x_h
+#include "ADIS16490.h"
+
+// Register map shared by the family. The driver addresses registers
+// through the ADIS16490 macros; only prodId and burstCmd are read from a
+// model's Registers, and ADIS1649x<Model> rejects a map that moves any of
+// the others.
+struct ADIS1649x_Registers {
+  static constexpr uint16_t pageId     = PAGE_ID;
+  static constexpr uint16_t dataCnt    = DATA_CNT;
+  static constexpr uint16_t sysEFlag   = SYS_E_FLAG;
+  static constexpr uint16_t diagSts    = DIAG_STS;
+  static constexpr uint16_t tempOut    = TEMP_OUT;
+  static constexpr uint16_t xGyroLow   = X_GYRO_LOW;
+  static constexpr uint16_t xGyroOut   = X_GYRO_OUT;
+  static constexpr uint16_t xAcclLow   = X_ACCL_LOW;
+  static constexpr uint16_t xAcclOut   = X_ACCL_OUT;
+  static constexpr uint16_t timeStamp  = TIME_STAMP;
+  static constexpr uint16_t prodId     = PROD_ID;
+  static constexpr uint16_t globCmd    = GLOB_CMD;
+  static constexpr uint16_t fnctioCtrl = FNCTIO_CTRL;
+  static constexpr uint16_t decRate    = DEC_RATE;
+  static constexpr uint16_t burstCmd   = BURST_READ;
+};
+
+// ADIS16490 burst: DIAG_STS, X/Y/Z_GYRO_OUT, X/Y/Z_ACCL_OUT, TEMP_OUT,
+// DATA_CNT, CHECKSUM. The checksum is the byte sum of the first nine words.
+struct ADIS1649x_BurstSum16 {
+  static constexpr uint8_t words = 10;
+  static constexpr uint8_t status = 0;
+  static constexpr uint8_t gyro = 1;   // First of X/Y/Z
+  static constexpr uint8_t accel = 4;  // First of X/Y/Z
+  static constexpr uint8_t stride = 1; // Words per axis
+  static constexpr uint8_t temp = 7;
+  static constexpr uint8_t dataCount = 8;
+
+  static bool verify(const uint16_t *w) {
+    uint16_t sum = 0;
+    for (int i = 0; i < 9; i++)
+      sum += (w[i] >> 8) + (w[i] & 0xFF);
+    return sum == w[9];
+  }
+};
+
+// ADIS16495/ADIS16497 burst: BURST_ID (0xA5A5), SYS_E_FLAG, TEMP_OUT,
+// X/Y/Z_GYRO_LOW/OUT, X/Y/Z_ACCL_LOW/OUT, DATA_CNT, CRC_LWR, CRC_UPR. The
+// CRC-32 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF, inverted
+// result) covers SYS_E_FLAG through DATA_CNT, low byte of each word first.
+struct ADIS1649x_BurstCrc32 {
+  static constexpr uint8_t words = 18;
+  static constexpr uint8_t status = 1;
+  static constexpr uint8_t gyro = 4;   // X_GYRO_OUT; the LOW word precedes it
+  static constexpr uint8_t accel = 10; // X_ACCL_OUT; the LOW word precedes it
+  static constexpr uint8_t stride = 2;
+  static constexpr uint8_t temp = 2;
+  static constexpr uint8_t dataCount = 15;
+
+  static bool verify(const uint16_t *w) {
+    if (w[0] != 0xA5A5)
+      return false;
+    uint32_t crc = 0xFFFFFFFF;
+    for (int i = 1; i < 16; i++) {
+      for (int b = 0; b < 2; b++) {
+        crc ^= (uint32_t)((b ? w[i] >> 8 : w[i]) & 0xFF) << 24;
+        for (int bit = 0; bit < 8; bit++)
+          crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+      }
+    }
+    return ~crc == (((uint32_t)w[17] << 16) | w[16]);
+  }
+};
+
+// True if Regs addresses every register where the ADIS16490 macros do
+template <class Regs>
+struct ADIS1649x_SameMap {
+  static constexpr bool value =
+    Regs::pageId == PAGE_ID && Regs::dataCnt == DATA_CNT && Regs::sysEFlag == SYS_E_FLAG &&
+    Regs::diagSts == DIAG_STS && Regs::tempOut == TEMP_OUT && Regs::xGyroLow == X_GYRO_LOW &&
+    Regs::xGyroOut == X_GYRO_OUT && Regs::xAcclLow == X_ACCL_LOW && Regs::xAcclOut == X_ACCL_OUT &&
+    Regs::timeStamp == TIME_STAMP && Regs::globCmd == GLOB_CMD && Regs::fnctioCtrl == FNCTIO_CTRL &&
+    Regs::decRate == DEC_RATE;
+};
+
+template <class A, class B>
+struct ADIS1649x_Same { static constexpr bool value = false; };
+
+template <class A>
+struct ADIS1649x_Same<A, A> { static constexpr bool value = true; };
+
+// What a model shares with the ADIS16490. Code holding an ADIS16490 &
+// decodes the ADIS16490 burst layout (base burstRead(), burstStart(), and
+// burstFinish()) and scales with the ADIS16490 constants, so the capture
+// and calibration classes only accept an ADIS1649x<Model> for which these
+// hold.
+template <class Model>
+struct ADIS1649x_Base {
+  static constexpr bool burst = ADIS1649x_Same<typename Model::Burst, ADIS1649x_BurstSum16>::value;
+  static constexpr bool scale =
+    Model::gyroLsb == GYRO_LSB && Model::accelLsb == ACCL_LSB && Model::tempLsb == TEMP_LSB &&
+    Model::tempOffset == TEMP_OFFSET && Model::deltaAngleLsb == DELTANG_LSB &&
+    Model::deltaVelocityLsb == DELTVEL_LSB;
+};
+
+// ADIS16490: +/-100 deg/sec, +/-8 g
+struct ADIS16490_Model {
+  typedef ADIS1649x_Registers Registers;
+  typedef ADIS1649x_BurstSum16 Burst;
+  static constexpr uint16_t prodId = PROD_ID_VALUE;
+  static constexpr float gyroLsb = GYRO_LSB;       // degrees/sec/LSB
+  static constexpr float accelLsb = ACCL_LSB;      // mg/LSB
+  static constexpr float tempLsb = TEMP_LSB;       // degrees C/LSB
+  static constexpr float tempOffset = TEMP_OFFSET; // degrees C at TEMP_OUT = 0
+  static constexpr float deltaAngleLsb = DELTANG_LSB;    // degrees/LSB
+  static constexpr float deltaVelocityLsb = DELTVEL_LSB; // mm/sec/LSB
+  static constexpr uint32_t sampleRate = 4250;     // Hz with DEC_RATE = 0
+  static constexpr uint32_t maxClock = 15000000;   // SCLK limit (Hz)
+  static constexpr uint32_t stallNs = STALL_NS;    // Minimum CS high time
+};
+
+// ADIS16495: +/-8 g, 32-bit burst with CRC-32. Gyro range set by the
+// -1/-2/-3 variants below.
+struct ADIS16495_Model : ADIS16490_Model {
+  typedef ADIS1649x_BurstCrc32 Burst;
+  static constexpr uint16_t prodId = 0x406F;
+  static constexpr float accelLsb = 0.25f;
+  static constexpr float tempLsb = 0.0125f;
+  static constexpr float deltaVelocityLsb = 3.052f; // +/-100 m/sec
+};
+
+struct ADIS16495_1_Model : ADIS16495_Model { // +/-125 deg/sec
+  static constexpr float gyroLsb = 0.00625f;
+  static constexpr float deltaAngleLsb = 0.011f;
+};
+
+struct ADIS16495_2_Model : ADIS16495_Model { // +/-450 deg/sec
+  static constexpr float gyroLsb = 0.025f;
+  static constexpr float deltaAngleLsb = 0.022f;
+};
+
+struct ADIS16495_3_Model : ADIS16495_Model { // +/-2000 deg/sec
+  static constexpr float gyroLsb = 0.1f;
+  static constexpr float deltaAngleLsb = 0.066f;
+};
+
+// ADIS16497: ADIS16495 with a +/-40 g accelerometer
+struct ADIS16497_Model : ADIS16495_Model {
+  static constexpr uint16_t prodId = 0x4071;
+  static constexpr float accelLsb = 1.25f;
+  static constexpr float deltaVelocityLsb = 12.207f; // +/-400 m/sec
+};
+
+struct ADIS16497_1_Model : ADIS16497_Model { // +/-125 deg/sec
+  static constexpr float gyroLsb = 0.00625f;
+  static constexpr float deltaAngleLsb = 0.011f;
+};
+
+struct ADIS16497_2_Model : ADIS16497_Model { // +/-450 deg/sec
+  static constexpr float gyroLsb = 0.025f;
+  static constexpr float deltaAngleLsb = 0.022f;
+};
+
+struct ADIS16497_3_Model : ADIS16497_Model { // +/-2000 deg/sec
+  static constexpr float gyroLsb = 0.1f;
+  static constexpr float deltaAngleLsb = 0.066f;
+};
+
+// Driver specialized for one model. Register access, paging, and stall
+// timing are inherited; scaling and burstRead(ADIS16490_Sample &) use the
+// model's constants. The split-phase burst and the ADIS16490_Burst read
+// decode the ADIS16490 layout and fail to compile for other models. The
+// scaling hides the base methods, so a model with other scale factors must
+// be scaled through ADIS1649x<Model>, not an ADIS16490 &.
+template <class Model>
+class ADIS1649x : public ADIS16490 {
+
+public:
+  typedef typename Model::Registers Registers;
+  typedef typename Model::Burst Burst;
+
+  static_assert(ADIS1649x_SameMap<Registers>::value,
+                "ADIS1649x: the driver uses the ADIS16490 register addresses");
+
+#ifdef ARDUINO
+  ADIS1649x(int CS, int DR, int RST) : ADIS16490(CS, DR, RST) { applyModel(); }
+#endif
+  ADIS1649x(ADIS16490_Bus &bus) : ADIS16490(bus) { applyModel(); }
+
+  // Searches for the fastest error-free SCLK up to the model's limit. Each
+  // step must pass checkProduct() and the model's burst check.
+  int autoTuneClocks(uint16_t trials = 100) { return tuneClocks(Model::maxClock, trials, tuneReg, tuneBurst); }
+
+  // Returns 1 if PROD_ID matches the model
+  int checkProduct() { return (uint16_t)regRead(Registers::prodId) == Model::prodId ? 1 : 0; }
+
+  // Output data rate for a DEC_RATE setting (Hz)
+  static constexpr float outputRate(uint16_t decRate) { return (float)Model::sampleRate / (decRate + 1); }
+
+  // ADIS16490 burst layout only
+  int burstRead(ADIS16490_Burst &data) {
+    static_assert(ADIS1649x_Base<Model>::burst,
+                  "ADIS1649x: ADIS16490_Burst holds the ADIS16490 layout");
+    return ADIS16490::burstRead(data);
+  }
+  int burstStart(void (*done)(void *context), void *context) {
+    static_assert(ADIS1649x_Base<Model>::burst,
+                  "ADIS1649x: the split-phase burst decodes the ADIS16490 layout");
+    return ADIS16490::burstStart(done, context);
+  }
+  int burstFinish(ADIS16490_Burst &data) {
+    static_assert(ADIS1649x_Base<Model>::burst,
+                  "ADIS1649x: the split-phase burst decodes the ADIS16490 layout");
+    return ADIS16490::burstFinish(data);
+  }
+  int burstFinish(ADIS16490_Sample &sample) {
+    static_assert(ADIS1649x_Base<Model>::burst,
+                  "ADIS1649x: the split-phase burst decodes the ADIS16490 layout");
+    return ADIS16490::burstFinish(sample);
+  }
+
+  // Reads one burst frame in the model's layout into a sample record. The
+  // OUT word of each axis is kept. Returns 1 if the checksum/CRC matches.
+  int burstRead(ADIS16490_Sample &sample) {
+    uint8_t tx[2 + 2 * Burst::words] = {0};
+    uint8_t rx[2 + 2 * Burst::words];
+    uint16_t w[Burst::words];
+    tx[0] = (Registers::burstCmd >> 8) & 0xFF;
+    tx[1] = Registers::burstCmd & 0xFF;
+
+    _burstStart = _bus->microsNow();
+    burstPage();
+    beginFrame(true); // Wait out the stall time and set CS low to enable device
+    _bus->transfer(tx, rx, sizeof(rx));
+    endFrame(); // Set CS high to disable device
+
+    for (int i = 0; i < Burst::words; i++)
+      w[i] = (rx[2 + 2 * i] << 8) | rx[3 + 2 * i];
+    sample.timestamp = _burstStart;
+    sample.status = w[Burst::status];
+    for (int i = 0; i < 3; i++) {
+      sample.gyro[i] = w[Burst::gyro + i * Burst::stride];
+      sample.accel[i] = w[Burst::accel + i * Burst::stride];
+    }
+    sample.temp = w[Burst::temp];
+    sample.dataCount = w[Burst::dataCount];
+    sample.reserved = 0;
+
+    _lastTransfer.bytes = (_lastTransfer.frames - 1) * 2 + sizeof(rx);
+    _lastTransfer.micros = _bus->microsNow() - _burstStart;
+    return Burst::verify(w) ? 1 : 0;
+  }
+
+  // Single-value scaling, evaluated at compile time for constant input
+  static constexpr float gyroScale(int16_t sensorData) { return sensorData * Model::gyroLsb; }
+  static constexpr float accelScale(int16_t sensorData) { return sensorData * Model::accelLsb; }
+  static constexpr float gyroScale32(int32_t sensorData) { return sensorData * (Model::gyroLsb / 65536.0f); }
+  static constexpr float accelScale32(int32_t sensorData) { return sensorData * (Model::accelLsb / 65536.0f); }
+  static constexpr float tempScale(int16_t sensorData) { return sensorData * Model::tempLsb + Model::tempOffset; }
+  static constexpr float deltaAngleScale(int16_t sensorData) { return sensorData * Model::deltaAngleLsb; }
+  static constexpr float deltaVelocityScale(int16_t sensorData) { return sensorData * Model::deltaVelocityLsb; }
+
+  // Array scaling
+  void gyroScale(const int16_t *sensorData, float *scaled, size_t count) {
+    scaleArray(sensorData, scaled, count, Model::gyroLsb, 0.0f);
+  }
+  void accelScale(const int16_t *sensorData, float *scaled, size_t count) {
+    scaleArray(sensorData, scaled, count, Model::accelLsb, 0.0f);
+  }
+  void tempScale(const int16_t *sensorData, float *scaled, size_t count) {
+    scaleArray(sensorData, scaled, count, Model::tempLsb, Model::tempOffset);
+  }
+  void deltaAngleScale(const int16_t *sensorData, float *scaled, size_t count) {
+    scaleArray(sensorData, scaled, count, Model::deltaAngleLsb, 0.0f);
+  }
+  void deltaVelocityScale(const int16_t *sensorData, float *scaled, size_t count) {
+    scaleArray(sensorData, scaled, count, Model::deltaVelocityLsb, 0.0f);
+  }
+
+  // Block scaling of sample records (AoS)
+  void scaleSamples(const ADIS16490_Sample *samples, ADIS16490_Scaled *scaled, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      scaled[i].timestamp = samples[i].timestamp;
+      for (int axis = 0; axis < 3; axis++) {
+        scaled[i].gyro[axis] = gyroScale(samples[i].gyro[axis]);
+        scaled[i].accel[axis] = accelScale(samples[i].accel[axis]);
+      }
+      scaled[i].temp = tempScale(samples[i].temp);
+    }
+  }
+
+  // Block scaling of sample records (SoA); null channels are skipped
+  void scaleSamples(const ADIS16490_Sample *samples, const ADIS16490_ScaledBlock &scaled, size_t count) {
+    for (int axis = 0; axis < 3; axis++) {
+      if (scaled.gyro[axis])
+        for (size_t i = 0; i < count; i++)
+          scaled.gyro[axis][i] = gyroScale(samples[i].gyro[axis]);
+      if (scaled.accel[axis])
+        for (size_t i = 0; i < count; i++)
+          scaled.accel[axis][i] = accelScale(samples[i].accel[axis]);
+    }
+    if (scaled.temp)
+      for (size_t i = 0; i < count; i++)
+        scaled.temp[i] = tempScale(samples[i].temp);
+  }
+
+private:
+  // Trial reads for autoTuneClocks(). A burst of all zeros fails, as a
+  // zero byte sum would otherwise pass.
+  static bool tuneReg(ADIS16490 &imu) { return static_cast<ADIS1649x &>(imu).checkProduct() == 1; }
+  static bool tuneBurst(ADIS16490 &imu) {
+    ADIS16490_Sample sample;
+    bool good = static_cast<ADIS1649x &>(imu).burstRead(sample);
+    uint16_t any = sample.status | sample.dataCount | sample.temp;
+    for (int i = 0; i < 3; i++)
+      any |= sample.gyro[i] | sample.accel[i];
+    return good && (any != 0);
+  }
+
+  // Applies the model's stall time
+  void applyModel() {
+    ADIS16490_StallPolicy policy = {Model::stallNs, true};
+    setStallPolicy(policy);
+  }
+
+};
+
+#endif
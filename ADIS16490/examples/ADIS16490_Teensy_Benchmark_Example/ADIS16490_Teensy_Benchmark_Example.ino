@@ -0,0 +1,452 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  ADIS16490_Teensy_Benchmark_Example.ino
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  This Arduino project measures the cost of the ADIS16490 library read and write functions. Each
+//  function is first timed against the real sensor using micros(), then repeated against the
+//  ADIS16490_Sim register-map simulator to report SPI frames, bytes, page switches, and stall
+//  violations per call. Results are printed to a serial debug terminal via the onboard USB
+//  serial port.
+//
+//  This project has been tested on a PJRC 32-Bit Teensy 3.2 Development Board,
+//  but should be compatible with any other embedded platform with some modification.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//  Pinout for a Teensy 3.2 Development Board
+//  RST = D6
+//  SCK = D13/SCK
+//  CS = D10/CS
+//  DOUT(MISO) = D12/MISO
+//  DIN(MOSI) = D11/MOSI
+//  DR = D2
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include <ADIS16490.h>
+#include <ADIS16490_Sim.h>
+#include <ADIS16490_Stream.h>
+#include <ADIS16490_Compress.h>
+#include <ADIS16490_Strapdown.h>
+#include <ADIS16490_Ahrs.h>
+#include <ADIS16490_FirBank.h>
+#include <ADIS16490_Filter.h>
+#include <SPI.h>
+#include <stdio.h>
+
+// Number of calls averaged per measurement
+#define ITERATIONS 1000
+
+// Call ADIS16490 Class
+ADIS16490 IMU(10,2,6); // Chip Select, Data Ready, Reset Pin Assignments
+
+// Number of samples per scaling block
+#define SCALE_BLOCK 256
+
+// Serial link rate used to project streaming throughput (8N1 UART)
+#define LINK_BAUD 921600
+
+// Simulated sensor and a driver instance bound to it
+ADIS16490_Sim SIM;
+ADIS16490 SIMIMU(SIM);
+
+// Prints one result line
+void printResult(const char *name, float usPerCall, const ADIS16490_SimStats &stats, float simUs)
+{
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(usPerCall);
+    Serial.print(" us/call (HW), ");
+    Serial.print((float)stats.frames / ITERATIONS);
+    Serial.print(" frames, ");
+    Serial.print((float)stats.bytes / ITERATIONS);
+    Serial.print(" bytes, ");
+    Serial.print((float)stats.pageSwitches / ITERATIONS);
+    Serial.print(" page switches, ");
+    Serial.print(stats.stallViolations);
+    Serial.print(" stall violations, ");
+    Serial.print(simUs);
+    Serial.println(" us/call (SIM)");
+}
+
+void setup()
+{
+    Serial.begin(115200); // Initialize serial output via USB
+    while (!Serial) {}
+    IMU.configSPI(); // Configure SPI communication
+    delay(1000); // Give the part time to start up
+
+    uint32_t start;
+    float hwUs, simUs;
+    uint64_t simStart;
+
+    // regRead on page 0
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) IMU.regRead(PROD_ID);
+    hwUs = (float)(micros() - start) / ITERATIONS;
+    SIM.resetStats();
+    simStart = SIM.nanos();
+    for (int i = 0; i < ITERATIONS; i++) SIMIMU.regRead(PROD_ID);
+    simUs = (float)(SIM.nanos() - simStart) / 1000 / ITERATIONS;
+    printResult("regRead(PROD_ID)", hwUs, SIM.stats(), simUs);
+
+    // regRead alternating between pages 0 and 3
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) IMU.regRead((i & 1) ? DEC_RATE : PROD_ID);
+    hwUs = (float)(micros() - start) / ITERATIONS;
+    SIM.resetStats();
+    simStart = SIM.nanos();
+    for (int i = 0; i < ITERATIONS; i++) SIMIMU.regRead((i & 1) ? DEC_RATE : PROD_ID);
+    simUs = (float)(SIM.nanos() - simStart) / 1000 / ITERATIONS;
+    printResult("regRead(page 0/3)", hwUs, SIM.stats(), simUs);
+
+    // regWrite to a scratch register
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) IMU.regWrite(USER_SCR_1, i);
+    hwUs = (float)(micros() - start) / ITERATIONS;
+    SIM.resetStats();
+    simStart = SIM.nanos();
+    for (int i = 0; i < ITERATIONS; i++) SIMIMU.regWrite(USER_SCR_1, i);
+    simUs = (float)(SIM.nanos() - simStart) / 1000 / ITERATIONS;
+    printResult("regWrite(USER_SCR_1)", hwUs, SIM.stats(), simUs);
+
+    // sensorRead
+    ADIS16490_Sample sample;
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) IMU.sensorRead(sample);
+    hwUs = (float)(micros() - start) / ITERATIONS;
+    SIM.resetStats();
+    simStart = SIM.nanos();
+    for (int i = 0; i < ITERATIONS; i++) SIMIMU.sensorRead(sample);
+    simUs = (float)(SIM.nanos() - simStart) / 1000 / ITERATIONS;
+    printResult("sensorRead()", hwUs, SIM.stats(), simUs);
+
+    // burstRead
+    ADIS16490_Burst burst;
+    int good = 0;
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) good += IMU.burstRead(burst);
+    hwUs = (float)(micros() - start) / ITERATIONS;
+    SIM.resetStats();
+    simStart = SIM.nanos();
+    for (int i = 0; i < ITERATIONS; i++) SIMIMU.burstRead(burst);
+    simUs = (float)(SIM.nanos() - simStart) / 1000 / ITERATIONS;
+    printResult("burstRead()", hwUs, SIM.stats(), simUs);
+    Serial.print("burstRead() checksum pass: ");
+    Serial.print(good);
+    Serial.print("/");
+    Serial.println(ITERATIONS);
+
+    // highResRead
+    ADIS16490_HighRes highRes;
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) IMU.highResRead(highRes);
+    hwUs = (float)(micros() - start) / ITERATIONS;
+    SIM.resetStats();
+    simStart = SIM.nanos();
+    for (int i = 0; i < ITERATIONS; i++) SIMIMU.highResRead(highRes);
+    simUs = (float)(SIM.nanos() - simStart) / 1000 / ITERATIONS;
+    printResult("highResRead()", hwUs, SIM.stats(), simUs);
+
+    // deltaRead
+    ADIS16490_Delta delta;
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) IMU.deltaRead(delta);
+    hwUs = (float)(micros() - start) / ITERATIONS;
+    SIM.resetStats();
+    simStart = SIM.nanos();
+    for (int i = 0; i < ITERATIONS; i++) SIMIMU.deltaRead(delta);
+    simUs = (float)(SIM.nanos() - simStart) / 1000 / ITERATIONS;
+    printResult("deltaRead()", hwUs, SIM.stats(), simUs);
+
+    // Dump of the page 2, 3, and 4 configuration: regRead() vs regReadMany()
+    static const uint16_t configRegs[] = {
+        X_GYRO_SCALE, Y_GYRO_SCALE, Z_GYRO_SCALE, X_ACCL_SCALE, Y_ACCL_SCALE, Z_ACCL_SCALE,
+        XG_BIAS_LOW, XG_BIAS_HIGH, YG_BIAS_LOW, YG_BIAS_HIGH, ZG_BIAS_LOW, ZG_BIAS_HIGH,
+        XA_BIAS_LOW, XA_BIAS_HIGH, YA_BIAS_LOW, YA_BIAS_HIGH, ZA_BIAS_LOW, ZA_BIAS_HIGH,
+        USER_SCR_1, USER_SCR_2, USER_SCR_3, USER_SCR_4, FLSHCNT_LOW, FLSHCNT_HIGH,
+        GLOB_CMD, FNCTIO_CTRL, GPIO_CTRL, CONFIG, DEC_RATE, NULL_CNFG, SYNC_SCALE,
+        FILTR_BNK_0, FILTR_BNK_1, FIRM_REV, FIRM_DM, FIRM_Y, BOOT_REV,
+        CAL_SIGTR_LWR, CAL_SIGTR_UPR, CAL_DRVTN_LWR, CAL_DRVTN_UPR,
+        CODE_SIGTR_LWR, CODE_SIGTR_UPR, CODE_DRVTN_LWR, CODE_DRVTN_UPR, SERIAL_NUM };
+    const size_t configCount = sizeof(configRegs) / sizeof(configRegs[0]);
+    int16_t configData[configCount];
+    SIM.resetStats();
+    for (size_t i = 0; i < configCount; i++) SIMIMU.regRead(configRegs[i]);
+    Serial.print("Config dump (");
+    Serial.print(configCount);
+    Serial.print(" regs): regRead() ");
+    Serial.print(SIM.stats().frames);
+    Serial.print(" frames, ");
+    SIM.resetStats();
+    SIMIMU.regReadMany(configRegs, configData, configCount);
+    Serial.print("regReadMany() ");
+    Serial.print(SIM.stats().frames);
+    Serial.print(" frames, ");
+    IMU.regReadMany(configRegs, configData, configCount);
+    Serial.print(IMU.lastTransfer().micros);
+    Serial.println(" us (HW)");
+
+    // regBatch over a configuration sequence alternating pages 0, 2, and 3
+    ADIS16490_RegOp ops[] = {
+        {PROD_ID, 0, REG_OP_READ},
+        {DEC_RATE, 0, REG_OP_READ},
+        {USER_SCR_1, 0, REG_OP_READ},
+        {DATA_CNT, 0, REG_OP_READ},
+        {FNCTIO_CTRL, 0, REG_OP_READ},
+        {USER_SCR_2, 0, REG_OP_READ},
+    };
+    ADIS16490_BatchStats batch;
+    start = micros();
+    IMU.regBatch(ops, sizeof(ops) / sizeof(ops[0]), &batch);
+    hwUs = (float)(micros() - start);
+    Serial.print("regBatch(6 reads): ");
+    Serial.print(hwUs);
+    Serial.print(" us (HW), ");
+    Serial.print(batch.naiveFrames);
+    Serial.print(" frames unbatched, ");
+    Serial.print(batch.frames);
+    Serial.print(" frames batched, ");
+    Serial.print(batch.pageSwitches);
+    Serial.println(" page switches");
+
+    // FIR bank D upload on the real sensor: a 120-tap moving average into an
+    // uncached bank, the same table again, and with three taps changed. The
+    // original coefficients are restored afterwards; no axis is assigned to
+    // the bank, so filtering is unaffected.
+    static ADIS16490_FirBank fir(IMU);
+    static int16_t original[FIR_TAPS], table[FIR_TAPS];
+    fir.refresh(FIR_BANK_D);
+    memcpy(original, fir.cached(FIR_BANK_D), sizeof(original));
+    fir.invalidate();
+    for (int i = 0; i < FIR_TAPS; i++) table[i] = 273; // 32768 / 120
+    const char *firNames[] = {"FIR upload, uncached: ", "FIR upload, unchanged: ", "FIR upload, 3 taps changed: "};
+    for (int pass = 0; pass < 3; pass++) {
+        if (pass == 2) {
+            table[0] = 272;
+            table[60] = 274;
+            table[119] = -1;
+        }
+        int ok = fir.upload(FIR_BANK_D, table);
+        Serial.print(firNames[pass]);
+        Serial.print(fir.stats().micros);
+        Serial.print(" us (HW), ");
+        Serial.print(fir.stats().frames);
+        Serial.print(" frames (");
+        Serial.print(fir.stats().naiveFrames);
+        Serial.print(" with regWrite/regRead), ");
+        Serial.println(ok ? "verified" : "VERIFY FAILED");
+    }
+    fir.upload(FIR_BANK_D, original);
+
+    // Stall policy sweep on the simulator: samples/s for sensorRead() and
+    // regReadMany() with fixed vs measured stall at 1, 2, and 15 MHz SCLK
+    static const uint32_t clocks[] = {1000000, 2000000, 15000000};
+    for (int c = 0; c < 3; c++) {
+        SIM.configure(clocks[c]);
+        for (int measured = 0; measured < 2; measured++) {
+            ADIS16490_StallPolicy policy = {STALL_NS, measured == 1};
+            SIMIMU.setStallPolicy(policy);
+            simStart = SIM.nanos();
+            for (int i = 0; i < ITERATIONS; i++) SIMIMU.sensorRead(sample);
+            float sensorRate = 1e9f * ITERATIONS / (float)(SIM.nanos() - simStart);
+            simStart = SIM.nanos();
+            for (int i = 0; i < ITERATIONS / 10; i++) SIMIMU.regReadMany(configRegs, configData, configCount);
+            float regRate = 1e9f * (ITERATIONS / 10) * configCount / (float)(SIM.nanos() - simStart);
+            Serial.print(clocks[c] / 1000000);
+            Serial.print(" MHz, ");
+            Serial.print(measured ? "measured" : "fixed");
+            Serial.print(" stall: sensorRead() ");
+            Serial.print(sensorRate);
+            Serial.print(" samples/s, regReadMany() ");
+            Serial.print(regRate);
+            Serial.println(" regs/s (SIM)");
+        }
+    }
+
+    // Scaling: per-call functions vs the batch AoS and SoA scalers on a
+    // block of simulated samples, timed with the cycle counter
+    static ADIS16490_Sample rawBlock[SCALE_BLOCK];
+    static ADIS16490_Scaled scaledBlock[SCALE_BLOCK];
+    static float channels[7][SCALE_BLOCK];
+    ADIS16490_ScaledBlock soa = {{channels[0], channels[1], channels[2]},
+                                 {channels[3], channels[4], channels[5]}, channels[6]};
+    for (int i = 0; i < SCALE_BLOCK; i++) SIMIMU.sensorRead(rawBlock[i]);
+    ADIS16490_Bus *bus = IMU.bus();
+    float nsPerCycle = 1000.0f / bus->cyclesPerMicro();
+    uint32_t cycles = bus->cycleCount();
+    for (int i = 0; i < SCALE_BLOCK; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            channels[axis][i] = IMU.gyroScale(rawBlock[i].gyro[axis]);
+            channels[axis + 3][i] = IMU.accelScale(rawBlock[i].accel[axis]);
+        }
+        channels[6][i] = IMU.tempScale(rawBlock[i].temp);
+    }
+    float perCallNs = (bus->cycleCount() - cycles) * nsPerCycle / SCALE_BLOCK;
+    cycles = bus->cycleCount();
+    IMU.scaleSamples(rawBlock, scaledBlock, SCALE_BLOCK);
+    float aosNs = (bus->cycleCount() - cycles) * nsPerCycle / SCALE_BLOCK;
+    cycles = bus->cycleCount();
+    IMU.scaleSamples(rawBlock, soa, SCALE_BLOCK);
+    float soaNs = (bus->cycleCount() - cycles) * nsPerCycle / SCALE_BLOCK;
+    Serial.print("Scaling (7 channels): per-call ");
+    Serial.print(perCallNs);
+    Serial.print(" ns/sample, scaleSamples() AoS ");
+    Serial.print(aosNs);
+    Serial.print(" ns/sample, SoA ");
+    Serial.print(soaNs);
+    Serial.println(" ns/sample");
+
+    // Streaming: binary frames vs CSV text for the same block of samples.
+    // Reports encode cost and the sample rate the link can sustain.
+    static uint8_t streamBuffer[SCALE_BLOCK * STREAM_FRAME_BYTES];
+    ADIS16490_StreamEncoder encoder;
+    cycles = bus->cycleCount();
+    size_t binaryBytes = encoder.encode(rawBlock, SCALE_BLOCK, streamBuffer, sizeof(streamBuffer));
+    float binaryNs = (bus->cycleCount() - cycles) * nsPerCycle / SCALE_BLOCK;
+    char line[96];
+    size_t csvBytes = 0;
+    cycles = bus->cycleCount();
+    for (int i = 0; i < SCALE_BLOCK; i++) {
+        const ADIS16490_Sample &s = rawBlock[i];
+        csvBytes += snprintf(line, sizeof(line), "%d,%d,%d,%d,%d,%d,%d\r\n", s.gyro[0], s.gyro[1],
+                             s.gyro[2], s.accel[0], s.accel[1], s.accel[2], s.temp);
+    }
+    float csvNs = (bus->cycleCount() - cycles) * nsPerCycle / SCALE_BLOCK;
+    float linkBytes = LINK_BAUD / 10.0f;
+    Serial.print("Streaming: binary ");
+    Serial.print((float)binaryBytes / SCALE_BLOCK);
+    Serial.print(" bytes/sample, ");
+    Serial.print(binaryNs);
+    Serial.print(" ns/sample, ");
+    Serial.print(linkBytes * SCALE_BLOCK / binaryBytes);
+    Serial.print(" samples/s; CSV ");
+    Serial.print((float)csvBytes / SCALE_BLOCK);
+    Serial.print(" bytes/sample, ");
+    Serial.print(csvNs);
+    Serial.print(" ns/sample, ");
+    Serial.print(linkBytes * SCALE_BLOCK / csvBytes);
+    Serial.print(" samples/s at ");
+    Serial.print(LINK_BAUD);
+    Serial.println(" baud");
+
+    // Compression of the same block. The simulator returns constant data, so
+    // this is the best case; see extras/ADIS16490_Compression for noisy and
+    // recorded datasets.
+    static uint8_t packet[COMPRESS_MAX_PACKET];
+    ADIS16490_Compressor compressor;
+    size_t compressedBytes = 0;
+    cycles = bus->cycleCount();
+    for (int i = 0; i < SCALE_BLOCK; i++) compressedBytes += compressor.add(rawBlock[i], packet);
+    compressedBytes += compressor.flush(packet);
+    float compressNs = (bus->cycleCount() - cycles) * nsPerCycle / SCALE_BLOCK;
+    Serial.print("Compressed: ");
+    Serial.print((float)compressedBytes / SCALE_BLOCK);
+    Serial.print(" bytes/sample, ratio ");
+    Serial.print((float)binaryBytes / compressedBytes);
+    Serial.print(":1, ");
+    Serial.print(compressNs);
+    Serial.print(" ns/sample, ");
+    Serial.print(linkBytes * SCALE_BLOCK / compressedBytes);
+    Serial.print(" samples/s at ");
+    Serial.print(LINK_BAUD);
+    Serial.println(" baud");
+
+    // Strapdown update cost per output period
+    ADIS16490_Strapdown strapdown;
+    delta.angle[0] = 12345;
+    delta.velocity[2] = -1000000;
+    cycles = bus->cycleCount();
+    for (int i = 0; i < ITERATIONS; i++) strapdown.update(delta, 1.0f / 4250);
+    cycles = bus->cycleCount() - cycles;
+    Serial.print("Strapdown update: ");
+    Serial.print((float)cycles / ITERATIONS);
+    Serial.print(" cycles, ");
+    Serial.print(cycles * nsPerCycle / ITERATIONS);
+    Serial.println(" ns");
+
+    // Attitude filter cost per sample. The Kalman accel update runs every
+    // 10th sample by default; the last row applies it on every sample,
+    // which bounds any single update.
+    ADIS16490_Sample level = {};
+    level.accel[2] = -2000;
+    ADIS16490_Ahrs mahony(AHRS_MAHONY), kalman(AHRS_KALMAN), kalmanEvery(AHRS_KALMAN);
+    kalmanEvery.setNoise(0.0003f, 0.0001f, 0.05f, 1);
+    ADIS16490_Ahrs *filters[] = {&mahony, &kalman, &kalmanEvery};
+    const char *filterNames[] = {"AHRS Mahony: ", "AHRS Kalman: ", "AHRS Kalman, accel every sample: "};
+    for (int f = 0; f < 3; f++) {
+        cycles = bus->cycleCount();
+        for (int i = 0; i < ITERATIONS; i++) filters[f]->update(level, 1.0f / 4250);
+        cycles = bus->cycleCount() - cycles;
+        Serial.print(filterNames[f]);
+        Serial.print((float)cycles / ITERATIONS);
+        Serial.print(" cycles, ");
+        Serial.print(cycles * nsPerCycle / ITERATIONS);
+        Serial.print(" ns, ");
+        Serial.print(cycles * nsPerCycle / ITERATIONS * 4250e-7f);
+        Serial.println("% of the output period");
+    }
+
+    // Post-filter cost per input sample and channel: a 4th order Butterworth
+    // low-pass followed by a 3rd order CIC decimating by 4, on the float
+    // block from the scaling rows and on the same samples in fixed point
+    static int32_t fixedChannels[7][SCALE_BLOCK];
+    ADIS16490_RawBlock fixedBlock = {{fixedChannels[0], fixedChannels[1], fixedChannels[2]},
+                                     {fixedChannels[3], fixedChannels[4], fixedChannels[5]}, fixedChannels[6]};
+    ADIS16490_FilterPipeline::unpack(rawBlock, fixedBlock, SCALE_BLOCK);
+    static ADIS16490_Biquad lowpass;
+    static ADIS16490_Cic decimator(3, 4);
+    lowpass.setButterworth(4, 4250, 100);
+    ADIS16490_FilterPipeline pipeline;
+    pipeline.add(lowpass);
+    pipeline.add(decimator);
+    cycles = bus->cycleCount();
+    pipeline.process(soa, SCALE_BLOCK);
+    uint32_t floatCycles = bus->cycleCount() - cycles;
+    pipeline.reset();
+    cycles = bus->cycleCount();
+    pipeline.process(fixedBlock, SCALE_BLOCK);
+    uint32_t fixedCycles = bus->cycleCount() - cycles;
+    Serial.print("Filter biquad x2 + CIC 3/4: float ");
+    Serial.print((float)floatCycles / (SCALE_BLOCK * 7));
+    Serial.print(" cycles/sample, fixed ");
+    Serial.print((float)fixedCycles / (SCALE_BLOCK * 7));
+    Serial.print(" cycles/sample per channel, ");
+    Serial.print((floatCycles < fixedCycles ? floatCycles : fixedCycles) * nsPerCycle / SCALE_BLOCK);
+    Serial.println(" ns per 7-channel sample");
+
+    // Find the fastest error-free clocks on the real sensor. Store the result
+    // (e.g. in EEPROM) and pass it to setClocks() at the next startup.
+    if (IMU.autoTuneClocks()) {
+        Serial.print("Auto-tuned SCLK: register ");
+        Serial.print(IMU.clocks().regClock);
+        Serial.print(" Hz, burst ");
+        Serial.print(IMU.clocks().burstClock);
+        Serial.println(" Hz");
+    }
+    else {
+        Serial.println("Auto-tune failed, keeping default SCLK");
+    }
+}
+
+// Main loop
+void loop()
+{
+    // Nothing to do here! All measurements are made once in setup()
+}
@@ -6,9 +6,12 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 // 
 //  This Arduino project interfaces with an ADIS16490 using SPI and the 
-//  accompanying C++ libraries, reads IMU data in LSBs, scales the data, and 
-//  outputs measurements to a serial debug terminal (PuTTY) via the onboard 
-//  USB serial port.
+//  accompanying C++ libraries, reads IMU data in LSBs, and streams every
+//  sample over the onboard USB serial port as binary frames (see
+//  ADIS16490_Stream.h). Decode the stream on a Linux host with
+//  extras/ADIS16490_Decoder, e.g. adis16490_decode /dev/ttyACM0 > log.csv
+//  Set OUTPUT_FORMAT to OUTPUT_COMPRESSED for delta-compressed packets
+//  (decode with adis16490_decode -z) or OUTPUT_CSV for human-readable text.
 //
 //  This project has been tested on a PJRC 32-Bit Teensy 3.2 Development Board, 
 //  but should be compatible with any other embedded platform with some modification.
@@ -42,43 +45,103 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 #include <ADIS16490.h>
+#include <ADIS16490_Capture.h>
+#include <ADIS16490_Rate.h>
+#include <ADIS16490_Stream.h>
+#include <ADIS16490_Compress.h>
 #include <SPI.h>
 
-// Temporary Data Arrays
-int16_t *sensorData;
-String separator = ",";
+// Output formats
+#define OUTPUT_CSV        0 // Text, one line per sample
+#define OUTPUT_BINARY     1 // ADIS16490_Stream frames, 28 bytes per sample
+#define OUTPUT_COMPRESSED 2 // ADIS16490_Compress packets, ~5 bytes per sample
+#define OUTPUT_FORMAT OUTPUT_BINARY
+
+// Target output rate (Hz). The nearest DEC_RATE setting is used; 4250 Hz
+// is the full rate without decimation.
+#define OUTPUT_RATE 4250
+
+// Frames collected before each Serial.write()
+#define FRAMES_PER_WRITE 16
 
 // Call ADIS16490 Class
 ADIS16490 IMU(10,2,6); // Chip Select, Data Ready, Reset Pin Assignments
 
+// Interrupt-driven capture into a ring buffer
+ADIS16490_Capture capture(IMU);
+
+// DEC_RATE and output period bookkeeping
+ADIS16490_RateManager rate(IMU);
+
+// Binary frame encoder, block compressor, and output buffers
+ADIS16490_StreamEncoder encoder;
+ADIS16490_Compressor compressor;
+uint8_t frames[FRAMES_PER_WRITE * STREAM_FRAME_BYTES];
+uint8_t packet[COMPRESS_MAX_PACKET];
+
 void setup()
 {
-    Serial.begin(9600); // Initialize serial output via USB
+    Serial.begin(115200); // Initialize serial output via USB (the rate is ignored by USB serial)
     IMU.configSPI(); // Configure SPI communication
     delay(1000); // Give the part time to start up
     IMU.regWrite(FNCTIO_CTRL, 0x0C);  // Enable Data Ready, set polarity
     delay(20); 
-    IMU.regWrite(DEC_RATE, 0x17), // Disable decimation
+    rate.setRate(OUTPUT_RATE); // Write and verify DEC_RATE
     delay(20);
 
     // Configure SPI settings for IMU
     IMU.configSPI();
 
-    // Attach interrupt to pin 2. Trigger on the rising edge
-    attachInterrupt(2, grabData, RISING); 
-}
-
-// Function used to read register values when an ISR is triggered using the IMU's DataReady output
-void grabData()
-{
-    sensorData = IMU.sensorRead();
-    // Print burst data to serial port. Data output rate is determined by the IMU decimation rate
-    String data = ((*(sensorData + 2)) + separator + (*(sensorData + 3)) + separator + (*(sensorData + 4)) + separator + (*(sensorData + 5)) + separator + (*(sensorData + 6)) + separator + (*(sensorData + 7)) + separator + (*(sensorData + 8)));
-    Serial.println(data); 
+    // Size the capture buffer and continuity check for the achieved rate, then
+    // attach the capture ISR to the data ready pin. The ISR only performs the
+    // burst read; samples are printed from loop()
+    rate.apply(capture);
+    capture.begin();
 }
 
-// Main loop
+// Main loop. Send every captured sample to the serial port. Data output rate is determined by the IMU decimation rate
 void loop()
 {
-    // Nothing to do here! The program is entirely interrupt-driven!
+#if OUTPUT_FORMAT == OUTPUT_CSV
+    const ADIS16490_Sample *sample;
+    while ((sample = capture.peek()) != 0)
+    {
+        Serial.print(sample->gyro[0]);
+        Serial.print(",");
+        Serial.print(sample->gyro[1]);
+        Serial.print(",");
+        Serial.print(sample->gyro[2]);
+        Serial.print(",");
+        Serial.print(sample->accel[0]);
+        Serial.print(",");
+        Serial.print(sample->accel[1]);
+        Serial.print(",");
+        Serial.print(sample->accel[2]);
+        Serial.print(",");
+        Serial.println(sample->temp);
+        capture.release();
+    }
+#elif OUTPUT_FORMAT == OUTPUT_COMPRESSED
+    // Compress straight from the ring buffer slots; a packet is sent each
+    // time a block fills
+    const ADIS16490_Sample *sample;
+    while ((sample = capture.peek()) != 0)
+    {
+        size_t length = compressor.add(*sample, packet);
+        capture.release();
+        if (length)
+            Serial.write(packet, length);
+    }
+#else
+    // Encode straight from the ring buffer slots and send in blocks
+    size_t length = 0;
+    const ADIS16490_Sample *sample;
+    while (length < sizeof(frames) && (sample = capture.peek()) != 0)
+    {
+        length += encoder.encode(*sample, frames + length);
+        capture.release();
+    }
+    if (length)
+        Serial.write(frames, length);
+#endif
 }
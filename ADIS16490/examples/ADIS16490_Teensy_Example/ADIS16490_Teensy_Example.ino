@@ -42,6 +42,7 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 #include <ADIS16490.h>
+#include <ADIS16490_Capture.h>
 #include <SPI.h>
 
 // Uncomment to enable debug
@@ -61,6 +62,10 @@ int printCounter = 0;
 // Call ADIS16490 Class
 ADIS16490 IMU(10,2,6); // Chip Select, Data Ready, Reset Pin Assignments
 
+// Interrupt-driven capture into a ring buffer
+ADIS16490_Capture capture(IMU);
+ADIS16490_Sample sample;
+
 void setup()
 {
     Serial.begin(115200); // Initialize serial output via USB
@@ -68,32 +73,35 @@ void setup()
     delay(1000); // Give the part time to start up
     IMU.regWrite(FNCTIO_CTRL, 0x0C);  // Enable Data Ready, set polarity
     delay(20); 
-    IMU.regWrite(DEC_RATE, 0x00), // Disable decimation
+    IMU.regWrite(DEC_RATE, 0x00); // Disable decimation
     delay(20);
 
     // Read the control registers once to print to screen
     MSC = IMU.regRead(FNCTIO_CTRL);
     DECR = IMU.regRead(DEC_RATE);
+    sensorData[1] = IMU.regRead(SYS_E_FLAG);
 
     // Configure SPI settings for IMU
     IMU.configSPI();
 
-    // Attach interrupt to pin 2. Trigger on the rising edge
-    attachInterrupt(2, grabData, RISING); 
+    // Attach the capture ISR to the data ready pin. Trigger on the rising edge
+    capture.begin();
 }
 
-// Function used to read register values when an ISR is triggered using the IMU's DataReady output
+// Function used to copy the newest captured sample into the display array
 void grabData()
 {
-    sensorData[0] = IMU.regRead(DIAG_STS); 
-    sensorData[1] = IMU.regRead(ALM_STS); 
-    sensorData[2] = IMU.regRead(X_GYRO_OUT); 
-    sensorData[3] = IMU.regRead(Y_GYRO_OUT); 
-    sensorData[4] = IMU.regRead(Z_GYRO_OUT); 
-    sensorData[5] = IMU.regRead(X_ACCL_OUT); 
-    sensorData[6] = IMU.regRead(Y_ACCL_OUT); 
-    sensorData[7] = IMU.regRead(Z_ACCL_OUT); 
-    sensorData[8] = IMU.regRead(TEMP_OUT);
+    while (capture.read(sample))
+    {
+        sensorData[0] = sample.status;
+        sensorData[2] = sample.gyro[0];
+        sensorData[3] = sample.gyro[1];
+        sensorData[4] = sample.gyro[2];
+        sensorData[5] = sample.accel[0];
+        sensorData[6] = sample.accel[1];
+        sensorData[7] = sample.accel[2];
+        sensorData[8] = sample.temp;
+    }
 }
 
 // Function used to scale all acquired data (scaling functions are included in ADIS16490.cpp)
@@ -111,10 +119,10 @@ void scaleData()
 // Main loop. Print data to the serial port. Sensor sampling is performed in the ISR
 void loop()
 {
+    grabData(); // Drain the capture buffer so it never overruns
     printCounter ++;
     if (printCounter >= 200000) // Delay for writing data to the serial port
     {
-        detachInterrupt(2); //Detach interrupt to avoid overwriting data
         scaleData(); // Scale data acquired from the IMU
 
         //Clear the serial terminal and reset cursor
@@ -159,7 +167,7 @@ void loop()
         // Print Status Registers
         Serial.print("DIAG_STS: ");
         Serial.println(sensorData[0]);
-        Serial.print("ALM_STS: ");
+        Serial.print("SYS_E_FLAG: ");
         Serial.println(sensorData[1]);
        
         // Print scaled temp data
@@ -188,7 +196,9 @@ void loop()
         Serial.print("TEMP: ");
         Serial.println(sensorData[8]);
 #endif
+        Serial.print("Overruns: ");
+        Serial.println(capture.overruns());
+
         printCounter = 0;
-        attachInterrupt(2, grabData, RISING);
     }
 }
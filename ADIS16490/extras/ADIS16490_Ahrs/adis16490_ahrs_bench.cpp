@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_ahrs_bench.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host benchmark for ADIS16490_Ahrs. Synthetic motion profiles are integrated in double precision,
+//  converted to raw gyro and accel words with a constant gyro bias and white noise added, and fed
+//  to the Mahony and Kalman filters as ADIS16490_Sample records at the 4250 Hz output rate.
+//
+//  For each profile the benchmark reports the RMS and worst tilt (roll/pitch) error over the second
+//  half of the run, the estimated X gyro bias against the injected one, accel updates rejected by
+//  the gate, and the mean cost of one update as time and as a share of the 235 us output period.
+//  A final run applies the Kalman accel update on every sample, which bounds the cost of any
+//  single update.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_ahrs_bench adis16490_ahrs_bench.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Ahrs.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RATE    4250.0
+#define GRAVITY 9.80665
+
+// Injected gyro bias (deg/sec) and noise (LSB rms)
+#define GYRO_BIAS   0.2
+#define GYRO_NOISE  2.0
+#define ACCL_NOISE  4.0
+
+// Body angular rate (rad/sec) and NED kinematic acceleration (m/sec^2) at time t
+typedef void (*Profile)(double t, double *rate, double *accel);
+
+// Still, starting from the filter's level initial attitude
+static void stationary(double, double *w, double *a) {
+  w[0] = w[1] = w[2] = 0;
+  a[0] = a[1] = a[2] = 0;
+}
+
+// 20 deg roll step at t = 1 s, then still
+static void rollStep(double t, double *w, double *a) {
+  w[0] = (t >= 1.0 && t < 1.5) ? 40 * M_PI / 180 : 0;
+  w[1] = w[2] = 0;
+  a[0] = a[1] = a[2] = 0;
+}
+
+// 0.5 Hz roll/pitch oscillation with a slow yaw
+static void swing(double t, double *w, double *a) {
+  double s = 2 * M_PI * 0.5 * t;
+  w[0] = 0.5 * sin(s);
+  w[1] = 0.4 * cos(s);
+  w[2] = 0.1;
+  a[0] = a[1] = a[2] = 0;
+}
+
+// Level with 0.5 s, 5 m/sec^2 north accelerations every 2 s
+static void pulses(double t, double *w, double *a) {
+  w[0] = w[1] = w[2] = 0;
+  a[0] = fmod(t, 2.0) < 0.5 ? 5.0 : 0;
+  a[1] = a[2] = 0;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Standard normal variate
+static double gauss() {
+  double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static int16_t quantize(double value) {
+  double r = floor(value + 0.5);
+  return (int16_t)(r > 32767 ? 32767 : (r < -32768 ? -32768 : r));
+}
+
+// Down direction seen in the body frame for quaternion q (body to NED)
+template <typename T>
+static void down(const T *q, double *d) {
+  d[0] = 2 * (q[1] * q[3] - q[0] * q[2]);
+  d[1] = 2 * (q[2] * q[3] + q[0] * q[1]);
+  d[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+// Tilt error (deg): angle between the true and estimated down directions
+static double tiltError(const double *q, const float *e) {
+  double a[3], b[3];
+  down(q, a);
+  down(e, b);
+  double c[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+  double s = sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+  double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  return atan2(s, dot) * 180 / M_PI;
+}
+
+// Runs one filter over seconds of a profile
+static void run(const char *name, Profile profile, double seconds, uint8_t mode) {
+  ADIS16490_Ahrs ahrs(mode);
+  srand(1);
+  double q[4] = {1, 0, 0, 0};
+  const double dt = 1.0 / RATE;
+  const double gyroPerRad = 180 / M_PI / GYRO_LSB, accelPerMs2 = 1000 / GRAVITY / ACCL_LSB;
+  long updates = (long)(seconds * RATE);
+  double busy = 0, sum2 = 0, worst = 0;
+  long count = 0;
+
+  for (long k = 0; k < updates; k++) {
+    double w[3], a[3];
+    profile((k + 0.5) * dt, w, a);
+
+    // Specific force in the body frame: C' (a - g)
+    double n[3] = {a[0], a[1], a[2] - GRAVITY};
+    double C[3][3] = {
+      {1 - 2 * (q[2] * q[2] + q[3] * q[3]), 2 * (q[1] * q[2] - q[0] * q[3]), 2 * (q[1] * q[3] + q[0] * q[2])},
+      {2 * (q[1] * q[2] + q[0] * q[3]), 1 - 2 * (q[1] * q[1] + q[3] * q[3]), 2 * (q[2] * q[3] - q[0] * q[1])},
+      {2 * (q[1] * q[3] - q[0] * q[2]), 2 * (q[2] * q[3] + q[0] * q[1]), 1 - 2 * (q[1] * q[1] + q[2] * q[2])} };
+
+    ADIS16490_Sample sample = {};
+    for (int i = 0; i < 3; i++) {
+      double f = C[0][i] * n[0] + C[1][i] * n[1] + C[2][i] * n[2];
+      sample.gyro[i] = quantize(w[i] * gyroPerRad + GYRO_BIAS / GYRO_LSB + GYRO_NOISE * gauss());
+      sample.accel[i] = quantize(f * accelPerMs2 + ACCL_NOISE * gauss());
+    }
+
+    // Truth attitude advances over the same period
+    double phi = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]) * dt;
+    double c = cos(phi / 2), s = phi > 0 ? sin(phi / 2) / phi * dt : dt / 2;
+    double d[4] = {c, w[0] * s, w[1] * s, w[2] * s};
+    double r[4] = {
+      q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3],
+      q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2],
+      q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1],
+      q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0] };
+    for (int i = 0; i < 4; i++)
+      q[i] = r[i];
+
+    double start = now();
+    ahrs.update(sample, (float)dt);
+    busy += now() - start;
+
+    if (k >= updates / 2) {
+      double e = tiltError(q, ahrs.quaternion());
+      sum2 += e * e;
+      worst = e > worst ? e : worst;
+      count++;
+    }
+  }
+
+  double ns = busy * 1e9 / updates;
+  printf("%-10s %-6s tilt rms %.3f max %.3f deg  x bias %.3f / %.3f deg/s  rejected %6lu  "
+         "%6.1f ns/update  %.2f%% of period\n",
+         name, mode == AHRS_MAHONY ? "mahony" : "kalman", sqrt(sum2 / count), worst,
+         ahrs.gyroBias()[0] * 180 / M_PI, GYRO_BIAS, (unsigned long)ahrs.rejected(), ns, ns * 1e-9 * RATE * 100);
+}
+
+// Worst case per-sample cost: the Kalman filter with an accel update on
+// every sample
+static void worstCase() {
+  ADIS16490_Ahrs ahrs(AHRS_KALMAN);
+  ahrs.setNoise(0.0003f, 0.0001f, 0.05f, 1);
+  ADIS16490_Sample sample = {};
+  sample.accel[2] = (int16_t)(-1000 / ACCL_LSB);
+  const long updates = 1000000;
+  double start = now();
+  for (long k = 0; k < updates; k++) {
+    sample.gyro[k & 3] = (int16_t)(k & 63);
+    ahrs.update(sample, 1.0f / (float)RATE);
+  }
+  double ns = (now() - start) * 1e9 / updates;
+  printf("kalman with accel update every sample: %.1f ns/update  %.2f%% of period\n", ns, ns * 1e-9 * RATE * 100);
+}
+
+int main() {
+  Profile profiles[] = {stationary, rollStep, swing, pulses};
+  const char *names[] = {"stationary", "roll step", "swing", "pulses"};
+  for (int i = 0; i < 4; i++) {
+    run(names[i], profiles[i], 60, AHRS_MAHONY);
+    run(names[i], profiles[i], 60, AHRS_KALMAN);
+  }
+  worstCase();
+  return 0;
+}
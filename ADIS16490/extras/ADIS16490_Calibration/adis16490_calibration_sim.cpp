@@ -0,0 +1,471 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_calibration_sim.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host test of ADIS16490_BiasCalibration against ADIS16490_Sim. The simulated sensor adds known
+//  gyro and accel biases and white noise to a stationary signal, then applies the page 2 bias
+//  registers to its 32-bit outputs as the device does. Scenarios add handling and a slow rotation
+//  that stops partway through, and one never holds still.
+//
+//  For each scenario the tool runs the calibration, compares the registers written with the negated
+//  injected biases, then takes a second average with the new registers to show the residual offset.
+//  It prints window counts and the frames of the write-back batch.
+//
+//  The tumble scenarios test ADIS16490_TumbleCalibration. A second simulated sensor has known scale
+//  and misalignment matrices and applies the X_GYRO_SCALE ~ Z_ACCL_SCALE registers. It is turned
+//  through six faces with 90 and 180 degree moves about each axis. The tool writes the fitted
+//  scales, then checks that the model times the new device scale times the true matrix is the
+//  identity and that the model offsets match the injected biases. The tumble is repeated with one
+//  output in 25 dropped before add(), as a capture ring overrun would, and at DEC_RATE = 1. A
+//  tumble that skips a face must time out and leave the registers alone. The tool exits non-zero if
+//  an error exceeds its tolerance or a calibration that should fail does not.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_calibration_sim adis16490_calibration_sim.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Calibration.h"
+#include "ADIS16490_Sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RATE 4250.0
+
+// Output noise (LSB rms)
+#define GYRO_NOISE  20.0 // 0.1 deg/sec
+#define ACCL_NOISE  2.0  // 1 mg
+
+// Tolerances on the written registers
+#define GYRO_TOLERANCE  0.005 // deg/sec
+#define ACCL_TOLERANCE  0.1   // mg
+
+// Extra rate (deg/sec) and acceleration (mg) at time t
+typedef void (*Disturbance)(double t, double *rate, double *accel);
+
+// Stationary sensor with injected biases. Outputs are the true value plus
+// bias and noise, plus the XG_BIAS ~ ZA_BIAS registers.
+class BiasSim : public ADIS16490_Sim {
+
+public:
+  BiasSim(const double *gyroBias, const double *accelBias, const double *gravity, Disturbance disturbance)
+    : _disturbance(disturbance) {
+    for (int axis = 0; axis < 3; axis++) {
+      _gyroBias[axis] = gyroBias[axis];
+      _accelBias[axis] = accelBias[axis];
+      _gravity[axis] = gravity[axis];
+    }
+    srand(7);
+  }
+
+protected:
+  void generateSample(uint32_t sampleCount) {
+    double t = sampleCount / RATE, rate[3] = {0, 0, 0}, accel[3] = {0, 0, 0};
+    if (_disturbance)
+      _disturbance(t, rate, accel);
+    int16_t gyroOut[3], accelOut[3];
+    for (int axis = 0; axis < 3; axis++) {
+      double gyro = (rate[axis] + _gyroBias[axis]) / GYRO_LSB + GYRO_NOISE * gauss();
+      double accl = (_gravity[axis] + accel[axis] + _accelBias[axis]) / ACCL_LSB + ACCL_NOISE * gauss();
+      int32_t gyroWord = output(gyro, bias(XG_BIAS_LOW + 4 * axis));
+      int32_t accelWord = output(accl, bias(XA_BIAS_LOW + 4 * axis));
+      gyroOut[axis] = (int16_t)(gyroWord >> 16);
+      accelOut[axis] = (int16_t)(accelWord >> 16);
+      poke(X_GYRO_LOW + 4 * axis, (uint16_t)gyroWord);
+      poke(X_ACCL_LOW + 4 * axis, (uint16_t)accelWord);
+    }
+    loadSample(gyroOut, accelOut, 700);
+  }
+
+private:
+  int32_t bias(uint16_t lowAddr) const {
+    return (int32_t)(((uint32_t)peek(lowAddr + 2) << 16) | peek(lowAddr));
+  }
+
+  // 32-bit output word of a value in LSB, saturated
+  static int32_t output(double value, int32_t bias) {
+    double word = floor(value * 65536 + 0.5) + bias;
+    return word > INT32_MAX ? INT32_MAX : (word < INT32_MIN ? INT32_MIN : (int32_t)word);
+  }
+
+  static double gauss() {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+  }
+
+  double _gyroBias[3];
+  double _accelBias[3];
+  double _gravity[3];
+  Disturbance _disturbance;
+
+};
+
+// Two bumps: a 30 deg/sec, 0.2 s rotation with 50 mg vibration at 0.5 s
+// and 1.5 s
+static void handled(double t, double *rate, double *accel) {
+  double phase = fmod(t, 1.0);
+  if (t < 2.0 && phase >= 0.5 && phase < 0.7) {
+    rate[2] = 30 * sin(M_PI * (phase - 0.5) / 0.2);
+    accel[0] = 50 * sin(2 * M_PI * 40 * t);
+  }
+}
+
+// Slow 0.2 deg/sec turn for the first second, then still
+static void settling(double t, double *rate, double *) {
+  if (t < 1.0)
+    rate[2] = 0.2;
+}
+
+// Continuous 20 Hz vibration
+static void vibrating(double t, double *, double *accel) {
+  accel[2] = 30 * sin(2 * M_PI * 20 * t);
+}
+
+// Tumble tolerances on the compensated sensor
+#define SCALE_TOLERANCE     200e-6 // ppm/1e6
+#define ALIGN_TOLERANCE     0.02   // deg
+#define GYRO_OFFSET_TOL     0.005  // deg/sec
+#define ACCL_OFFSET_TOL     0.2    // mg
+
+// Still time between moves (sec) and move rate (90 deg in 2 sec)
+#define TUMBLE_STILL 3.0
+#define TUMBLE_RATE  45.0
+
+// One move of the tumble: angle (deg) about a body axis
+struct Move {
+  int axis;
+  double angle;
+};
+
+// Starting level (Z down), reaches every face with moves about each axis
+static const Move fullTumble[] = {
+  {0, 90}, {0, 180}, {0, 90}, {1, 90}, {1, 180}, {1, 90}, {0, 180}, {2, 90},
+};
+
+// Never reaches Z up
+static const Move partialTumble[] = {
+  {0, 90}, {0, 180}, {0, 90}, {1, 90}, {1, 180}, {1, 90}, {2, 90},
+};
+
+static void rotation(int axis, double angle, double R[3][3]) {
+  double c = cos(angle * M_PI / 180), s = sin(angle * M_PI / 180);
+  int i = (axis + 1) % 3, j = (axis + 2) % 3;
+  for (int r = 0; r < 3; r++)
+    for (int k = 0; k < 3; k++)
+      R[r][k] = r == k;
+  R[i][i] = R[j][j] = c;
+  R[i][j] = -s;
+  R[j][i] = s;
+}
+
+static void multiply(const double A[3][3], const double B[3][3], double C[3][3]) {
+  for (int r = 0; r < 3; r++)
+    for (int k = 0; k < 3; k++)
+      C[r][k] = A[r][0] * B[0][k] + A[r][1] * B[1][k] + A[r][2] * B[2][k];
+}
+
+// Sensor turned through a list of moves with raised cosine rate profiles.
+// Outputs are K * (T * truth + bias + noise) + B, with T the true scale
+// and misalignment, K from the scale registers and B the bias registers.
+class TumbleSim : public ADIS16490_Sim {
+
+public:
+  TumbleSim(const double T[2][3][3], const double *gyroBias, const double *accelBias, const Move *moves, int count)
+    : _moves(moves), _count(count) {
+    for (int sensor = 0; sensor < 2; sensor++)
+      for (int r = 0; r < 3; r++)
+        for (int k = 0; k < 3; k++)
+          _T[sensor][r][k] = T[sensor][r][k];
+    for (int axis = 0; axis < 3; axis++) {
+      _bias[0][axis] = gyroBias[axis] / GYRO_LSB;
+      _bias[1][axis] = accelBias[axis] / ACCL_LSB;
+    }
+    srand(11);
+  }
+
+protected:
+  void generateSample(uint32_t) {
+    double t = nanos() * 1e-9, truth[2][3] = {{0, 0, 0}, {0, 0, 0}}, R[3][3], turn[3][3], next[3][3];
+    rotation(0, 0, R);
+    double start = 0;
+    for (int m = 0; m < _count; m++) {
+      start += TUMBLE_STILL;
+      if (t < start)
+        break;
+      double duration = fabs(_moves[m].angle) / TUMBLE_RATE, u = (t - start) / duration;
+      if (u < 1) {
+        double angle = _moves[m].angle * (u - sin(2 * M_PI * u) / (2 * M_PI));
+        truth[0][_moves[m].axis] = _moves[m].angle / duration * (1 - cos(2 * M_PI * u));
+        rotation(_moves[m].axis, angle, turn);
+        multiply(R, turn, next);
+        memcpy(R, next, sizeof(R));
+        break;
+      }
+      rotation(_moves[m].axis, _moves[m].angle, turn);
+      multiply(R, turn, next);
+      memcpy(R, next, sizeof(R));
+      start += duration;
+    }
+    // Body specific force is R' * (0, 0, -1 g)
+    for (int axis = 0; axis < 3; axis++)
+      truth[1][axis] = -1000 * R[2][axis];
+
+    int16_t out[2][3];
+    for (int sensor = 0; sensor < 2; sensor++)
+      for (int axis = 0; axis < 3; axis++) {
+        const double lsb = sensor ? ACCL_LSB : GYRO_LSB, noise = sensor ? ACCL_NOISE : GYRO_NOISE;
+        double raw = _bias[sensor][axis] + noise * gauss();
+        for (int k = 0; k < 3; k++)
+          raw += _T[sensor][axis][k] * truth[sensor][k] / lsb;
+        double scale = 1 + (int16_t)peek(X_GYRO_SCALE + 2 * (3 * sensor + axis)) / 32768.0;
+        uint16_t low = (sensor ? XA_BIAS_LOW : XG_BIAS_LOW) + 4 * axis;
+        int32_t bias = (int32_t)(((uint32_t)peek(low + 2) << 16) | peek(low));
+        int32_t word = (int32_t)(floor(raw * scale * 65536 + 0.5) + bias);
+        out[sensor][axis] = (int16_t)(word >> 16);
+        poke((sensor ? X_ACCL_LOW : X_GYRO_LOW) + 4 * axis, (uint16_t)word);
+      }
+    loadSample(out[0], out[1], 700);
+  }
+
+private:
+  static double gauss() {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+  }
+
+  double _T[2][3][3];
+  double _bias[2][3];
+  const Move *_moves;
+  int _count;
+
+};
+
+// Scale errors up to 0.4%, misalignment up to 0.15 deg
+static const double trueMatrix[2][3][3] = {
+  {{1.0031, 0.0012, -0.0021}, {-0.0008, 0.9972, 0.0017}, {0.0026, -0.0011, 1.0018}},
+  {{0.9962, -0.0015, 0.0009}, {0.0022, 1.0041, -0.0026}, {-0.0013, 0.0007, 0.9989}},
+};
+
+// Checks the compensated sensor after a tumble: M * K * T against the
+// identity, and the model offset against K * bias + B
+static bool checkTumble(TumbleSim &sim, const ADIS16490_TumbleCalibration &cal, const double *gyroBias,
+                        const double *accelBias, double *worst) {
+  const ADIS16490_ScaleModel &model = cal.model();
+  for (int sensor = 0; sensor < 2; sensor++) {
+    const float (*M)[3] = sensor ? model.accel : model.gyro;
+    const float *offset = sensor ? model.accelOffset : model.gyroOffset;
+    for (int r = 0; r < 3; r++) {
+      uint16_t low = (sensor ? XA_BIAS_LOW : XG_BIAS_LOW) + 4 * r;
+      int32_t bias = (int32_t)(((uint32_t)sim.peek(low + 2) << 16) | sim.peek(low));
+      double k = 1 + (int16_t)sim.peek(X_GYRO_SCALE + 2 * (3 * sensor + r)) / 32768.0;
+      double injected = (sensor ? accelBias[r] / ACCL_LSB : gyroBias[r] / GYRO_LSB) * k + bias / 65536.0;
+      double lsb = sensor ? ACCL_LSB : GYRO_LSB;
+      worst[4 + sensor] = fmax(worst[4 + sensor], fabs(offset[r] - injected) * lsb);
+      for (int c = 0; c < 3; c++) {
+        // Row r of M times column c of K * T
+        double e = 0;
+        for (int j = 0; j < 3; j++)
+          e += M[r][j] * (1 + (int16_t)sim.peek(X_GYRO_SCALE + 2 * (3 * sensor + j)) / 32768.0) *
+               trueMatrix[sensor][j][c];
+        if (r == c)
+          worst[sensor] = fmax(worst[sensor], fabs(e - 1));
+        else
+          worst[2 + sensor] = fmax(worst[2 + sensor], fabs(e) * 180 / M_PI);
+      }
+    }
+  }
+  return worst[0] < SCALE_TOLERANCE && worst[1] < SCALE_TOLERANCE && worst[2] < ALIGN_TOLERANCE &&
+         worst[3] < ALIGN_TOLERANCE && worst[4] < GYRO_OFFSET_TOL && worst[5] < ACCL_OFFSET_TOL;
+}
+
+struct TumbleScenario {
+  const char *name;
+  const Move *moves;
+  int count;
+  uint16_t decRate;
+  int dropEvery; // Drop one in this many outputs, as a ring overrun would (0 = none)
+  bool succeeds;
+};
+
+static const TumbleScenario tumbleScenarios[] = {
+  {"six faces", fullTumble, sizeof(fullTumble) / sizeof(fullTumble[0]), 0, 0, true},
+  {"lost outputs", fullTumble, sizeof(fullTumble) / sizeof(fullTumble[0]), 0, 25, true},
+  {"DEC_RATE 1", fullTumble, sizeof(fullTumble) / sizeof(fullTumble[0]), 1, 0, true},
+  {"five faces", partialTumble, sizeof(partialTumble) / sizeof(partialTumble[0]), 0, 0, false},
+};
+
+// Feeds add() from burst reads on data ready, dropping every dropEvery-th
+// output before it reaches the calibration
+static int feed(TumbleSim &sim, ADIS16490 &imu, ADIS16490_TumbleCalibration &cal, int dropEvery) {
+  uint64_t end = sim.nanos() + 60000000000ULL;
+  for (int n = 1; !cal.complete() && sim.nanos() < end; n++) {
+    while (sim.dataReady())
+      sim.advanceMicros(1);
+    while (!sim.dataReady())
+      sim.advanceMicros(1);
+    ADIS16490_Sample sample;
+    if (imu.burstRead(sample) && n % dropEvery != 0)
+      cal.add(sample);
+  }
+  return cal.complete();
+}
+
+static int runTumbles() {
+  int failures = 0;
+  const double gyroBias[3] = {0.08, -0.15, 0.21}, accelBias[3] = {4, -6, 3};
+  printf("\n%-16s %7s %5s %9s %5s %8s %6s %13s %10s %9s %10s %9s  %s\n", "Tumble", "windows", "still", "positions",
+         "moves", "rejected", "lost", "frames/naive", "scale ppm", "align deg", "offset dps", "offset mg", "result");
+  for (size_t s = 0; s < sizeof(tumbleScenarios) / sizeof(tumbleScenarios[0]); s++) {
+    const TumbleScenario &sc = tumbleScenarios[s];
+    TumbleSim sim(trueMatrix, gyroBias, accelBias, sc.moves, sc.count);
+    ADIS16490 imu(sim);
+    // Registers from an earlier calibration stay in effect
+    sim.poke(X_GYRO_SCALE, (uint16_t)120);
+    sim.poke(Z_ACCL_SCALE, (uint16_t)-75);
+    sim.poke(XG_BIAS_HIGH, 0x0003);
+    sim.poke(YA_BIAS_HIGH, 0xFFFC);
+    uint16_t before[6];
+    for (int c = 0; c < 6; c++)
+      before[c] = sim.peek(X_GYRO_SCALE + 2 * c);
+
+    imu.regWrite(DEC_RATE, sc.decRate);
+
+    ADIS16490_TumbleCalibration cal(imu);
+    cal.begin();
+    int collected = sc.dropEvery ? feed(sim, imu, cal, sc.dropEvery) : cal.collect(60000000);
+    int ok = collected && cal.solve() && cal.apply();
+    const ADIS16490_TumbleStats &stats = cal.stats();
+
+    bool pass;
+    double worst[6] = {0, 0, 0, 0, 0, 0};
+    if (sc.succeeds)
+      pass = ok && checkTumble(sim, cal, gyroBias, accelBias, worst);
+    else {
+      pass = !ok;
+      for (int c = 0; c < 6; c++)
+        pass = pass && sim.peek(X_GYRO_SCALE + 2 * c) == before[c];
+    }
+    if (!pass)
+      failures++;
+
+    char frames[16];
+    snprintf(frames, sizeof(frames), "%u/%u", stats.frames, stats.naiveFrames);
+    printf("%-16s %7u %5u %9u %5u %8u %6u", sc.name, stats.windows, stats.still, stats.positions, stats.moves,
+           stats.rejectedPositions + stats.rejectedMoves, stats.lost);
+    if (ok)
+      printf(" %13s %10.1f %9.4f %10.4f %9.3f", frames, 1e6 * fmax(worst[0], worst[1]), fmax(worst[2], worst[3]),
+             worst[4], worst[5]);
+    else
+      printf(" %13s %10s %9s %10s %9s", "-", "-", "-", "-", "-");
+    printf("  %s%s\n", ok ? "written" : "not written", pass ? "" : "  FAIL");
+    if (ok)
+      printf("  fit residual %.3f mg, %.4f deg\n", stats.accelResidual, stats.gyroResidual);
+  }
+  return failures;
+}
+
+struct Scenario {
+  const char *name;
+  double gyroBias[3];  // deg/sec
+  double accelBias[3]; // mg
+  double gravity[3];   // mg
+  Disturbance disturbance;
+  bool succeeds;
+};
+
+static const Scenario scenarios[] = {
+  {"still, level", {0.12, -0.3, 0.05}, {3, -5, 8}, {0, 0, -1000}, 0, true},
+  {"still, on side", {-0.07, 0.2, 0.15}, {-4, 2, 6}, {1000, 0, 0}, 0, true},
+  {"handled", {0.12, -0.3, 0.05}, {3, -5, 8}, {0, 0, -1000}, handled, true},
+  {"settling", {0.12, -0.3, 0.05}, {3, -5, 8}, {0, 0, -1000}, settling, true},
+  {"vibrating", {0.12, -0.3, 0.05}, {3, -5, 8}, {0, 0, -1000}, vibrating, false},
+};
+
+int main() {
+  int failures = 0;
+  printf("%-16s %7s %8s %5s %7s %8s %13s %12s %12s %12s  %s\n", "Scenario", "windows", "accepted", "noisy",
+         "shifted", "restarts", "frames/naive", "gyro err", "accel err", "residual", "result");
+  for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+    const Scenario &sc = scenarios[s];
+    BiasSim sim(sc.gyroBias, sc.accelBias, sc.gravity, sc.disturbance);
+    ADIS16490 imu(sim);
+    // A previous calibration is in place; the new one must replace it
+    sim.poke(XG_BIAS_LOW, 0x8000);
+    sim.poke(XG_BIAS_HIGH, 0x0005);
+    sim.poke(ZA_BIAS_HIGH, 0xFFF0);
+    ADIS16490_Bias before;
+    ADIS16490_BiasCalibration cal(imu);
+    cal.read(before);
+    cal.setGravity(sc.gravity[0], sc.gravity[1], sc.gravity[2]);
+    int ok = cal.run(BIAS_GYRO | BIAS_ACCEL);
+    ADIS16490_BiasStats stats = cal.stats();
+
+    // Registers against the negated injected biases
+    ADIS16490_Bias after;
+    cal.read(after);
+    double gyroError = 0, accelError = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      gyroError = fmax(gyroError, fabs(after.gyro[axis] / 65536.0 * GYRO_LSB + sc.gyroBias[axis]));
+      accelError = fmax(accelError, fabs(after.accel[axis] / 65536.0 * ACCL_LSB + sc.accelBias[axis]));
+    }
+
+    bool pass;
+    double residual = 0;
+    if (sc.succeeds) {
+      // Second pass with the new registers: the offset left over
+      ADIS16490_BiasCalibration check(imu);
+      check.setGravity(sc.gravity[0], sc.gravity[1], sc.gravity[2]);
+      check.begin();
+      check.collect();
+      ADIS16490_Bias left;
+      check.offset(left);
+      for (int axis = 0; axis < 3; axis++)
+        residual = fmax(residual, fabs(left.gyro[axis] / 65536.0 * GYRO_LSB));
+      pass = ok && gyroError < GYRO_TOLERANCE && accelError < ACCL_TOLERANCE && residual < GYRO_TOLERANCE &&
+             stats.verifyErrors == 0;
+    }
+    else {
+      // A failed calibration leaves the registers alone
+      pass = !ok;
+      for (int axis = 0; axis < 3; axis++)
+        pass = pass && after.gyro[axis] == before.gyro[axis] && after.accel[axis] == before.accel[axis];
+    }
+    if (!pass)
+      failures++;
+
+    char frames[16];
+    snprintf(frames, sizeof(frames), "%u/%u", stats.frames, stats.naiveFrames);
+    printf("%-16s %7u %8u %5u %7u %8u", sc.name, stats.windows, stats.accepted, stats.noisy, stats.shifted,
+           stats.restarts);
+    if (ok)
+      printf(" %13s %8.4f dps %9.3f mg %8.4f dps", frames, gyroError, accelError, residual);
+    else
+      printf(" %13s %12s %12s %12s", "-", "-", "-", "-");
+    printf("  %s%s\n", ok ? "written" : "not written", pass ? "" : "  FAIL");
+  }
+  failures += runTumbles();
+  printf("\n%s\n", failures ? "FAILED" : "All scenarios passed");
+  return failures ? 1 : 0;
+}
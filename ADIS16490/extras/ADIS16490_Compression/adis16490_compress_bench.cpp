@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_compress_bench.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host benchmark for the ADIS16490_Compress block compressor. Compresses simulated datasets
+//  (stationary noise and a moving sensor, generated with ADIS16490_Sim) and optionally a recorded
+//  dataset, then reports compression ratio against the 28-byte binary frames of ADIS16490_Stream,
+//  compressor and decompressor cost per sample, and verifies that every block decodes losslessly.
+//
+//  A recorded dataset is the CSV written by extras/ADIS16490_Decoder/adis16490_decode.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_compress_bench adis16490_compress_bench.cpp ../../*.cpp
+//
+//  Usage:
+//
+//    adis16490_compress_bench [recorded.csv]
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Compress.h"
+#include "ADIS16490_Sim.h"
+#include "ADIS16490_Stream.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+// Samples per simulated dataset
+#define SIM_SAMPLES 20000
+
+// Simulated sensor with white noise on every channel and optional motion
+class NoisySim : public ADIS16490_Sim {
+
+public:
+  NoisySim(float noise, float motion) : _noise(noise), _motion(motion), _seed(12345) {}
+
+protected:
+  void generateSample(uint32_t sampleCount) {
+    float t = sampleCount / 4250.0f;
+    int16_t gyro[3], accel[3];
+    for (int axis = 0; axis < 3; axis++) {
+      float wave = _motion * sinf(2.0f * 3.14159f * (0.5f + axis) * t);
+      gyro[axis] = (int16_t)(20 * axis + wave * 400.0f + gauss() * _noise);
+      accel[axis] = (int16_t)((axis == 2 ? 2000 : 0) + wave * 150.0f + gauss() * _noise);
+    }
+    loadSample(gyro, accel, (int16_t)(700 + gauss() * 0.5f));
+  }
+
+private:
+  // Approximately normal, unit variance
+  float gauss() {
+    float sum = 0;
+    for (int i = 0; i < 4; i++) {
+      _seed = _seed * 1664525u + 1013904223u;
+      sum += (_seed >> 8) / 16777216.0f;
+    }
+    return (sum - 2.0f) * 1.732f;
+  }
+
+  float _noise;
+  float _motion;
+  uint32_t _seed;
+
+};
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Captures SIM_SAMPLES samples at the sensor's 4250 Hz output rate
+static void simulate(float noise, float motion, std::vector<ADIS16490_Sample> &out) {
+  NoisySim sim(noise, motion);
+  ADIS16490 imu(sim);
+  out.resize(SIM_SAMPLES);
+  for (size_t i = 0; i < out.size(); i++) {
+    sim.advanceMicros(235);
+    imu.burstRead(out[i]);
+  }
+}
+
+// Reads the CSV written by adis16490_decode
+static bool load(const char *path, std::vector<ADIS16490_Sample> &out) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    unsigned seq, ts, status, count;
+    int v[7];
+    if (sscanf(line, "%u,%u,%u,%u,%d,%d,%d,%d,%d,%d,%d", &seq, &ts, &status, &count,
+               &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 11)
+      continue;
+    ADIS16490_Sample s;
+    s.timestamp = ts;
+    s.status = status;
+    s.dataCount = count;
+    for (int axis = 0; axis < 3; axis++) {
+      s.gyro[axis] = v[axis];
+      s.accel[axis] = v[3 + axis];
+    }
+    s.temp = v[6];
+    s.reserved = 0;
+    out.push_back(s);
+  }
+  fclose(f);
+  return true;
+}
+
+// Compresses, decompresses, and checks one dataset at one block size
+static void run(const char *name, const std::vector<ADIS16490_Sample> &data, uint8_t blockSize) {
+  std::vector<uint8_t> stream;
+  stream.reserve(data.size() * STREAM_FRAME_BYTES);
+  uint8_t packet[COMPRESS_MAX_PACKET];
+  ADIS16490_Compressor compressor(blockSize);
+
+  double start = now();
+  for (size_t i = 0; i < data.size(); i++) {
+    size_t n = compressor.add(data[i], packet);
+    stream.insert(stream.end(), packet, packet + n);
+  }
+  size_t n = compressor.flush(packet);
+  stream.insert(stream.end(), packet, packet + n);
+  double compressNs = (now() - start) * 1e9 / data.size();
+
+  ADIS16490_Decompressor decompressor;
+  size_t decoded = 0, mismatches = 0;
+  start = now();
+  for (size_t i = 0; i < stream.size(); i++) {
+    size_t count = decompressor.push(stream[i]);
+    for (size_t k = 0; k < count; k++, decoded++)
+      if (decoded >= data.size() || memcmp(&decompressor.samples()[k], &data[decoded], sizeof(ADIS16490_Sample)))
+        mismatches++;
+  }
+  double decompressNs = (now() - start) * 1e9 / data.size();
+
+  double bytesPerSample = (double)stream.size() / data.size();
+  printf("%-12s block %3u: %6.2f bytes/sample, ratio %5.2f:1, compress %6.1f ns/sample, "
+         "decompress %6.1f ns/sample, %s\n",
+         name, blockSize, bytesPerSample, STREAM_FRAME_BYTES / bytesPerSample, compressNs,
+         decompressNs, (decoded == data.size() && !mismatches) ? "lossless" : "MISMATCH");
+}
+
+int main(int argc, char **argv) {
+  static const uint8_t blocks[] = {1, 8, 16, COMPRESS_BLOCK};
+  std::vector<ADIS16490_Sample> data;
+
+  simulate(2.0f, 0.0f, data);
+  for (size_t b = 0; b < sizeof(blocks); b++)
+    run("stationary", data, blocks[b]);
+
+  simulate(2.0f, 1.0f, data);
+  for (size_t b = 0; b < sizeof(blocks); b++)
+    run("moving", data, blocks[b]);
+
+  if (argc > 1) {
+    data.clear();
+    if (!load(argv[1], data) || data.empty()) {
+      fprintf(stderr, "%s: no samples\n", argv[1]);
+      return 1;
+    }
+    for (size_t b = 0; b < sizeof(blocks); b++)
+      run("recorded", data, blocks[b]);
+  }
+  return 0;
+}
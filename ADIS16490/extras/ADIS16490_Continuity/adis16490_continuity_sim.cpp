@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_continuity_sim.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host validation of the DATA_CNT continuity counters in ADIS16490_Capture and
+//  ADIS16490_DmaCapture. The capture runs against ADIS16490_Sim with its service routine attached
+//  to the simulated data ready edge. Scenarios inject late interrupts (the handler is delayed by a
+//  random time before it reads) and polled capture at periods that do not match the output rate.
+//
+//  The simulator's own sample counter is the ground truth: between the first and last stored
+//  samples, every output it produced is either stored or skipped, and every extra read is a
+//  duplicate. For each scenario the tool prints the counters next to the truth and exits non-zero
+//  if they disagree.
+//
+//  One DMA scenario takes a data ready edge inside the completion callback, as the ISR preempting
+//  the completion handler would on a Teensy. The edge must be skipped: no transfer starts and the
+//  sample being published is not overwritten.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_continuity_sim adis16490_continuity_sim.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_DmaCapture.h"
+#include "ADIS16490_Sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Simulated run length
+#define RUN_MS 2000
+
+// Late interrupt injection shared by the handlers
+struct Injector {
+  ADIS16490_Sim *sim;
+  int percent;        // Chance of a late handler
+  uint32_t maxDelay;  // Longest delay (us)
+  uint32_t calls;     // Reads attempted
+  uint32_t worst;     // Longest delay actually injected (us)
+
+  void delay() {
+    if (rand() % 100 < percent) {
+      uint32_t us = rand() % (maxDelay + 1);
+      worst = us > worst ? us : worst;
+      sim->advanceMicros(us);
+    }
+  }
+};
+
+struct Context {
+  Injector injector;
+  ADIS16490_Capture *capture;
+  ADIS16490_DmaCapture *dma;
+};
+
+static void captureEdge(void *context) {
+  Context *c = (Context *)context;
+  c->injector.delay();
+  c->injector.calls++;
+  c->capture->service();
+}
+
+static void dmaEdge(void *context) {
+  Context *c = (Context *)context;
+  c->injector.delay();
+  c->injector.calls++;
+  c->dma->onDataReady();
+}
+
+static int failures = 0;
+
+// Stored samples: count and the first and last DATA_CNT
+struct Stored {
+  uint32_t count;
+  uint16_t first;
+  uint16_t last;
+
+  void add(const ADIS16490_Sample &sample) {
+    if (!count++)
+      first = sample.dataCount;
+    last = sample.dataCount;
+  }
+};
+
+// Compares the counters with the simulator's sample counter
+static void report(const char *name, const ADIS16490_SequenceStats &s, uint32_t produced,
+                   const Stored &stored, uint32_t reads, uint32_t injected) {
+  // Outputs between the first and last stored ones that were never stored
+  uint32_t lostTruth = (uint16_t)(stored.last - stored.first) + 1 - stored.count;
+  uint32_t dupTruth = reads - stored.count;
+  bool ok = s.lost == lostTruth && s.duplicates == dupTruth && s.samples == reads;
+  if (!ok)
+    failures++;
+  printf("%-22s outputs %5u stored %5u  gaps %4u lost %4u (truth %4u)  duplicates %4u (truth %4u)  "
+         "jitter max %3u us (injected %3u)  %s\n",
+         name, (unsigned)produced, (unsigned)stored.count, (unsigned)s.gaps, (unsigned)s.lost, (unsigned)lostTruth,
+         (unsigned)s.duplicates, (unsigned)dupTruth, (unsigned)s.maxJitter, (unsigned)injected, ok ? "ok" : "MISMATCH");
+}
+
+// Interrupt-driven capture, draining the ring as loop() would
+static void interruptRun(const char *name, int percent, uint32_t maxDelay) {
+  ADIS16490_Sim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_Capture capture(imu);
+  Context context = {{&sim, percent, maxDelay, 0, 0}, &capture, 0};
+  capture.begin();
+  sim.attachDataReady(captureEdge, &context);
+  uint32_t start = sim.peek(DATA_CNT);
+  Stored stored = {0, 0, 0};
+  for (int ms = 0; ms < RUN_MS; ms++) {
+    sim.advanceMicros(1000);
+    ADIS16490_Sample sample;
+    while (capture.read(sample))
+      stored.add(sample);
+  }
+  sim.attachDataReady(0, 0);
+  report(name, capture.sequenceStats(), sim.peek(DATA_CNT) - start, stored, context.injector.calls,
+         context.injector.worst);
+}
+
+// DMA capture with the same injection
+static void dmaRun(const char *name, int percent, uint32_t maxDelay) {
+  ADIS16490_Sim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_DmaCapture dma(imu);
+  Context context = {{&sim, percent, maxDelay, 0, 0}, 0, &dma};
+  dma.begin();
+  sim.attachDataReady(dmaEdge, &context);
+  uint32_t start = sim.peek(DATA_CNT);
+  Stored stored = {0, 0, 0};
+  for (int ms = 0; ms < RUN_MS; ms++) {
+    sim.advanceMicros(1000);
+    ADIS16490_Sample sample;
+    while (dma.read(sample))
+      stored.add(sample);
+  }
+  sim.attachDataReady(0, 0);
+  // Only transfers that completed with a good checksum are checked
+  report(name, dma.sequenceStats(), sim.peek(DATA_CNT) - start, stored, dma.stats().completed,
+         context.injector.worst);
+}
+
+// Completion callback that takes a data ready edge while it runs, as the
+// ISR preempting the DMA completion handler would. The engine must still
+// be BUSY, skip the edge, and leave the published sample untouched.
+struct Reentry {
+  ADIS16490_DmaCapture *dma;
+  uint32_t calls;   // Callbacks
+  uint32_t idle;    // Callbacks that found the engine IDLE
+  uint32_t started; // Transfers started by the nested edge
+  uint32_t changed; // Samples altered by the nested edge
+  Stored passed;    // Samples handed to the callback
+};
+
+static void reenter(const ADIS16490_Sample &sample, void *context) {
+  Reentry *r = (Reentry *)context;
+  ADIS16490_Sample copy = sample;
+  uint32_t started = r->dma->stats().started;
+  r->calls++;
+  r->idle += r->dma->idle();
+  r->dma->onDataReady();
+  r->started += r->dma->stats().started - started;
+  r->changed += memcmp(&copy, &sample, sizeof(copy)) != 0;
+  r->passed.add(copy);
+}
+
+static void dmaReentryRun(const char *name) {
+  ADIS16490_Sim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_DmaCapture dma(imu);
+  Context context = {{&sim, 0, 0, 0, 0}, 0, &dma};
+  Reentry reentry = {&dma, 0, 0, 0, 0, {0, 0, 0}};
+  dma.begin(reenter, &reentry);
+  sim.attachDataReady(dmaEdge, &context);
+  uint32_t start = sim.peek(DATA_CNT);
+  Stored stored = {0, 0, 0};
+  for (int ms = 0; ms < RUN_MS; ms++) {
+    sim.advanceMicros(1000);
+    ADIS16490_Sample sample;
+    while (dma.read(sample))
+      stored.add(sample);
+  }
+  sim.attachDataReady(0, 0);
+  report(name, dma.sequenceStats(), sim.peek(DATA_CNT) - start, stored, dma.stats().completed, 0);
+  bool ok = reentry.calls > 0 && reentry.idle == 0 && reentry.started == 0 && reentry.changed == 0 &&
+            dma.stats().busySkips >= reentry.calls && reentry.passed.count == stored.count &&
+            reentry.passed.first == stored.first && reentry.passed.last == stored.last;
+  if (!ok)
+    failures++;
+  printf("%-22s callbacks %5u idle %u  nested starts %u  altered %u  skipped edges %5u  %s\n", "",
+         (unsigned)reentry.calls, (unsigned)reentry.idle, (unsigned)reentry.started, (unsigned)reentry.changed,
+         (unsigned)dma.stats().busySkips, ok ? "ok" : "MISMATCH");
+}
+
+// Capture polled from loop() with period us between reads instead of on
+// data ready
+static void pollRun(const char *name, uint32_t period) {
+  ADIS16490_Sim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_Capture capture(imu);
+  capture.sequence().reset();
+  uint32_t start = sim.peek(DATA_CNT), reads = 0;
+  Stored stored = {0, 0, 0};
+  for (uint32_t t = 0; t < RUN_MS * 1000u; t += period) {
+    sim.advanceMicros(period);
+    capture.service();
+    reads++;
+    ADIS16490_Sample sample;
+    while (capture.read(sample))
+      stored.add(sample);
+  }
+  report(name, capture.sequenceStats(), sim.peek(DATA_CNT) - start, stored, reads, 0);
+}
+
+int main() {
+  srand(1);
+  interruptRun("isr on time", 0, 0);
+  interruptRun("isr late 5% <100us", 5, 100);
+  interruptRun("isr late 2% <700us", 2, 700);
+  interruptRun("isr late 10% <2ms", 10, 2000);
+  dmaRun("dma on time", 0, 0);
+  dmaRun("dma late 2% <700us", 2, 700);
+  dmaReentryRun("dma edge in callback");
+  pollRun("polled, 50us idle", 50);
+  pollRun("polled, 300us idle", 300);
+  return failures ? 1 : 0;
+}
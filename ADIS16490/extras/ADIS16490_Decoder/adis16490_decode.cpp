@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_decode.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Linux host tool that decodes the binary frame stream produced by ADIS16490_StreamEncoder (see
+//  ADIS16490_Stream.h), or with -z the packet stream produced by ADIS16490_Compressor (see
+//  ADIS16490_Compress.h), and prints one CSV line per sample. Input is a capture file, a serial
+//  device (put into raw mode automatically), or stdin. Frame, CRC error, resync, and lost frame
+//  counts plus the decoded sample rate are reported on stderr.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_decode adis16490_decode.cpp ../../ADIS16490_Stream.cpp ../../ADIS16490_Compress.cpp
+//
+//  Usage:
+//
+//    adis16490_decode [-q] [-z] [-n frames] [file|device]
+//    -q  do not print samples, only the summary
+//    -z  input is compressed packets
+//    -n  stop after this many samples
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Compress.h"
+#include "ADIS16490_Stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Puts a tty into raw mode so no bytes are translated or buffered by line
+static void makeRaw(int fd) {
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0)
+    return;
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  bool quiet = false;
+  bool compressed = false;
+  unsigned long limit = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "qzn:")) != -1) {
+    if (opt == 'q')
+      quiet = true;
+    else if (opt == 'z')
+      compressed = true;
+    else if (opt == 'n')
+      limit = strtoul(optarg, 0, 0);
+    else {
+      fprintf(stderr, "usage: %s [-q] [-z] [-n frames] [file|device]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int fd = 0;
+  if (optind < argc) {
+    fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+      perror(argv[optind]);
+      return 1;
+    }
+  }
+  if (isatty(fd))
+    makeRaw(fd);
+
+  ADIS16490_StreamDecoder decoder;
+  ADIS16490_Decompressor decompressor;
+  uint8_t buffer[4096];
+  unsigned long long bytes = 0;
+  unsigned long frames = 0;
+  uint32_t firstTimestamp = 0, lastTimestamp = 0;
+  double start = now();
+  bool done = false;
+
+  if (!quiet)
+    printf("seq,timestamp,status,count,gx,gy,gz,ax,ay,az,temp\n");
+  while (!done) {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n <= 0)
+      break;
+    bytes += n;
+    for (ssize_t i = 0; i < n && !done; i++) {
+      const ADIS16490_Sample *samples;
+      ADIS16490_Sample sample;
+      size_t count;
+      if (compressed) {
+        count = decompressor.push(buffer[i]);
+        samples = decompressor.samples();
+      }
+      else {
+        count = decoder.push(buffer[i], sample);
+        samples = &sample;
+      }
+      for (size_t k = 0; k < count && !done; k++) {
+        const ADIS16490_Sample &s = samples[k];
+        if (frames++ == 0)
+          firstTimestamp = s.timestamp;
+        lastTimestamp = s.timestamp;
+        if (!quiet)
+          printf("%lu,%u,%u,%u,%d,%d,%d,%d,%d,%d,%d\n", frames - 1, s.timestamp, s.status, s.dataCount,
+                 s.gyro[0], s.gyro[1], s.gyro[2], s.accel[0], s.accel[1], s.accel[2], s.temp);
+        if (limit && frames >= limit)
+          done = true;
+      }
+    }
+  }
+  double elapsed = now() - start;
+
+  if (compressed) {
+    const ADIS16490_CompressStats &stats = decompressor.stats();
+    fprintf(stderr, "%llu bytes, %u packets, %u samples, %u CRC errors, %u bytes skipped, %u packets lost\n",
+            bytes, stats.packets, stats.samples, stats.crcErrors, stats.skipped, stats.lost);
+  }
+  else {
+    const ADIS16490_StreamStats &stats = decoder.stats();
+    fprintf(stderr, "%llu bytes, %u frames, %u CRC errors, %u bytes skipped, %u frames lost\n",
+            bytes, stats.frames, stats.crcErrors, stats.skipped, stats.lost);
+  }
+  if (frames > 1 && lastTimestamp != firstTimestamp)
+    fprintf(stderr, "sensor rate %.1f samples/s (timestamps)\n",
+            (frames - 1) * 1e6 / (double)(lastTimestamp - firstTimestamp));
+  if (elapsed > 0)
+    fprintf(stderr, "decode rate %.0f samples/s, %.1f MB/s\n", frames / elapsed, bytes / elapsed / 1e6);
+  return 0;
+}
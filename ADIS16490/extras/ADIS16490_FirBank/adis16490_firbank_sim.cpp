@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_firbank_sim.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host test of ADIS16490_FirBank and the REG_OP_BYTE path of regBatch() against ADIS16490_Sim,
+//  which models the coefficient pages 5 ~ 12 and byte-wide register writes.
+//
+//  Each scenario uploads a table and compares the frames reported by stats() with the simulator's
+//  own frame counter and with the count expected from the batch layout: an uncached upload (whole
+//  bank read, then the differing bytes written and read back), an unchanged upload (no frames), a
+//  few changed taps (only their bytes), and an upload after invalidate(). A simulated stuck bit in
+//  one coefficient must show up as a verify error. The bank assignment scenarios check the
+//  FILTR_BNK_0/1 encoding against hand-built words and read it back with assignment(). The tool
+//  exits non-zero if any check fails.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_firbank_sim adis16490_firbank_sim.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_FirBank.h"
+#include "ADIS16490_Sim.h"
+#include <stdio.h>
+#include <string.h>
+
+// Frames for one page of chained reads after a page switch
+#define PAGE_READ_FRAMES (1 + FIR_TAPS_PER_PAGE + 1)
+
+// Simulator with one coefficient bit stuck high, as a damaged or
+// write-protected cell would read back
+class StuckSim : public ADIS16490_Sim {
+
+public:
+  StuckSim() : _page(0), _word(0), _mask(0) {}
+
+  void stick(uint8_t bank, uint8_t tap, uint16_t mask) {
+    _page = FIR_PAGE_FIRST + 2 * bank + tap / FIR_TAPS_PER_PAGE;
+    _word = (FIR_COEF_FIRST >> 1) + tap % FIR_TAPS_PER_PAGE;
+    _mask = mask;
+  }
+
+  void deselect() {
+    ADIS16490_Sim::deselect();
+    _regs[_page][_word] |= _mask;
+  }
+
+private:
+  uint8_t _page;
+  uint8_t _word;
+  uint16_t _mask;
+
+};
+
+static int failures = 0;
+
+static void check(const char *name, bool pass) {
+  if (!pass)
+    failures++;
+  printf("  %-52s %s\n", name, pass ? "ok" : "FAIL");
+}
+
+// Frames an upload of want over have costs once the bank is cached: per
+// page with changes, a page switch, one frame per differing byte, and the
+// chained readbacks of the changed taps
+static uint32_t uploadFrames(const int16_t *have, const int16_t *want) {
+  uint32_t frames = 0;
+  for (int first = 0; first < FIR_TAPS; first += FIR_TAPS_PER_PAGE) {
+    uint32_t writes = 0, changed = 0;
+    for (int tap = first; tap < first + FIR_TAPS_PER_PAGE; tap++) {
+      uint16_t diff = (uint16_t)(have[tap] ^ want[tap]);
+      writes += ((diff & 0x00FF) != 0) + ((diff & 0xFF00) != 0);
+      changed += diff != 0;
+    }
+    if (changed)
+      frames += 1 + writes + changed + 1;
+  }
+  return frames;
+}
+
+// Bank contents as seen by the simulator
+static bool deviceHolds(ADIS16490_Sim &sim, uint8_t bank, const int16_t *coeffs) {
+  for (int tap = 0; tap < FIR_TAPS; tap++) {
+    uint16_t addr = ((FIR_PAGE_FIRST + 2 * bank + tap / FIR_TAPS_PER_PAGE) << 8) |
+                    (FIR_COEF_FIRST + 2 * (tap % FIR_TAPS_PER_PAGE));
+    if ((int16_t)sim.peek(addr) != coeffs[tap])
+      return false;
+  }
+  return true;
+}
+
+// Uploads a table and checks the reported frames against the simulator
+// and the expected count
+static void upload(ADIS16490_Sim &sim, ADIS16490_FirBank &fir, const char *name, uint8_t bank,
+                   const int16_t *table, uint32_t expected, bool succeeds) {
+  uint32_t before = sim.stats().frames;
+  int ok = fir.upload(bank, table);
+  const ADIS16490_FirStats &stats = fir.stats();
+  uint32_t frames = sim.stats().frames - before;
+  printf("%-24s %7u %10u %6u %8u %5u %6u %7u\n", name, stats.changed, stats.byteWrites, stats.frames, frames,
+         expected, stats.naiveFrames, stats.verifyErrors);
+  check("frames match the simulator and the batch layout", stats.frames == frames && frames == expected);
+  check(succeeds ? "verified" : "verify error reported", succeeds ? ok == 1 : ok == 0 && stats.verifyErrors == 1);
+  check("cache matches the device", deviceHolds(sim, bank, fir.cached(bank)));
+}
+
+static void uploads() {
+  ADIS16490_Sim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_FirBank fir(imu);
+  static int16_t zero[FIR_TAPS], table[FIR_TAPS], edited[FIR_TAPS];
+  // Low-pass shape with both signs and values in one or both bytes
+  for (int tap = 0; tap < FIR_TAPS; tap++)
+    table[tap] = (int16_t)((tap % 7 == 0) ? 0 : (tap < FIR_TAPS / 2 ? 37 * tap : -29 * (FIR_TAPS - tap)));
+  memcpy(edited, table, sizeof(edited));
+  edited[5] ^= 0x0001;  // Low byte only
+  edited[70] ^= 0x0100; // High byte only
+  edited[71] = ~edited[71];
+
+  printf("%-24s %7s %10s %6s %8s %5s %6s %7s\n", "Upload", "changed", "byteWrites", "frames", "sim", "exp",
+         "naive", "errors");
+  upload(sim, fir, "uncached", FIR_BANK_A, table, 2 * PAGE_READ_FRAMES + uploadFrames(zero, table), true);
+  check("device holds the table", deviceHolds(sim, FIR_BANK_A, table));
+  upload(sim, fir, "unchanged", FIR_BANK_A, table, 0, true);
+  upload(sim, fir, "three taps changed", FIR_BANK_A, edited, uploadFrames(table, edited), true);
+  check("device holds the edited table", deviceHolds(sim, FIR_BANK_A, edited));
+  fir.invalidate();
+  upload(sim, fir, "after invalidate()", FIR_BANK_A, edited, 2 * PAGE_READ_FRAMES, true);
+  upload(sim, fir, "bank C, matches device", FIR_BANK_C, zero, 2 * PAGE_READ_FRAMES, true);
+  check("bank A still holds the edited table", deviceHolds(sim, FIR_BANK_A, edited));
+}
+
+static void stuckBit() {
+  StuckSim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_FirBank fir(imu);
+  static int16_t zero[FIR_TAPS], table[FIR_TAPS];
+  for (int tap = 0; tap < FIR_TAPS; tap++)
+    table[tap] = (int16_t)(tap * 11);
+  sim.stick(FIR_BANK_B, 3, 0x0100);
+  zero[3] = 0x0100; // Cache reads the stuck bit
+  upload(sim, fir, "stuck bit", FIR_BANK_B, table, 2 * PAGE_READ_FRAMES + uploadFrames(zero, table), false);
+  // The cache holds the readback, so the next upload retries the bad tap
+  int16_t readback[FIR_TAPS];
+  memcpy(readback, fir.cached(FIR_BANK_B), sizeof(readback));
+  upload(sim, fir, "stuck bit, retry", FIR_BANK_B, table, uploadFrames(readback, table), false);
+  check("only the stuck tap is retried", fir.stats().changed == 1);
+}
+
+static void assignments() {
+  ADIS16490_Sim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_FirBank fir(imu);
+  printf("\n%-24s %11s %11s\n", "Assignment", "FILTR_BNK_0", "FILTR_BNK_1");
+
+  // 3-bit fields for X/Y/Z gyro and X/Y accel, bank in [1:0] and enable in
+  // bit 2; Z accel alone in FILTR_BNK_1
+  const uint8_t banks[FIR_AXES] = {FIR_BANK_A, FIR_BANK_B, FIR_BANK_C, FIR_BANK_D, FIR_OFF, FIR_BANK_B};
+  const uint16_t bnk0 = 0x4 | (0x5 << 3) | (0x6 << 6) | (0x7 << 9), bnk1 = 0x5;
+  int ok = fir.assign(banks);
+  printf("%-24s      0x%04X      0x%04X\n", "all axes", sim.peek(FILTR_BNK_0), sim.peek(FILTR_BNK_1));
+  check("assign() verified", ok == 1);
+  check("FILTR_BNK_0/1 encoding", sim.peek(FILTR_BNK_0) == bnk0 && sim.peek(FILTR_BNK_1) == bnk1);
+  uint8_t read[FIR_AXES];
+  fir.assignment(read);
+  check("assignment() decodes the same banks", memcmp(read, banks, sizeof(read)) == 0);
+
+  // Single axis changes keep the other fields
+  ok = fir.assign(FIR_Y_ACCL, FIR_BANK_D) && fir.assign(FIR_X_GYRO, FIR_OFF);
+  printf("%-24s      0x%04X      0x%04X\n", "Y accel D, X gyro off", sim.peek(FILTR_BNK_0), sim.peek(FILTR_BNK_1));
+  check("assign(axis, bank) verified", ok == 1);
+  check("only the selected fields changed",
+        sim.peek(FILTR_BNK_0) == ((bnk0 & ~0x7) | (0x7 << 12)) && sim.peek(FILTR_BNK_1) == bnk1);
+  check("out of range axis rejected", fir.assign(FIR_AXES, FIR_BANK_A) == 0);
+}
+
+int main() {
+  uploads();
+  stuckBit();
+  assignments();
+  printf("\n%s\n", failures ? "FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
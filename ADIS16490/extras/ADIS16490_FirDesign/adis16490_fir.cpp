@@ -0,0 +1,325 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_fir.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host-side FIR design library for the ADIS16490 filter banks. See adis16490_fir.h.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "adis16490_fir.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+static double bessel0(double x) {
+  double sum = 1, term = 1;
+  for (int k = 1; k < 50; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+    if (term < sum * 1e-16)
+      break;
+  }
+  return sum;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Windowed-sinc low-pass. The ideal response is truncated symmetrically
+// around (taps - 1) / 2, so even lengths are linear phase too.
+// Returns 1 on success.
+////////////////////////////////////////////////////////////////////////////
+// h - receives taps coefficients (unnormalized)
+// taps - filter length (1 ~ FIR_TAPS)
+// sampleHz - rate the filter runs at
+// cutoffHz - -6 dB frequency
+// window - FIR_WINDOW_HAMMING, FIR_WINDOW_BLACKMAN, or FIR_WINDOW_KAISER
+// beta - Kaiser shape parameter
+////////////////////////////////////////////////////////////////////////////
+int firWindowedSinc(double *h, int taps, double sampleHz, double cutoffHz, int window, double beta) {
+  if (taps < 1 || taps > FIR_TAPS || cutoffHz <= 0 || cutoffHz >= sampleHz / 2)
+    return 0;
+  double fc = cutoffHz / sampleHz;
+  double center = (taps - 1) / 2.0;
+  for (int n = 0; n < taps; n++) {
+    double t = n - center;
+    double ideal = t == 0 ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+    double w = 1;
+    double r = taps > 1 ? (double)n / (taps - 1) : 0.5;
+    if (window == FIR_WINDOW_HAMMING)
+      w = 0.54 - 0.46 * cos(2 * M_PI * r);
+    else if (window == FIR_WINDOW_BLACKMAN)
+      w = 0.42 - 0.5 * cos(2 * M_PI * r) + 0.08 * cos(4 * M_PI * r);
+    else if (window == FIR_WINDOW_KAISER) {
+      double x = 2 * r - 1;
+      w = bessel0(beta * sqrt(1 - x * x)) / bessel0(beta);
+    }
+    h[n] = ideal * w;
+  }
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Weighted least-squares low-pass. The unknowns are the first half of the
+// symmetric impulse response; the squared error of the zero-phase
+// amplitude is summed over a dense grid in both bands and minimized by
+// solving the normal equations.
+// Returns 1 on success.
+////////////////////////////////////////////////////////////////////////////
+// h - receives taps coefficients (unnormalized)
+// taps - filter length (2 ~ FIR_TAPS)
+// sampleHz - rate the filter runs at
+// passHz - passband edge
+// stopHz - stopband edge
+// stopWeight - stopband error weight relative to the passband
+////////////////////////////////////////////////////////////////////////////
+int firLeastSquares(double *h, int taps, double sampleHz, double passHz, double stopHz, double stopWeight) {
+  if (taps < 2 || taps > FIR_TAPS || passHz <= 0 || stopHz <= passHz || stopHz >= sampleHz / 2)
+    return 0;
+  const int unknowns = (taps + 1) / 2;
+  const double center = (taps - 1) / 2.0;
+  double g[FIR_TAPS / 2 + 1][FIR_TAPS / 2 + 2]; // Normal equations, right-hand side last
+  memset(g, 0, sizeof(g));
+
+  const int grid = 32 * taps;
+  double basis[FIR_TAPS / 2 + 1];
+  for (int i = 0; i <= grid; i++) {
+    double f = 0.5 * i / grid; // Cycles per sample
+    double weight, desired;
+    if (f <= passHz / sampleHz) {
+      weight = 1;
+      desired = 1;
+    }
+    else if (f >= stopHz / sampleHz) {
+      weight = stopWeight;
+      desired = 0;
+    }
+    else
+      continue;
+    double w = 2 * M_PI * f;
+    for (int j = 0; j < unknowns; j++)
+      basis[j] = (j == center) ? 1 : 2 * cos(w * (center - j));
+    for (int j = 0; j < unknowns; j++) {
+      for (int k = 0; k < unknowns; k++)
+        g[j][k] += weight * basis[j] * basis[k];
+      g[j][unknowns] += weight * desired * basis[j];
+    }
+  }
+
+  // Gaussian elimination with partial pivoting
+  for (int col = 0; col < unknowns; col++) {
+    int pivot = col;
+    for (int row = col + 1; row < unknowns; row++)
+      if (fabs(g[row][col]) > fabs(g[pivot][col]))
+        pivot = row;
+    if (fabs(g[pivot][col]) < 1e-12)
+      return 0;
+    for (int k = 0; k <= unknowns; k++) {
+      double t = g[col][k];
+      g[col][k] = g[pivot][k];
+      g[pivot][k] = t;
+    }
+    for (int row = col + 1; row < unknowns; row++) {
+      double factor = g[row][col] / g[col][col];
+      for (int k = col; k <= unknowns; k++)
+        g[row][k] -= factor * g[col][k];
+    }
+  }
+  for (int row = unknowns - 1; row >= 0; row--) {
+    double sum = g[row][unknowns];
+    for (int k = row + 1; k < unknowns; k++)
+      sum -= g[row][k] * h[k];
+    h[row] = sum / g[row][row];
+  }
+  for (int n = unknowns; n < taps; n++)
+    h[n] = h[taps - 1 - n];
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Rounds to device coefficients with the sum forced to FIR_COEF_SCALE.
+// The residual is removed one LSB at a time from the taps whose rounding
+// moved furthest against it, in mirrored pairs while at least two LSBs
+// remain, so the error added is the smallest possible and symmetry is kept
+// wherever the residual allows.
+// Returns 1 if every coefficient fits in 16 bits.
+////////////////////////////////////////////////////////////////////////////
+// h - taps coefficients
+// taps - filter length (1 ~ FIR_TAPS)
+// coeffs - receives FIR_TAPS device coefficients
+// report - optional quantizer report
+////////////////////////////////////////////////////////////////////////////
+int firQuantize(const double *h, int taps, int16_t coeffs[FIR_TAPS], ADIS16490_FirQuantization *report) {
+  if (taps < 1 || taps > FIR_TAPS)
+    return 0;
+  double scaled[FIR_TAPS];
+  int32_t q[FIR_TAPS];
+  bool used[FIR_TAPS];
+  double sum = 0;
+  for (int n = 0; n < taps; n++)
+    sum += h[n];
+  int32_t total = 0;
+  for (int n = 0; n < FIR_TAPS; n++) {
+    scaled[n] = n < taps ? h[n] * FIR_COEF_SCALE / sum : 0;
+    q[n] = (int32_t)lround(scaled[n]);
+    total += q[n];
+    used[n] = n >= taps;
+  }
+
+  int adjusted = 0;
+  int32_t residual = FIR_COEF_SCALE - total;
+  while (residual != 0) {
+    int step = residual > 0 ? 1 : -1;
+    bool pair = residual * step >= 2;
+    int best = -1;
+    double bestGap = -1e9;
+    for (int n = 0; n < taps; n++) {
+      int mirror = taps - 1 - n;
+      if (used[n] || (pair && (mirror == n || used[mirror])))
+        continue;
+      double gap = (scaled[n] - q[n]) * step; // How far rounding moved against the residual
+      if (gap > bestGap) {
+        bestGap = gap;
+        best = n;
+      }
+    }
+    if (best < 0) {
+      // No candidate left for this pass; allow reuse
+      for (int n = 0; n < taps; n++)
+        used[n] = false;
+      continue;
+    }
+    int mirror = taps - 1 - best;
+    q[best] += step;
+    used[best] = true;
+    residual -= step;
+    adjusted++;
+    if (pair) {
+      q[mirror] += step;
+      used[mirror] = true;
+      residual -= step;
+      adjusted++;
+    }
+  }
+
+  int clipped = 0;
+  int16_t peak = 0;
+  double maxError = 0;
+  int32_t final = 0;
+  for (int n = 0; n < FIR_TAPS; n++) {
+    if (q[n] > 32767 || q[n] < -32768) {
+      q[n] = q[n] > 0 ? 32767 : -32768;
+      clipped++;
+    }
+    coeffs[n] = (int16_t)q[n];
+    final += q[n];
+    int16_t magnitude = (int16_t)(q[n] < 0 ? (q[n] == -32768 ? 32767 : -q[n]) : q[n]);
+    if (magnitude > peak)
+      peak = magnitude;
+    if (fabs(q[n] - scaled[n]) > maxError)
+      maxError = fabs(q[n] - scaled[n]);
+  }
+  if (report) {
+    report->sum = final;
+    report->peak = peak;
+    report->adjusted = adjusted;
+    report->clipped = clipped;
+    report->maxError = maxError;
+  }
+  return clipped == 0;
+}
+
+double firResponse(const double *h, int taps, double sampleHz, double hz) {
+  double re = 0, im = 0, sum = 0;
+  double w = 2 * M_PI * hz / sampleHz;
+  for (int n = 0; n < taps; n++) {
+    re += h[n] * cos(w * n);
+    im -= h[n] * sin(w * n);
+    sum += h[n];
+  }
+  return sqrt(re * re + im * im) / fabs(sum);
+}
+
+double firResponse(const int16_t coeffs[FIR_TAPS], double sampleHz, double hz) {
+  double h[FIR_TAPS];
+  for (int n = 0; n < FIR_TAPS; n++)
+    h[n] = coeffs[n] / (double)FIR_COEF_SCALE;
+  double re = 0, im = 0;
+  double w = 2 * M_PI * hz / sampleHz;
+  for (int n = 0; n < FIR_TAPS; n++) {
+    re += h[n] * cos(w * n);
+    im -= h[n] * sin(w * n);
+  }
+  return sqrt(re * re + im * im);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Writes a table that compiles as is in a sketch (PROGMEM) and that
+// ADIS16490_FirBank::parse() reads as text
+////////////////////////////////////////////////////////////////////////////
+// out - destination
+// coeffs - FIR_TAPS device coefficients
+// name - C identifier
+// comment - lines placed in a comment above the table (may be 0)
+////////////////////////////////////////////////////////////////////////////
+void firWriteTable(FILE *out, const int16_t coeffs[FIR_TAPS], const char *name, const char *comment) {
+  if (comment) {
+    const char *line = comment;
+    while (*line) {
+      const char *end = strchr(line, '\n');
+      int length = end ? (int)(end - line) : (int)strlen(line);
+      fprintf(out, "// %.*s\n", length, line);
+      line += length + (end ? 1 : 0);
+    }
+  }
+  fprintf(out, "const int16_t %s[FIR_TAPS] PROGMEM = {\n", name);
+  for (int n = 0; n < FIR_TAPS; n++)
+    fprintf(out, "%s%6d%s", n % 10 == 0 ? "  " : "", coeffs[n], n == FIR_TAPS - 1 ? "\n" : (n % 10 == 9 ? ",\n" : ", "));
+  fprintf(out, "};\n");
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////
+// coeffs - FIR_TAPS device coefficients
+////////////////////////////////////////////////////////////////////////////
+ADIS16490_FirFilter::ADIS16490_FirFilter(const int16_t coeffs[FIR_TAPS]) {
+  memcpy(_coeffs, coeffs, sizeof(_coeffs));
+  prime(0);
+}
+
+void ADIS16490_FirFilter::prime(int32_t x) {
+  for (int n = 0; n < FIR_TAPS; n++)
+    _history[n] = x;
+  _head = 0;
+}
+
+int32_t ADIS16490_FirFilter::step(int32_t x) {
+  _history[_head] = x;
+  int64_t acc = 0;
+  int index = _head;
+  for (int k = 0; k < FIR_TAPS; k++) {
+    acc += (int64_t)_coeffs[k] * _history[index];
+    index = index ? index - 1 : FIR_TAPS - 1;
+  }
+  _head = _head == FIR_TAPS - 1 ? 0 : _head + 1;
+  return (int32_t)((acc + FIR_COEF_SCALE / 2) >> 15);
+}
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_fir.h
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host-side FIR design library for the ADIS16490 filter banks. Filters are designed in double
+//  precision as linear-phase (symmetric) low-pass filters, either by the windowed-sinc method or by
+//  weighted least squares over a passband and a stopband, then quantized to the device format:
+//  16-bit coefficients where the bank output is sum(c[k] x[n - k]) / 32768. Quantization normalizes
+//  the DC gain to exactly 32768 by nudging the taps with the largest rounding error, in symmetric
+//  pairs where possible, so a filtered signal keeps its bias.
+//
+//  The response of the double and quantized filters can be evaluated at any frequency, and
+//  ADIS16490_FirFilter runs the quantized filter in the same fixed-point arithmetic to simulate it
+//  on recorded samples. Tables are written as C initializers for ADIS16490_FirBank::upload() or
+//  parse(). Used by adis16490_fir_design.cpp.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef adis16490_fir_h
+#define adis16490_fir_h
+#include "ADIS16490.h"
+#include <stdio.h>
+
+// Window shapes for firWindowedSinc()
+#define FIR_WINDOW_HAMMING  0
+#define FIR_WINDOW_BLACKMAN 1
+#define FIR_WINDOW_KAISER   2
+
+// Coefficient sum for unity DC gain
+#define FIR_COEF_SCALE 32768
+
+// Quantizer report
+struct ADIS16490_FirQuantization {
+  int32_t sum;        // Sum of the quantized coefficients
+  int16_t peak;       // Largest coefficient magnitude
+  int adjusted;       // Taps nudged to normalize the gain
+  int clipped;        // Taps that did not fit in 16 bits
+  double maxError;    // Largest |quantized - ideal| (LSB)
+};
+
+// Windowed-sinc low-pass with the -6 dB point at cutoffHz. beta is the
+// Kaiser shape parameter. Returns 1 on success.
+int firWindowedSinc(double *h, int taps, double sampleHz, double cutoffHz, int window, double beta);
+
+// Least-squares low-pass: unity gain up to passHz, zero from stopHz to
+// Nyquist with stopWeight relative to the passband, transition band free.
+// Returns 1 on success, 0 if the band edges are invalid or the system is
+// singular.
+int firLeastSquares(double *h, int taps, double sampleHz, double passHz, double stopHz, double stopWeight);
+
+// Scales h to unity DC gain and rounds it to FIR_TAPS device coefficients
+// (zero padded after taps). Returns 1 if nothing was clipped.
+int firQuantize(const double *h, int taps, int16_t coeffs[FIR_TAPS], ADIS16490_FirQuantization *report);
+
+// Magnitude response at hz, relative to unity DC gain
+double firResponse(const double *h, int taps, double sampleHz, double hz);
+double firResponse(const int16_t coeffs[FIR_TAPS], double sampleHz, double hz);
+
+// Writes coeffs as a PROGMEM C table with a comment block
+void firWriteTable(FILE *out, const int16_t coeffs[FIR_TAPS], const char *name, const char *comment);
+
+// Fixed-point model of a device filter bank
+class ADIS16490_FirFilter {
+
+public:
+  ADIS16490_FirFilter(const int16_t coeffs[FIR_TAPS]);
+
+  // Fills the history with x, as if the input had been constant
+  void prime(int32_t x);
+
+  // Filters one sample: round(sum(c[k] x[n - k]) / 32768)
+  int32_t step(int32_t x);
+
+private:
+  int16_t _coeffs[FIR_TAPS];
+  int32_t _history[FIR_TAPS];
+  int _head;
+
+};
+
+#endif
@@ -0,0 +1,335 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_fir_design.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Linux host tool that designs a low-pass FIR filter for an ADIS16490 filter bank, quantizes it to
+//  the device format, and writes it as a C table for ADIS16490_FirBank::upload() (or as text for
+//  parse()). A summary of the ideal and quantized response is printed on stderr: DC gain, -3 dB
+//  frequency, passband ripple, stopband attenuation, group delay, and the quantizer report.
+//
+//  With -f the quantized filter is run in fixed point on a recorded CSV log (adis16490_decode
+//  output). The banks filter the internal 4250 Hz samples before decimation, so the log should be
+//  recorded with DEC_RATE = 0. The per-axis RMS of the log with its mean removed is reported before
+//  and after filtering, and -F writes the filtered log.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_fir_design adis16490_fir_design.cpp adis16490_fir.cpp
+//
+//  Usage:
+//
+//    adis16490_fir_design [options] > table.h
+//    -m sinc|ls     windowed sinc (default) or least squares
+//    -r hz          sample rate (4250)
+//    -c hz          sinc: nominal -6 dB cutoff
+//    -p hz          passband edge; ls: required, sinc: ripple is measured up to it (cutoff / 2)
+//    -s hz          stopband edge; ls: required, sinc: attenuation is measured above it (cutoff * 2)
+//    -t taps        filter length, 1 ~ 120 (120); shorter filters are zero padded
+//    -w window      sinc window: hamming, blackman, or kaiser (kaiser)
+//    -b beta        Kaiser beta (8)
+//    -W weight      ls stopband weight (100)
+//    -n name        table name (firLowpass)
+//    -R file        write the response as CSV (Hz, ideal dB, quantized dB)
+//    -f file        filter a recorded CSV log
+//    -F file        write the filtered log
+//
+//  Example, 50 Hz vibration rejection:
+//
+//    adis16490_fir_design -c 50 -n firLowpass50 > fir_lowpass_50.h
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "adis16490_fir.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Columns filtered in a recorded log
+static const char *axisNames[6] = {"gx", "gy", "gz", "ax", "ay", "az"};
+
+static double decibels(double magnitude) {
+  return 20 * log10(magnitude > 1e-12 ? magnitude : 1e-12);
+}
+
+// Largest deviation from 0 dB below passHz, smallest attenuation above
+// stopHz, and the first -3 dB crossing (negative if there is none)
+struct Response {
+  double ripple;
+  double attenuation;
+  double corner;
+};
+
+static Response measure(const double *h, int taps, const int16_t *coeffs, double rate, double passHz, double stopHz) {
+  Response r = {0, -1, -1};
+  const int points = 20000;
+  for (int i = 0; i <= points; i++) {
+    double f = rate / 2 * i / points;
+    double db = decibels(h ? firResponse(h, taps, rate, f) : firResponse(coeffs, rate, f));
+    if (f <= passHz && fabs(db) > r.ripple)
+      r.ripple = fabs(db);
+    if (f >= stopHz && (r.attenuation < 0 || -db < r.attenuation))
+      r.attenuation = -db;
+    if (r.corner < 0 && db < -3.0103)
+      r.corner = f;
+  }
+  return r;
+}
+
+// Formats a figure, or "-" if it was not measured
+static const char *figure(char *text, size_t size, double value, int decimals) {
+  if (value < 0)
+    snprintf(text, size, "-");
+  else
+    snprintf(text, size, "%.*f", decimals, value);
+  return text;
+}
+
+// Splits one CSV line in place. Returns the number of fields.
+static int split(char *line, char **fields, int max) {
+  int count = 0;
+  char *p = line;
+  while (count < max) {
+    fields[count++] = p;
+    p = strchr(p, ',');
+    if (!p)
+      break;
+    *p++ = 0;
+  }
+  for (int i = 0; i < count; i++)
+    fields[i][strcspn(fields[i], "\r\n")] = 0;
+  return count;
+}
+
+// Filters the gyro and accel columns of a log. Returns 0 on success.
+static int filterLog(const char *path, const char *outPath, const int16_t *coeffs, double rate) {
+  FILE *in = fopen(path, "r");
+  if (!in) {
+    perror(path);
+    return 1;
+  }
+  FILE *out = 0;
+  if (outPath && !(out = fopen(outPath, "w"))) {
+    perror(outPath);
+    fclose(in);
+    return 1;
+  }
+
+  char line[1024], copy[1024];
+  char *fields[32];
+  int column[6], timeColumn = -1;
+  if (!fgets(line, sizeof(line), in)) {
+    fprintf(stderr, "%s: empty\n", path);
+    fclose(in);
+    if (out)
+      fclose(out);
+    return 1;
+  }
+  if (out)
+    fputs(line, out);
+  int count = split(line, fields, 32);
+  for (int a = 0; a < 6; a++) {
+    column[a] = -1;
+    for (int i = 0; i < count; i++)
+      if (!strcmp(fields[i], axisNames[a]))
+        column[a] = i;
+    if (column[a] < 0) {
+      fprintf(stderr, "%s: no %s column\n", path, axisNames[a]);
+      fclose(in);
+      if (out)
+        fclose(out);
+      return 1;
+    }
+  }
+  for (int i = 0; i < count; i++)
+    if (!strcmp(fields[i], "timestamp"))
+      timeColumn = i;
+
+  // Running sums for the mean-removed RMS before and after
+  ADIS16490_FirFilter *filters[6];
+  double sum[2][6] = {{0}}, squares[2][6] = {{0}};
+  for (int a = 0; a < 6; a++)
+    filters[a] = new ADIS16490_FirFilter(coeffs);
+  unsigned long samples = 0;
+  uint32_t firstTime = 0, lastTime = 0;
+  while (fgets(line, sizeof(line), in)) {
+    strcpy(copy, line);
+    int n = split(copy, fields, 32);
+    if (n < count)
+      continue;
+    int32_t outputs[6];
+    for (int a = 0; a < 6; a++) {
+      int32_t x = atoi(fields[column[a]]);
+      if (samples == 0)
+        filters[a]->prime(x);
+      outputs[a] = filters[a]->step(x);
+      sum[0][a] += x;
+      squares[0][a] += (double)x * x;
+      sum[1][a] += outputs[a];
+      squares[1][a] += (double)outputs[a] * outputs[a];
+    }
+    if (timeColumn >= 0) {
+      lastTime = (uint32_t)strtoul(fields[timeColumn], 0, 10);
+      if (samples == 0)
+        firstTime = lastTime;
+    }
+    samples++;
+    if (out) {
+      for (int i = 0; i < n; i++) {
+        int a = 0;
+        while (a < 6 && column[a] != i)
+          a++;
+        if (a < 6)
+          fprintf(out, "%s%d", i ? "," : "", (int)outputs[a]);
+        else
+          fprintf(out, "%s%s", i ? "," : "", fields[i]);
+      }
+      fputc('\n', out);
+    }
+  }
+  fclose(in);
+  if (out)
+    fclose(out);
+
+  fprintf(stderr, "\n%s: %lu samples", path, samples);
+  if (timeColumn >= 0 && samples > 1) {
+    double logRate = (samples - 1) / ((uint32_t)(lastTime - firstTime) * 1e-6);
+    fprintf(stderr, ", %.1f samples/s", logRate);
+    if (fabs(logRate - rate) > 0.05 * rate)
+      fprintf(stderr, " (design rate %.1f; the banks run before decimation, record with DEC_RATE = 0)", rate);
+  }
+  fprintf(stderr, "\n  axis   RMS before   RMS after   change (LSB, mean removed)\n");
+  for (int a = 0; a < 6; a++) {
+    double rms[2];
+    for (int k = 0; k < 2; k++) {
+      double mean = samples ? sum[k][a] / samples : 0;
+      double variance = samples ? squares[k][a] / samples - mean * mean : 0;
+      rms[k] = sqrt(variance > 0 ? variance : 0);
+    }
+    fprintf(stderr, "  %-4s %11.2f %11.2f %8.1f dB\n", axisNames[a], rms[0], rms[1],
+            rms[0] > 0 ? decibels(rms[1] / rms[0]) : 0.0);
+    delete filters[a];
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  bool leastSquares = false;
+  double rate = 4250, cutoff = 0, pass = 0, stop = 0, beta = 8, weight = 100;
+  int taps = FIR_TAPS, window = FIR_WINDOW_KAISER;
+  const char *name = "firLowpass", *responsePath = 0, *logPath = 0, *filteredPath = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "m:r:c:p:s:t:w:b:W:n:R:f:F:")) != -1) {
+    switch (opt) {
+    case 'm': leastSquares = !strcmp(optarg, "ls"); break;
+    case 'r': rate = atof(optarg); break;
+    case 'c': cutoff = atof(optarg); break;
+    case 'p': pass = atof(optarg); break;
+    case 's': stop = atof(optarg); break;
+    case 't': taps = atoi(optarg); break;
+    case 'w':
+      window = !strcmp(optarg, "hamming") ? FIR_WINDOW_HAMMING : !strcmp(optarg, "blackman") ? FIR_WINDOW_BLACKMAN : FIR_WINDOW_KAISER;
+      break;
+    case 'b': beta = atof(optarg); break;
+    case 'W': weight = atof(optarg); break;
+    case 'n': name = optarg; break;
+    case 'R': responsePath = optarg; break;
+    case 'f': logPath = optarg; break;
+    case 'F': filteredPath = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-m sinc|ls] [-r hz] [-c hz] [-p hz] [-s hz] [-t taps] [-w window] [-b beta] "
+                      "[-W weight] [-n name] [-R file] [-f log [-F file]]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  double h[FIR_TAPS];
+  char description[256];
+  int ok;
+  if (leastSquares) {
+    ok = firLeastSquares(h, taps, rate, pass, stop, weight);
+    snprintf(description, sizeof(description), "least squares, %d taps, %.1f Hz, pass %.1f Hz, stop %.1f Hz, weight %.0f",
+             taps, rate, pass, stop, weight);
+  }
+  else {
+    static const char *windows[] = {"Hamming", "Blackman", "Kaiser"};
+    ok = firWindowedSinc(h, taps, rate, cutoff, window, beta);
+    if (pass <= 0)
+      pass = cutoff / 2;
+    if (stop <= 0)
+      stop = cutoff * 2;
+    int length = snprintf(description, sizeof(description), "windowed sinc (%s", windows[window]);
+    if (window == FIR_WINDOW_KAISER)
+      length += snprintf(description + length, sizeof(description) - length, ", beta %.1f", beta);
+    snprintf(description + length, sizeof(description) - length, "), %d taps, %.1f Hz, cutoff %.1f Hz", taps, rate, cutoff);
+  }
+  if (!ok) {
+    fprintf(stderr, "design failed: check the band edges (0 < pass < stop < rate / 2) and taps (1 ~ %d)\n", FIR_TAPS);
+    return 1;
+  }
+
+  int16_t coeffs[FIR_TAPS];
+  ADIS16490_FirQuantization q;
+  if (!firQuantize(h, taps, coeffs, &q))
+    fprintf(stderr, "warning: %d coefficients clipped to 16 bits\n", q.clipped);
+
+  Response ideal = measure(h, taps, 0, rate, pass, stop);
+  Response quantized = measure(0, taps, coeffs, rate, pass, stop);
+  fprintf(stderr, "%s\n", description);
+  fprintf(stderr, "              DC gain   -3 dB (Hz)   ripple <%.0f Hz (dB)   attenuation >%.0f Hz (dB)\n", pass, stop);
+  const Response *rows[2] = {&ideal, &quantized};
+  for (int i = 0; i < 2; i++) {
+    char corner[16], attenuation[16];
+    fprintf(stderr, "  %-9s  %8.5f   %10s   %20.4f   %24s\n", i ? "quantized" : "ideal",
+            i ? firResponse(coeffs, rate, 0) : firResponse(h, taps, rate, 0),
+            figure(corner, sizeof(corner), rows[i]->corner, 2), rows[i]->ripple,
+            figure(attenuation, sizeof(attenuation), rows[i]->attenuation, 1));
+  }
+  fprintf(stderr, "  group delay %.1f samples (%.2f ms); sum %d, peak %d, %d taps adjusted, max rounding error %.2f LSB\n",
+          (taps - 1) / 2.0, (taps - 1) / 2.0 / rate * 1000, (int)q.sum, q.peak, q.adjusted, q.maxError);
+
+  char comment[512], corner[16], attenuation[16];
+  snprintf(comment, sizeof(comment), "ADIS16490 FIR bank table: %s\n"
+           "-3 dB at %s Hz, %s dB above %.0f Hz, group delay %.1f samples; sum %d (unity DC gain)\n"
+           "Load with ADIS16490_FirBank::upload(bank, %s, true)",
+           description, figure(corner, sizeof(corner), quantized.corner, 2),
+           figure(attenuation, sizeof(attenuation), quantized.attenuation, 1), stop, (taps - 1) / 2.0, (int)q.sum, name);
+  firWriteTable(stdout, coeffs, name, comment);
+
+  if (responsePath) {
+    FILE *out = fopen(responsePath, "w");
+    if (!out) {
+      perror(responsePath);
+      return 1;
+    }
+    fprintf(out, "hz,ideal_db,quantized_db\n");
+    for (int i = 0; i <= 2000; i++) {
+      double f = rate / 2 * i / 2000;
+      fprintf(out, "%.3f,%.3f,%.3f\n", f, decibels(firResponse(h, taps, rate, f)), decibels(firResponse(coeffs, rate, f)));
+    }
+    fclose(out);
+  }
+
+  if (logPath)
+    return filterLog(logPath, filteredPath, coeffs, rate);
+  return 0;
+}
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_scaling_bench.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host benchmark and check of the batch scalers. A block of random ADIS16490_Sample records is
+//  scaled to gyro, accel, and temperature floats (7 channels) three ways: the per-call
+//  gyroScale()/accelScale()/tempScale() functions, scaleSamples() into ADIS16490_Scaled records
+//  (AoS), and scaleSamples() into separate channel arrays (SoA). The per-channel array overloads,
+//  including the delta angle and delta velocity scalers, are checked the same way.
+//
+//  Each path is timed over REPEATS passes and reported in ns per sample. Every batch result must be
+//  bit-identical to the per-call functions, for the ADIS16490 driver and for
+//  ADIS1649x<ADIS16497_2_Model>; the tool exits non-zero if any float differs. Build with the same
+//  floating point flags as the target (e.g. no -ffast-math), since contraction into fused multiply-
+//  adds can differ between the loops.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_scaling_bench adis16490_scaling_bench.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS1649x.h"
+#include "ADIS16490_Sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Samples per block and timed passes over it
+#define BLOCK   4096
+#define REPEATS 200
+
+static ADIS16490_Sample samples[BLOCK];
+static ADIS16490_Scaled aos[BLOCK];
+static float perCall[7][BLOCK];
+static float soa[7][BLOCK];
+static int16_t raw[BLOCK];
+static float single[BLOCK], array[BLOCK];
+
+static int failures = 0;
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void check(const char *name, bool pass) {
+  if (!pass)
+    failures++;
+  printf("  %-44s %s\n", name, pass ? "bit-identical" : "DIFFERS");
+}
+
+// AoS records against the per-call channels
+static bool sameAsPerCall(const ADIS16490_Scaled *scaled) {
+  for (int i = 0; i < BLOCK; i++) {
+    for (int axis = 0; axis < 3; axis++)
+      if (memcmp(&scaled[i].gyro[axis], &perCall[axis][i], sizeof(float)) ||
+          memcmp(&scaled[i].accel[axis], &perCall[axis + 3][i], sizeof(float)))
+        return false;
+    if (memcmp(&scaled[i].temp, &perCall[6][i], sizeof(float)))
+      return false;
+  }
+  return true;
+}
+
+// Times and checks the per-call, AoS, and SoA paths of one driver type
+template <class Driver>
+static void run(const char *name, Driver &imu) {
+  ADIS16490_ScaledBlock block = {{soa[0], soa[1], soa[2]}, {soa[3], soa[4], soa[5]}, soa[6]};
+
+  double start = now();
+  for (int r = 0; r < REPEATS; r++)
+    for (int i = 0; i < BLOCK; i++) {
+      for (int axis = 0; axis < 3; axis++) {
+        perCall[axis][i] = imu.gyroScale(samples[i].gyro[axis]);
+        perCall[axis + 3][i] = imu.accelScale(samples[i].accel[axis]);
+      }
+      perCall[6][i] = imu.tempScale(samples[i].temp);
+    }
+  double perCallNs = (now() - start) * 1e9 / REPEATS / BLOCK;
+
+  start = now();
+  for (int r = 0; r < REPEATS; r++)
+    imu.scaleSamples(samples, aos, BLOCK);
+  double aosNs = (now() - start) * 1e9 / REPEATS / BLOCK;
+
+  start = now();
+  for (int r = 0; r < REPEATS; r++)
+    imu.scaleSamples(samples, block, BLOCK);
+  double soaNs = (now() - start) * 1e9 / REPEATS / BLOCK;
+
+  printf("%s, %d samples, 7 channels: per-call %.2f ns/sample, AoS %.2f ns/sample, SoA %.2f ns/sample\n",
+         name, BLOCK, perCallNs, aosNs, soaNs);
+  check("scaleSamples() AoS", sameAsPerCall(aos));
+  check("scaleSamples() SoA", memcmp(soa, perCall, sizeof(soa)) == 0);
+
+  // Channel array overloads against the single-value functions
+  for (int i = 0; i < BLOCK; i++)
+    raw[i] = samples[i].gyro[i % 3];
+  bool same = true;
+  for (int i = 0; i < BLOCK; i++)
+    single[i] = imu.gyroScale(raw[i]);
+  imu.gyroScale(raw, array, BLOCK);
+  same = same && memcmp(single, array, sizeof(single)) == 0;
+  for (int i = 0; i < BLOCK; i++)
+    single[i] = imu.accelScale(raw[i]);
+  imu.accelScale(raw, array, BLOCK);
+  same = same && memcmp(single, array, sizeof(single)) == 0;
+  for (int i = 0; i < BLOCK; i++)
+    single[i] = imu.tempScale(raw[i]);
+  imu.tempScale(raw, array, BLOCK);
+  same = same && memcmp(single, array, sizeof(single)) == 0;
+  for (int i = 0; i < BLOCK; i++)
+    single[i] = imu.deltaAngleScale(raw[i]);
+  imu.deltaAngleScale(raw, array, BLOCK);
+  same = same && memcmp(single, array, sizeof(single)) == 0;
+  for (int i = 0; i < BLOCK; i++)
+    single[i] = imu.deltaVelocityScale(raw[i]);
+  imu.deltaVelocityScale(raw, array, BLOCK);
+  same = same && memcmp(single, array, sizeof(single)) == 0;
+  check("channel array overloads", same);
+}
+
+int main() {
+  // Full-range words so every exponent the scalers produce is covered
+  srand(1);
+  for (int i = 0; i < BLOCK; i++) {
+    samples[i].timestamp = i;
+    for (int axis = 0; axis < 3; axis++) {
+      samples[i].gyro[axis] = (int16_t)(rand() & 0xFFFF);
+      samples[i].accel[axis] = (int16_t)(rand() & 0xFFFF);
+    }
+    samples[i].temp = (int16_t)(rand() & 0xFFFF);
+  }
+
+  ADIS16490_Sim sim;
+  ADIS16490 imu(sim);
+  run("ADIS16490", imu);
+  ADIS1649x<ADIS16497_2_Model> model(sim);
+  run("ADIS1649x<ADIS16497_2_Model>", model);
+
+  printf("\n%s\n", failures ? "FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,276 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_strapdown_replay.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host test harness for ADIS16490_Strapdown. Synthetic motion profiles are defined by body angular
+//  rate and specific force. They are integrated at 64 substeps per output period to produce the
+//  sensor's delta outputs, quantized to the 32-bit DELTANG/DELTVEL LSBs, and replayed through the
+//  integrator at 2125 Hz (DEC_RATE = 1, the fastest rate deltaRead() can follow). A double-
+//  precision integrator running at the substep rate is the truth reference.
+//
+//  For each profile the harness reports final attitude, velocity, and position errors with
+//  coning/sculling compensation on and off, plus the cost of one update.
+//
+//  It then runs deltaRead() against ADIS16490_Sim, whose delta registers hold the output count in
+//  every word, at DEC_RATE 0 and 1 and two SCLK rates. Reads start on data ready. It reports how
+//  many reads come from one output and exits non-zero if a read returns 1 with mixed words, or if
+//  any read at DEC_RATE 1 is torn.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_strapdown_replay adis16490_strapdown_replay.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Strapdown.h"
+#include "ADIS16490_Sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#define RATE     2125.0
+#define SUBSTEPS 64
+
+// Body angular rate (rad/sec) and specific force (m/sec^2) at time t
+typedef void (*Profile)(double t, double *rate, double *force);
+
+// Level and still: the accelerometer reads -g on the down axis
+static void stationary(double, double *w, double *f) {
+  w[0] = w[1] = w[2] = 0;
+  f[0] = f[1] = 0;
+  f[2] = -STRAPDOWN_GRAVITY;
+}
+
+// 30 deg/sec yaw while level
+static void yawSpin(double, double *w, double *f) {
+  w[0] = w[1] = 0;
+  w[2] = 30 * M_PI / 180;
+  f[0] = f[1] = 0;
+  f[2] = -STRAPDOWN_GRAVITY;
+}
+
+// Coning: 90 degree out of phase oscillation about X and Y at 100 Hz
+static void coning(double t, double *w, double *f) {
+  double a = 2 * M_PI * 100 * t;
+  w[0] = 0.5 * cos(a);
+  w[1] = 0.5 * sin(a);
+  w[2] = 0;
+  f[0] = f[1] = f[2] = 0;
+}
+
+// Sculling: oscillation about X and along Y at 100 Hz, 90 degrees apart
+static void sculling(double t, double *w, double *f) {
+  double a = 2 * M_PI * 100 * t;
+  w[0] = 1.0 * cos(a);
+  w[1] = w[2] = 0;
+  f[0] = 0;
+  f[1] = 20.0 * sin(a);
+  f[2] = 0;
+}
+
+// Double-precision truth integrator, one substep at a time
+struct Reference {
+  double q[4], v[3], p[3];
+
+  void reset() {
+    q[0] = 1;
+    q[1] = q[2] = q[3] = 0;
+    v[0] = v[1] = v[2] = p[0] = p[1] = p[2] = 0;
+  }
+
+  void step(const double *w, const double *f, double dt, double gravity) {
+    // Specific force rotated by the midpoint attitude
+    double half[4];
+    rotate(w, dt * 0.5, half);
+    double r[3] = {half[1], half[2], half[3]}, t0[3], t1[3];
+    cross(r, f, t0);
+    cross(r, t0, t1);
+    double vPrev[3] = {v[0], v[1], v[2]};
+    for (int i = 0; i < 3; i++)
+      v[i] += (f[i] + 2 * (half[0] * t0[i] + t1[i])) * dt;
+    v[2] += gravity * dt;
+    for (int i = 0; i < 3; i++)
+      p[i] += 0.5 * (vPrev[i] + v[i]) * dt;
+    rotate(w, dt, q);
+  }
+
+  // out = q * exp(w * dt / 2)
+  void rotate(const double *w, double dt, double *out) const {
+    double phi = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]) * dt;
+    double c = cos(phi / 2), s = phi > 0 ? sin(phi / 2) / phi * dt : dt / 2;
+    double d[4] = {c, w[0] * s, w[1] * s, w[2] * s};
+    double r[4] = {
+      q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3],
+      q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2],
+      q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1],
+      q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0] };
+    for (int i = 0; i < 4; i++)
+      out[i] = r[i];
+  }
+
+  static void cross(const double *a, const double *b, double *out) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+  }
+};
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Angle between two attitudes (deg), from the vector part of conj(a) * b
+static double attitudeError(const double *a, const float *b) {
+  double x = a[0] * b[1] - a[1] * b[0] - a[2] * b[3] + a[3] * b[2];
+  double y = a[0] * b[2] + a[1] * b[3] - a[2] * b[0] - a[3] * b[1];
+  double z = a[0] * b[3] - a[1] * b[2] + a[2] * b[1] - a[3] * b[0];
+  double s = sqrt(x * x + y * y + z * z);
+  return 2 * asin(s > 1 ? 1 : s) * 180 / M_PI;
+}
+
+static double distance(const double *a, const float *b) {
+  double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+  return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+// Replays seconds of a profile with and without compensation
+static void run(const char *name, Profile profile, double seconds, float gravity) {
+  ADIS16490_Strapdown on, off;
+  on.setGravity(gravity);
+  off.setGravity(gravity);
+  off.setCompensation(false);
+  Reference truth;
+  truth.reset();
+
+  const double dt = 1.0 / RATE, h = dt / SUBSTEPS;
+  const double angleLsb = DELTANG_LSB / 65536.0 * M_PI / 180, velocityLsb = DELTVEL_LSB / 65536.0 * 0.001;
+  long updates = (long)(seconds * RATE);
+  double angleRemainder[3] = {0}, velocityRemainder[3] = {0};
+  double busy = 0;
+
+  for (long k = 0; k < updates; k++) {
+    // Sensor integration over one output period
+    double dAngle[3] = {0}, dVelocity[3] = {0}, w[3], f[3];
+    for (int s = 0; s < SUBSTEPS; s++) {
+      profile((k * SUBSTEPS + s + 0.5) * h, w, f);
+      truth.step(w, f, h, gravity);
+      for (int i = 0; i < 3; i++) {
+        dAngle[i] += w[i] * h;
+        dVelocity[i] += f[i] * h;
+      }
+    }
+
+    // Quantize to the 32-bit output LSBs, carrying the remainder forward as
+    // the sensor's accumulator does
+    ADIS16490_Delta delta;
+    for (int i = 0; i < 3; i++) {
+      double a = dAngle[i] / angleLsb + angleRemainder[i];
+      double v = dVelocity[i] / velocityLsb + velocityRemainder[i];
+      delta.angle[i] = (int32_t)floor(a + 0.5);
+      delta.velocity[i] = (int32_t)floor(v + 0.5);
+      angleRemainder[i] = a - delta.angle[i];
+      velocityRemainder[i] = v - delta.velocity[i];
+    }
+
+    double start = now();
+    on.update(delta, (float)dt);
+    busy += now() - start;
+    off.update(delta, (float)dt);
+  }
+
+  printf("%-10s %3.0f s  attitude %.2e / %.2e deg  velocity %.2e / %.2e m/s  "
+         "position %.2e / %.2e m  %5.1f ns/update\n",
+         name, seconds, attitudeError(truth.q, on.quaternion()), attitudeError(truth.q, off.quaternion()),
+         distance(truth.v, on.velocity()), distance(truth.v, off.velocity()),
+         distance(truth.p, on.position()), distance(truth.p, off.position()), busy * 1e9 / updates);
+}
+
+// Simulator whose delta registers all hold the output count, so words
+// from different outputs disagree
+class CountSim : public ADIS16490_Sim {
+
+protected:
+  void generateSample(uint32_t sampleCount) {
+    for (int i = 0; i < 6; i++) {
+      poke(X_DELTANG_LOW + 4 * i, (uint16_t)sampleCount);
+      poke(X_DELTANG_OUT + 4 * i, (uint16_t)sampleCount);
+    }
+    ADIS16490_Sim::generateSample(sampleCount);
+  }
+
+};
+
+// Reads started on data ready at a DEC_RATE and SCLK rate. Returns the
+// number of torn reads reported as whole.
+static int readCheck(uint16_t decRate, uint32_t clock, int &whole, int reads) {
+  CountSim sim;
+  ADIS16490 imu(sim);
+  ADIS16490_ClockConfig clocks = {clock, clock};
+  imu.setClocks(clocks);
+  imu.regWrite(DEC_RATE, decRate);
+  int undetected = 0;
+  whole = 0;
+  for (int k = 0; k < reads; k++) {
+    while (sim.dataReady())
+      sim.advanceMicros(1);
+    while (!sim.dataReady())
+      sim.advanceMicros(1);
+    ADIS16490_Delta delta;
+    if (!imu.deltaRead(delta))
+      continue;
+    whole++;
+    for (int i = 0; i < 3; i++) {
+      int32_t expected = (int32_t)(((uint32_t)delta.dataCount << 16) | delta.dataCount);
+      if (delta.angle[i] != expected || delta.velocity[i] != expected) {
+        undetected++;
+        break;
+      }
+    }
+  }
+  return undetected;
+}
+
+int main() {
+  printf("errors vs truth, compensated / uncompensated\n");
+  run("stationary", stationary, 60, STRAPDOWN_GRAVITY);
+  run("yaw spin", yawSpin, 60, STRAPDOWN_GRAVITY);
+  run("coning", coning, 60, 0);
+  run("sculling", sculling, 60, 0);
+
+  const int reads = 1000;
+  const uint32_t clocks[] = {2000000, 15000000};
+  int failures = 0;
+  printf("\ndeltaRead() on data ready, whole reads / %d\n", reads);
+  for (uint16_t decRate = 0; decRate < 2; decRate++)
+    for (int c = 0; c < 2; c++) {
+      int whole;
+      int undetected = readCheck(decRate, clocks[c], whole, reads);
+      bool pass = undetected == 0 && (decRate == 0 || whole == reads);
+      if (!pass)
+        failures++;
+      printf("DEC_RATE %u %5.1f MHz  %4d whole  %d undetected%s\n", decRate, clocks[c] / 1e6, whole, undetected,
+             pass ? "" : "  FAIL");
+    }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_sync_sim.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host test of setSync() and ADIS16490_SyncDiscipline. Two simulated units with different
+//  oscillator errors share a 1 Hz reference pulse that also drives their sync inputs. Each unit
+//  runs an interrupt-driven capture, and loop() feeds its samples to a discipline loop.
+//
+//  Scenarios:
+//
+//    internal     internal sample clock; the count drifts against the pulse and the units walk apart
+//    scaled       scaled sync, SYNC_SCALE = 4250; both units lock with zero phase to the pulse
+//    decimated    scaled sync with DEC_RATE = 4 (850 Hz)
+//    lost config  scaled sync; unit A loses FNCTIO_CTRL at 10 s and the loop reapplies it
+//
+//  For each scenario and unit the tool prints the final state, the interval counts, the rate error
+//  against the pulse, and the last phase, followed by the worst phase difference between the units
+//  over the last 5 s. The exit status is non-zero if a scaled scenario ends unlocked or misaligned.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_sync_sim adis16490_sync_sim.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Capture.h"
+#include "ADIS16490_Sim.h"
+#include "ADIS16490_SyncDiscipline.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Simulated run length (sec)
+#define RUN_SECONDS 30
+
+// One simulated sensor with its capture and discipline loop
+struct Unit {
+  ADIS16490_Sim sim;
+  ADIS16490 imu;
+  ADIS16490_Capture capture;
+  ADIS16490_SyncDiscipline discipline;
+
+  Unit(double ppm) : imu(sim), capture(imu), discipline(imu) {
+    sim.setClockError(ppm);
+  }
+
+  static void edge(void *context) {
+    ((Unit *)context)->capture.service();
+  }
+
+  static void pulse(void *context) {
+    Unit *unit = (Unit *)context;
+    unit->discipline.onPulse(unit->sim.microsNow());
+  }
+
+  void start() {
+    capture.begin();
+    sim.attachDataReady(edge, this);
+  }
+
+  void stop() {
+    sim.attachDataReady(0, 0);
+    capture.end();
+  }
+};
+
+static int failures = 0;
+
+static void run(const char *name, uint8_t mode, uint16_t decRate, bool loseConfig) {
+  Unit a(40), b(-25);
+  Unit *units[] = {&a, &b};
+  ADIS16490_SyncConfig config = {mode, 2, true, 4250, 1, true};
+  for (int u = 0; u < 2; u++) {
+    units[u]->imu.regWrite(DEC_RATE, decRate);
+    if (!units[u]->discipline.begin(config))
+      printf("%s: setSync() readback failed\n", name);
+    units[u]->start();
+    units[u]->sim.setSyncInput(1000000, Unit::pulse, units[u]);
+  }
+
+  int32_t worstSkew = 0;
+  for (int ms = 1; ms <= RUN_SECONDS * 1000; ms++) {
+    for (int u = 0; u < 2; u++) {
+      Unit &unit = *units[u];
+      // Bus time spent in the capture handler also advances the clock
+      int32_t step = (int32_t)(ms * 1000u - unit.sim.microsNow());
+      if (step > 0)
+        unit.sim.advanceMicros(step);
+      ADIS16490_Sample sample;
+      while (unit.capture.read(sample))
+        unit.discipline.update(sample);
+      if (unit.discipline.reapplyNeeded()) {
+        unit.stop();
+        unit.discipline.reapply();
+        unit.start();
+      }
+    }
+    if (loseConfig && ms == 10000)
+      a.sim.poke(FNCTIO_CTRL, 0x000D);
+    // Both units have marked the last pulse by now
+    if (ms % 1000 == 10 && ms > (RUN_SECONDS - 5) * 1000) {
+      int32_t skew = a.discipline.stats().phase - b.discipline.stats().phase;
+      skew = skew < 0 ? -skew : skew;
+      worstSkew = skew > worstSkew ? skew : worstSkew;
+    }
+  }
+
+  static const char *states[] = {"acquiring", "locked", "unlocked"};
+  bool ok = true;
+  for (int u = 0; u < 2; u++) {
+    const ADIS16490_SyncStats &s = units[u]->discipline.stats();
+    printf("%-12s unit %c  %-9s  pulses %2u matches %2u misses %2u (phase %2u) reapplied %u  "
+           "expected %6.1f  rate error %+6.1f ppm  phase %+4d us\n",
+           name, 'A' + u, states[units[u]->discipline.state()], (unsigned)s.pulses, (unsigned)s.matches,
+           (unsigned)s.misses, (unsigned)s.outOfPhase, (unsigned)s.reapplied, units[u]->discipline.expected(),
+           units[u]->discipline.rateError(), (int)s.phase);
+    if (mode == SYNC_SCALED && units[u]->discipline.state() != SYNC_LOCKED)
+      ok = false;
+    units[u]->stop();
+  }
+  if (mode == SYNC_SCALED && worstSkew > 1)
+    ok = false;
+  if (!ok)
+    failures++;
+  printf("%-12s worst phase difference over the last 5 s: %d us  %s\n\n", name, (int)worstSkew,
+         mode == SYNC_SCALED ? (ok ? "ok" : "FAIL") : "");
+}
+
+int main() {
+  run("internal", SYNC_INTERNAL, 0, false);
+  run("scaled", SYNC_SCALED, 0, false);
+  run("decimated", SYNC_SCALED, 4, false);
+  run("lost config", SYNC_SCALED, 0, true);
+  return failures ? 1 : 0;
+}
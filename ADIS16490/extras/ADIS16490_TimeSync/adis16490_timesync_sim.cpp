@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_timesync_sim.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host test of ADIS16490_TimeSync against ADIS16490_Sim with a drifting device clock. The capture
+//  ISR runs on every simulated data ready edge, optionally delayed by a random interrupt latency,
+//  and adds a TIME_STAMP correlation point every 16 samples. loop() stamps every sample it drains
+//  and compares the result with the true edge time recorded by the simulator.
+//
+//  For each scenario the tool prints the timestamp error after the first second, as mean +/- RMS
+//  deviation, for three estimates: the raw capture time (ISR entry), the first capture time plus
+//  the output count times the nominal period, and the correlated timestamp. The mean includes the
+//  whole-microsecond truncation of the host clock and any constant interrupt latency; the deviation
+//  is what the fit removes. It also prints the estimated clock error against the truth, the
+//  correlation points added and rejected by sync(), and the cost of update() and stamp().
+//
+//  With 130 us of latency at 2 MHz SCLK the sync() read often lands after the next output. Such
+//  points must be rejected: a point paired with the wrong output shows up as a residual of more
+//  than half a period and is counted as mispaired. The exit status is non-zero if any point is
+//  mispaired or if a correlated timestamp deviates from the mean by more than 5 us (12 us in the
+//  late scenario).
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_timesync_sim adis16490_timesync_sim.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490_Capture.h"
+#include "ADIS16490_Sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Simulated run length (sec) and correlation interval (samples)
+#define RUN_SECONDS 30
+#define SYNC_INTERVAL 16
+
+// Largest allowed correlated timestamp error (us), and the bound with
+// interrupt latency near the output period, where the fit only sees the
+// points read before the next output
+#define LIMIT_US 5.0
+#define LATE_LIMIT_US 12.0
+
+struct Context {
+  ADIS16490_Sim *sim;
+  ADIS16490_Capture *capture;
+  ADIS16490_TimeSync *sync;
+  uint32_t maxLatency;  // Interrupt latency upper bound (us)
+  uint64_t *edges;      // True edge time by DATA_CNT (ns)
+  uint32_t mispaired;   // Points added with another output's DATA_CNT
+};
+
+static void edge(void *context) {
+  Context *c = (Context *)context;
+  c->edges[c->sim->peek(DATA_CNT)] = c->sim->lastEdgeNanos();
+  if (c->maxLatency)
+    c->sim->advanceMicros(rand() % (c->maxLatency + 1));
+  uint32_t updates = c->sync->updates();
+  c->capture->service();
+  // A point paired with the next output lands a whole period off
+  if (updates > 1 && c->sync->updates() != updates && fabsf(c->sync->residual()) > 0.5e6f / 4250)
+    c->mispaired++;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Error accumulator (us): mean, and RMS and worst deviation from it
+struct Error {
+  double sum, sum2, low, high;
+  long count;
+
+  void add(double e) {
+    if (!count || e < low)
+      low = e;
+    if (!count || e > high)
+      high = e;
+    sum += e;
+    sum2 += e * e;
+    count++;
+  }
+  double mean() const { return count ? sum / count : 0; }
+  double rms() const { return count ? sqrt(sum2 / count - mean() * mean()) : 0; }
+  double spread() const { return high - mean() > mean() - low ? high - mean() : mean() - low; }
+};
+
+static int failures = 0;
+
+static void run(const char *name, double ppm, double ppmPerSecond, uint32_t maxLatency, double limit) {
+  static uint64_t edges[65536];
+  ADIS16490_Sim sim;
+  sim.setClockError(ppm, ppmPerSecond);
+  ADIS16490 imu(sim);
+  ADIS16490_Capture capture(imu);
+  ADIS16490_TimeSync sync;
+  capture.begin();
+  capture.setTimeSync(&sync, SYNC_INTERVAL);
+  Context context = {&sim, &capture, &sync, maxLatency, edges, 0};
+  srand(1);
+  sim.attachDataReady(edge, &context);
+
+  Error raw = Error(), nominal = Error(), correlated = Error();
+  bool first = true;
+  uint32_t firstTime = 0, outputs = 0;
+  uint16_t lastCount = 0;
+  double stampTime = 0;
+  long stamps = 0;
+  for (int ms = 0; ms < RUN_SECONDS * 1000; ms++) {
+    sim.advanceMicros(1000);
+    ADIS16490_Sample sample;
+    while (capture.read(sample)) {
+      double truth = edges[sample.dataCount] * 1e-3;
+      if (first) {
+        firstTime = sample.timestamp;
+        lastCount = sample.dataCount;
+        first = false;
+      }
+      outputs += (uint16_t)(sample.dataCount - lastCount);
+      lastCount = sample.dataCount;
+      uint32_t captured = sample.timestamp;
+      double start = now();
+      bool stamped = sync.stamp(sample);
+      stampTime += now() - start;
+      stamps++;
+      if (ms < 1000 || !stamped)
+        continue;
+      raw.add(captured - truth);
+      nominal.add(firstTime + outputs * (1e6 / 4250) - truth);
+      correlated.add(sample.timestamp - truth);
+    }
+  }
+  sim.attachDataReady(0, 0);
+
+  // Cost of one correlation point, replayed on a copy
+  ADIS16490_TimeSync bench;
+  double start = now();
+  for (int i = 0; i < 100000; i++)
+    bench.update((uint16_t)(i * 3765), (uint16_t)(i * 16), (uint32_t)(i * 3765));
+  double updateNs = (now() - start) * 1e9 / 100000;
+
+  bool ok = correlated.spread() <= limit && context.mispaired == 0;
+  if (!ok)
+    failures++;
+  printf("%-24s raw %6.2f +/- %5.2f  nominal %9.1f +/- %7.1f  correlated %6.2f +/- %5.2f (max %5.2f) us  "
+         "drift %7.2f ppm (truth %7.2f)  points %4u rejected %4u mispaired %3u  update %4.1f ns  stamp %4.1f ns  %s\n",
+         name, raw.mean(), raw.rms(), nominal.mean(), nominal.rms(), correlated.mean(), correlated.rms(),
+         correlated.spread(), sync.drift(), -(ppm + ppmPerSecond * RUN_SECONDS), (unsigned)sync.updates(),
+         (unsigned)sync.rejected(), (unsigned)context.mispaired, updateNs,
+         stampTime * 1e9 / stamps, ok ? "ok" : "FAIL");
+}
+
+int main() {
+  run("ideal clock", 0, 0, 0, LIMIT_US);
+  run("+50 ppm", 50, 0, 0, LIMIT_US);
+  run("-80 ppm, +1 ppm/s", -80, 1, 0, LIMIT_US);
+  run("+30 ppm, 10 us latency", 30, 0, 10, LIMIT_US);
+  run("+30 ppm, 130 us latency", 30, 0, 130, LATE_LIMIT_US);
+  return failures ? 1 : 0;
+}
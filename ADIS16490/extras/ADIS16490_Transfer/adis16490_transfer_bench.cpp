@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  adis16490_transfer_bench.cpp
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Host benchmark of the ADIS16490 register and sensor read paths against ADIS16490_Sim. Each call
+//  is repeated ITERATIONS times and the simulator's counters give the SPI frames, bytes, page
+//  switches, and stall violations per call, and its virtual clock the latency per call, i.e. the
+//  cost of one sample on the bus. Calls covered: regRead() on one page and alternating between
+//  pages 0 and 3, regWrite(), sensorRead(), burstRead(), highResRead(), deltaRead(), and
+//  regReadMany()/regBatch() over a configuration dump, at 1, 2, and 15 MHz SCLK with the measured
+//  stall policy.
+//
+//  For the calls that record lastTransfer(), its frame and byte counts must match the simulator's.
+//  The tool exits non-zero if they differ, if any stall violation is seen, or if a single register
+//  read or write takes other than the expected frames.
+//
+//  Build from this directory:
+//
+//    g++ -O2 -I../.. -o adis16490_transfer_bench adis16490_transfer_bench.cpp ../../*.cpp
+//
+//  Permission is hereby granted, free of charge, to any person obtaining
+//  a copy of this software and associated documentation files (the
+//  "Software"), to deal in the Software without restriction, including
+//  without limitation the rights to use, copy, modify, merge, publish,
+//  distribute, sublicense, and/or sell copies of the Software, and to
+//  permit persons to whom the Software is furnished to do so, subject to
+//  the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+//  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+//  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+//  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ADIS16490.h"
+#include "ADIS16490_Sim.h"
+#include <stdio.h>
+
+// Calls averaged per measurement
+#define ITERATIONS 1000
+
+// Output period at DEC_RATE = 0 (us)
+#define OUTPUT_PERIOD_US (1e6 / 4250)
+
+// Page 2, 3, and 4 configuration registers, as in the Teensy benchmark example
+static const uint16_t configRegs[] = {
+  X_GYRO_SCALE, Y_GYRO_SCALE, Z_GYRO_SCALE, X_ACCL_SCALE, Y_ACCL_SCALE, Z_ACCL_SCALE,
+  XG_BIAS_LOW, XG_BIAS_HIGH, YG_BIAS_LOW, YG_BIAS_HIGH, ZG_BIAS_LOW, ZG_BIAS_HIGH,
+  XA_BIAS_LOW, XA_BIAS_HIGH, YA_BIAS_LOW, YA_BIAS_HIGH, ZA_BIAS_LOW, ZA_BIAS_HIGH,
+  USER_SCR_1, USER_SCR_2, USER_SCR_3, USER_SCR_4, FLSHCNT_LOW, FLSHCNT_HIGH,
+  GLOB_CMD, FNCTIO_CTRL, GPIO_CTRL, CONFIG, DEC_RATE, NULL_CNFG, SYNC_SCALE,
+  FILTR_BNK_0, FILTR_BNK_1, FIRM_REV, FIRM_DM, FIRM_Y, BOOT_REV,
+  CAL_SIGTR_LWR, CAL_SIGTR_UPR, CAL_DRVTN_LWR, CAL_DRVTN_UPR,
+  CODE_SIGTR_LWR, CODE_SIGTR_UPR, CODE_DRVTN_LWR, CODE_DRVTN_UPR, SERIAL_NUM};
+#define CONFIG_COUNT (sizeof(configRegs) / sizeof(configRegs[0]))
+
+static ADIS16490_Sample sample;
+static ADIS16490_Burst burst;
+static ADIS16490_HighRes highRes;
+static ADIS16490_Delta delta;
+static int16_t configData[CONFIG_COUNT];
+static ADIS16490_RegOp configOps[CONFIG_COUNT];
+
+static void readPage0(ADIS16490 &imu, int) { imu.regRead(PROD_ID); }
+static void readPages(ADIS16490 &imu, int i) { imu.regRead((i & 1) ? DEC_RATE : PROD_ID); }
+static void write(ADIS16490 &imu, int i) { imu.regWrite(USER_SCR_1, i); }
+static void sensor(ADIS16490 &imu, int) { imu.sensorRead(sample); }
+static void burstFrame(ADIS16490 &imu, int) { imu.burstRead(burst); }
+static void highResFrame(ADIS16490 &imu, int) { imu.highResRead(highRes); }
+static void deltaFrame(ADIS16490 &imu, int) { imu.deltaRead(delta); }
+static void configRead(ADIS16490 &imu, int) {
+  for (size_t i = 0; i < CONFIG_COUNT; i++)
+    imu.regRead(configRegs[i]);
+}
+static void configMany(ADIS16490 &imu, int) { imu.regReadMany(configRegs, configData, CONFIG_COUNT); }
+static void configBatch(ADIS16490 &imu, int) {
+  for (size_t i = 0; i < CONFIG_COUNT; i++) {
+    configOps[i].addr = configRegs[i];
+    configOps[i].flags = REG_OP_READ;
+  }
+  imu.regBatch(configOps, CONFIG_COUNT);
+}
+
+struct Call {
+  const char *name;
+  void (*run)(ADIS16490 &imu, int i);
+  bool transfer; // Records lastTransfer()
+  float frames;  // Expected frames per call, or 0 if not checked
+};
+
+static const Call calls[] = {
+  {"regRead(PROD_ID)", readPage0, false, 2},
+  {"regRead(page 0/3)", readPages, false, 3},
+  {"regWrite(USER_SCR_1)", write, false, 2},
+  {"sensorRead()", sensor, true, 0},
+  {"burstRead()", burstFrame, true, 0},
+  {"highResRead()", highResFrame, true, 0},
+  {"deltaRead()", deltaFrame, true, 0},
+  {"config, regRead()", configRead, false, 0},
+  {"config, regReadMany()", configMany, true, 0},
+  {"config, regBatch()", configBatch, false, 0},
+};
+
+static int failures = 0;
+
+// Runs one call ITERATIONS times and prints the per-call bus cost
+static void measure(ADIS16490_Sim &sim, ADIS16490 &imu, const Call &call) {
+  call.run(imu, 1); // Leave the page where the loop expects it
+  sim.resetStats();
+  uint64_t start = sim.nanos();
+  uint32_t mismatches = 0;
+  for (int i = 0; i < ITERATIONS; i++) {
+    ADIS16490_SimStats before = sim.stats();
+    call.run(imu, i);
+    const ADIS16490_Transfer &t = imu.lastTransfer();
+    uint32_t frames = sim.stats().frames - before.frames, bytes = sim.stats().bytes - before.bytes;
+    if (call.transfer && (t.frames != frames || t.bytes != bytes))
+      mismatches++;
+  }
+  double us = (double)(sim.nanos() - start) / 1000 / ITERATIONS;
+  const ADIS16490_SimStats &stats = sim.stats();
+  float frames = (float)stats.frames / ITERATIONS;
+  printf("%-24s %7.2f %7.2f %6.2f %7u %9.2f %7.1f%%\n", call.name, frames, (float)stats.bytes / ITERATIONS,
+         (float)stats.pageSwitches / ITERATIONS, stats.stallViolations, us, 100 * us / OUTPUT_PERIOD_US);
+  if (mismatches) {
+    printf("  FAIL: lastTransfer() differs from the simulator on %u calls\n", mismatches);
+    failures++;
+  }
+  if (stats.stallViolations) {
+    printf("  FAIL: stall violations\n");
+    failures++;
+  }
+  if (call.frames && frames != call.frames) {
+    printf("  FAIL: expected %.0f frames per call\n", call.frames);
+    failures++;
+  }
+}
+
+int main() {
+  static const uint32_t clocks[] = {1000000, 2000000, 15000000};
+  for (int c = 0; c < 3; c++) {
+    ADIS16490_Sim sim;
+    ADIS16490 imu(sim);
+    ADIS16490_ClockConfig clock = {clocks[c], clocks[c]};
+    imu.setClocks(clock);
+    printf("%s%u MHz SCLK\n", c ? "\n" : "", clocks[c] / 1000000);
+    printf("%-24s %7s %7s %6s %7s %9s %8s\n", "Call", "frames", "bytes", "pages", "stalls", "us/call",
+           "period");
+    for (size_t i = 0; i < sizeof(calls) / sizeof(calls[0]); i++)
+      measure(sim, imu, calls[i]);
+  }
+  printf("\n%s\n", failures ? "FAILED" : "All checks passed");
+  return failures ? 1 : 0;
+}